@@ -0,0 +1,138 @@
+#include "../Libraries/Forge/include/concurrentHashMap.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+#include <unistd.h>
+
+#define KEY_COUNT     (1 << 18)
+#define KEY_LENGTH    16
+#define LOOKUPS       (1 << 20)       // - - - per reader thread
+#define MAX_READERS   16
+
+typedef enum Guard { GUARD_MUTEX, GUARD_RWLOCK, GUARD_NONE } Guard;
+
+static char               keys[KEY_COUNT][KEY_LENGTH];
+static HashMap            plain;
+static pthread_mutex_t    mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t   rwlock  = PTHREAD_RWLOCK_INITIALIZER;
+static ConcurrentHashMap  concurrent;
+static volatile bool      writing;
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* reader(void* GUARD)
+{
+  Guard guard = (Guard)(u64)GUARD;
+  u64   seed  = (u64)pthread_self();
+  u64   found = 0;
+  for (u64 i = 0; i < LOOKUPS; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    char* key = keys[(seed >> 33) % KEY_COUNT];
+    switch (guard)
+    {
+      case GUARD_MUTEX:
+        pthread_mutex_lock(&mutex);
+        found += hashMapGet(&plain, key, KEY_LENGTH) != NULL;
+        pthread_mutex_unlock(&mutex);
+        break;
+      case GUARD_RWLOCK:
+        pthread_rwlock_rdlock(&rwlock);
+        found += hashMapGet(&plain, key, KEY_LENGTH) != NULL;
+        pthread_rwlock_unlock(&rwlock);
+        break;
+      case GUARD_NONE:
+        found += concurrentHashMapGet(&concurrent, key, KEY_LENGTH) != NULL;
+        break;
+    }
+  }
+  return (void*)found;
+}
+
+// - - - one writer keeps replacing values, the readers share the map with it
+static void* writer(void* GUARD)
+{
+  Guard guard = (Guard)(u64)GUARD;
+  for (u64 i = 0; __atomic_load_n(&writing, __ATOMIC_ACQUIRE); ++i)
+  {
+    char* key = keys[i % KEY_COUNT];
+    switch (guard)
+    {
+      case GUARD_MUTEX:
+        pthread_mutex_lock(&mutex);
+        hashMapInsert(&plain, key, KEY_LENGTH, (void*)(i + 1));
+        pthread_mutex_unlock(&mutex);
+        break;
+      case GUARD_RWLOCK:
+        pthread_rwlock_wrlock(&rwlock);
+        hashMapInsert(&plain, key, KEY_LENGTH, (void*)(i + 1));
+        pthread_rwlock_unlock(&rwlock);
+        break;
+      case GUARD_NONE:
+        concurrentHashMapInsert(&concurrent, key, KEY_LENGTH, (void*)(i + 1));
+        break;
+    }
+    if (i % 64 == 0) usleep(10);
+  }
+  return NULL;
+}
+
+// - - - million lookups a second over all readers
+static f64 run(Guard GUARD, int READERS, bool WRITER)
+{
+  pthread_t threads[MAX_READERS], background;
+  writing = WRITER;
+  if (WRITER) pthread_create(&background, NULL, writer, (void*)(u64)GUARD);
+
+  f64 start = now();
+  for (int i = 0; i < READERS; ++i) pthread_create(&threads[i], NULL, reader, (void*)(u64)GUARD);
+  for (int i = 0; i < READERS; ++i) pthread_join(threads[i], NULL);
+  f64 elapsed = now() - start;
+
+  __atomic_store_n(&writing, false, __ATOMIC_RELEASE);
+  if (WRITER) pthread_join(background, NULL);
+  return (f64)READERS * LOOKUPS / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+  u64 seed = 1;
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    for (u64 j = 0; j < KEY_LENGTH; ++j)
+    {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      keys[i][j] = 'a' + (seed >> 33) % 26;
+    }
+  }
+
+  createHashMap(&plain, KEY_COUNT, NULL, NULL, NULL, NULL);
+  createConcurrentHashMap(&concurrent, KEY_COUNT, NULL, NULL, NULL, NULL);
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    hashMapInsert(&plain, keys[i], KEY_LENGTH, (void*)(i + 1));
+    concurrentHashMapInsert(&concurrent, keys[i], KEY_LENGTH, (void*)(i + 1));
+  }
+
+  FORGE_LOG_INFO("- - - Reads, M lookups/s over all readers, %d keys, %ld CPUs - - -", KEY_COUNT, sysconf(_SC_NPROCESSORS_ONLN));
+  for (int writer = 0; writer < 2; ++writer)
+  {
+    FORGE_LOG_INFO("%s", writer ? "with one writer replacing values" : "read only");
+    FORGE_LOG_INFO("readers | HashMap + mutex | HashMap + rwlock | ConcurrentHashMap");
+    for (int readers = 1; readers <= MAX_READERS; readers *= 2)
+    {
+      f64 locked = run(GUARD_MUTEX,  readers, writer);
+      f64 shared = run(GUARD_RWLOCK, readers, writer);
+      f64 free   = run(GUARD_NONE,   readers, writer);
+      FORGE_LOG_INFO("%7d | %15.2f | %16.2f | %17.2f", readers, locked, shared, free);
+    }
+  }
+
+  destroyHashMap(&plain);
+  destroyConcurrentHashMap(&concurrent);
+  return 0;
+}
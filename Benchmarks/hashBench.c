@@ -0,0 +1,162 @@
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+
+#define HASH_BYTES      (1 << 28)       // - - - bytes hashed per key length for the throughput numbers
+#define KEY_COUNT       (1 << 20)
+#define TABLE_BITS      20
+#define AVALANCHE_KEYS  20000
+#define AVALANCHE_SIZE  16
+
+typedef unsigned long long (anyHash)(const char* KEY, unsigned long long SIZE);
+
+// - - - what the default hash used to be : 32 bit multiply by 31, stops at the first zero byte whatever KEY_SIZE says
+static unsigned long long legacy(const char* KEY, unsigned long long SIZE)
+{
+  unsigned int hash = 0;
+  while (*KEY) hash = (hash * 31) + *KEY++;
+  return hash;
+}
+
+static unsigned long long fnv(const char* KEY, unsigned long long SIZE)
+{
+  unsigned long long hash = 1469598103934665603ULL;
+  for (unsigned long long i = 0; i < SIZE; ++i) hash = (hash ^ (unsigned char)KEY[i]) * 1099511628211ULL;
+  return hash;
+}
+
+static unsigned long long wy(const char* KEY, unsigned long long SIZE)
+{
+  return hashMapHashBytes(KEY, SIZE, 0x1234567);
+}
+
+static const char* names[]  = { "legacy x31", "fnv-1a", "default" };
+static anyHash*    hashes[] = { legacy, fnv, wy };
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u64 next(u64* SEED)
+{
+  *SEED = *SEED * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *SEED >> 16;
+}
+
+// - - - nanoseconds per hash of a LENGTH byte key, the key changes every time so nothing gets hoisted
+static f64 benchSpeed(anyHash* HASH, u64 LENGTH)
+{
+  static char key[4097];
+  for (u64 i = 0; i < LENGTH; ++i) key[i] = 'a' + i % 26;
+  key[LENGTH] = 0;
+
+  u64 rounds = HASH_BYTES / LENGTH;
+  u64 sink   = 0;
+  f64 start  = now();
+  for (u64 i = 0; i < rounds; ++i)
+  {
+    key[0] = 'a' + (char)(sink & 15);
+    sink  += HASH(key, LENGTH);
+  }
+  f64 elapsed = now() - start;
+  if (sink == 42) FORGE_LOG_INFO("unlucky");
+  return elapsed / rounds * 1e9;
+}
+
+static int compareU64(const void* A, const void* B)
+{
+  u64 a = *(const u64*)A, b = *(const u64*)B;
+  return (a > b) - (a < b);
+}
+
+// - - - keys that landed in an already used bucket of a 2^TABLE_BITS table, ideal is what random placement gives
+static u64 bucketCollisions(anyHash* HASH, bool BINARY)
+{
+  static u64  buckets[KEY_COUNT];
+  char        key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    u64 length;
+    if (BINARY)
+    {
+      // - - - little endian integers, full of zero bytes, terminated for the legacy hash
+      memcpy(key, &i, sizeof(i));
+      key[8] = 0;
+      length = 8;
+    }
+    else length = (u64)snprintf(key, sizeof(key), "user:%llu", i);
+    buckets[i] = HASH(key, length) & ((1ULL << TABLE_BITS) - 1);
+  }
+
+  qsort(buckets, KEY_COUNT, sizeof(u64), compareU64);
+  u64 collisions = 0;
+  for (u64 i = 1; i < KEY_COUNT; ++i) collisions += buckets[i] == buckets[i - 1];
+  return collisions;
+}
+
+// - - - flips every input bit of random keys, the worst output bit's flip rate should stay close to 50 %
+static f64 worstAvalanche(anyHash* HASH)
+{
+  static u32 flips[AVALANCHE_SIZE * 8][64];
+  memset(flips, 0, sizeof(flips));
+
+  u64  seed = 99;
+  char key[AVALANCHE_SIZE + 1];
+  for (u64 k = 0; k < AVALANCHE_KEYS; ++k)
+  {
+    // - - - no zero bytes, so the legacy hash sees the whole key
+    for (u64 i = 0; i < AVALANCHE_SIZE; ++i) key[i] = (char)(1 + next(&seed) % 255);
+    key[AVALANCHE_SIZE] = 0;
+    u64 base = HASH(key, AVALANCHE_SIZE);
+
+    for (u64 bit = 0; bit < AVALANCHE_SIZE * 8; ++bit)
+    {
+      key[bit / 8] ^= (char)(1 << (bit % 8));
+      u64 changed = base ^ (key[bit / 8] ? HASH(key, AVALANCHE_SIZE) : base);
+      key[bit / 8] ^= (char)(1 << (bit % 8));
+      for (u64 out = 0; out < 64; ++out) flips[bit][out] += (changed >> out) & 1;
+    }
+  }
+
+  f64 worst = 0;
+  for (u64 bit = 0; bit < AVALANCHE_SIZE * 8; ++bit)
+  {
+    for (u64 out = 0; out < 64; ++out)
+    {
+      f64 bias = (f64)flips[bit][out] / AVALANCHE_KEYS - 0.5;
+      if (bias < 0) bias = -bias;
+      if (bias > worst) worst = bias;
+    }
+  }
+  return worst * 100.0;
+}
+
+int main(int argc, char *argv[])
+{
+  static const u64 lengths[] = { 4, 8, 16, 32, 64, 256, 4096 };
+  const int        hashCount = sizeof(hashes) / sizeof(hashes[0]);
+
+  FORGE_LOG_INFO("- - - Hash speed, ns per key (GB/s) - - -");
+  FORGE_LOG_INFO("  bytes | %20s | %20s | %20s", names[0], names[1], names[2]);
+  for (u64 l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+  {
+    f64 ns[3];
+    for (int h = 0; h < hashCount; ++h) ns[h] = benchSpeed(hashes[h], lengths[l]);
+    FORGE_LOG_INFO("%7llu | %9.1f (%6.2f) | %9.1f (%6.2f) | %9.1f (%6.2f)", lengths[l],
+                   ns[0], lengths[l] / ns[0], ns[1], lengths[l] / ns[1], ns[2], lengths[l] / ns[2]);
+  }
+
+  // - - - expected for random placement of n keys into m buckets : n - m (1 - (1 - 1/m)^n)
+  f64 m = (f64)(1ULL << TABLE_BITS), n = KEY_COUNT, p = 1.0;
+  for (u64 i = 0; i < KEY_COUNT; ++i) p *= 1.0 - 1.0 / m;
+  FORGE_LOG_INFO("- - - Quality : %d keys into %.0f buckets, ideal %.0f collisions - - -", KEY_COUNT, m, n - m * (1.0 - p));
+  FORGE_LOG_INFO("           | text key collisions | binary key collisions | worst avalanche bias");
+  for (int h = 0; h < hashCount; ++h)
+  {
+    FORGE_LOG_INFO("%10s | %19llu | %21llu | %18.2f %%", names[h], bucketCollisions(hashes[h], false), bucketCollisions(hashes[h], true), worstAvalanche(hashes[h]));
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+
+#define KEY_COUNT   (1 << 22)       // - - - a table of about 330 MB, far past any last level cache
+#define KEY_LENGTH  16
+#define LOOKUPS     (1 << 23)
+#define BATCH       256             // - - - keys a request looks up at once
+
+static char               keys[KEY_COUNT][KEY_LENGTH];
+static byteArray          pointers[KEY_COUNT];
+static unsigned long long sizes[KEY_COUNT];
+static void*              values[KEY_COUNT];
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// - - - the keys a batch of lookups asks for, in random order
+static void pickKeys(u64* SEED, byteArray* BATCH_KEYS, unsigned long long* BATCH_SIZES)
+{
+  for (u64 i = 0; i < BATCH; ++i)
+  {
+    *SEED          = *SEED * 6364136223846793005ULL + 1442695040888963407ULL;
+    BATCH_KEYS[i]  = keys[(*SEED >> 33) % KEY_COUNT];
+    BATCH_SIZES[i] = KEY_LENGTH;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  u64 seed = 1;
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    for (u64 j = 0; j < KEY_LENGTH; ++j)
+    {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      keys[i][j] = 'a' + (seed >> 33) % 26;
+    }
+    pointers[i] = keys[i];
+    sizes[i]    = KEY_LENGTH;
+    values[i]   = (void*)(i + 1);
+  }
+
+  // - - - inserting, both maps presized so only the inserts are timed
+  HashMap single, batched;
+  createHashMap(&single,  KEY_COUNT, NULL, NULL, NULL, NULL);
+  createHashMap(&batched, KEY_COUNT, NULL, NULL, NULL, NULL);
+
+  f64 start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) hashMapInsert(&single, keys[i], KEY_LENGTH, values[i]);
+  f64 insertSingle = (now() - start) / KEY_COUNT * 1e9;
+
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; i += BATCH) hashMapInsertBatch(&batched, pointers + i, sizes + i, values + i, BATCH);
+  f64 insertBatch = (now() - start) / KEY_COUNT * 1e9;
+  destroyHashMap(&single);
+
+  // - - - random lookups, BATCH keys per request
+  byteArray           batchKeys[BATCH];
+  unsigned long long  batchSizes[BATCH];
+  void*               batchValues[BATCH];
+  u64                 found = 0;
+
+  seed  = 7;
+  start = now();
+  for (u64 r = 0; r < LOOKUPS / BATCH; ++r)
+  {
+    pickKeys(&seed, batchKeys, batchSizes);
+    for (u64 i = 0; i < BATCH; ++i) found += hashMapGet(&batched, batchKeys[i], batchSizes[i]) != NULL;
+  }
+  f64 getSingle = (now() - start) / LOOKUPS * 1e9;
+
+  seed  = 7;
+  start = now();
+  for (u64 r = 0; r < LOOKUPS / BATCH; ++r)
+  {
+    pickKeys(&seed, batchKeys, batchSizes);
+    found += hashMapGetBatch(&batched, batchKeys, batchSizes, BATCH, batchValues);
+  }
+  f64 getBatch = (now() - start) / LOOKUPS * 1e9;
+  destroyHashMap(&batched);
+
+  FORGE_LOG_INFO("- - - HashMap batches : %d keys of %d bytes, %d keys per batch - - -", KEY_COUNT, KEY_LENGTH, BATCH);
+  FORGE_LOG_INFO("           | single calls | batch      | speedup");
+  FORGE_LOG_INFO("insert     | %9.1f ns | %7.1f ns | %.2fx", insertSingle, insertBatch, insertSingle / insertBatch);
+  FORGE_LOG_INFO("lookup     | %9.1f ns | %7.1f ns | %.2fx", getSingle, getBatch, getSingle / getBatch);
+  FORGE_LOG_INFO("found %llu of %d", found, 2 * LOOKUPS);
+  return 0;
+}
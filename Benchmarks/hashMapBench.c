@@ -0,0 +1,116 @@
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+
+#define KEY_COUNT   (1 << 20)
+#define KEY_LENGTH  16
+#define LOOKUPS     (1 << 22)
+#define FRAME_KEYS  1000
+#define FRAMES      2000
+
+static char keys[KEY_COUNT][KEY_LENGTH];
+static char misses[KEY_COUNT][KEY_LENGTH];
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// - - - fixed length keys such as ids or hashes, random so the table is walked in no particular order
+static void makeKeys()
+{
+  u64 seed = 1;
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    for (u64 j = 0; j < KEY_LENGTH; ++j)
+    {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      keys[i][j]   = 'a' + (seed >> 33) % 26;
+      misses[i][j] = 'A' + (seed >> 45) % 26;
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  makeKeys();
+
+  HashMap map;
+  createHashMap(&map, KEY_COUNT, NULL, NULL, NULL, NULL);
+
+  f64 start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) hashMapInsert(&map, keys[i], KEY_LENGTH, (void*)(i + 1));
+  f64 insert = (now() - start) / KEY_COUNT * 1e9;
+
+  u64 found = 0;
+  u64 seed  = 7;
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    found += hashMapGet(&map, keys[(seed >> 33) % KEY_COUNT], KEY_LENGTH) != NULL;
+  }
+  f64 hit = (now() - start) / LOOKUPS * 1e9;
+
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    found += hashMapGet(&map, misses[(seed >> 33) % KEY_COUNT], KEY_LENGTH) != NULL;
+  }
+  f64 miss = (now() - start) / LOOKUPS * 1e9;
+
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) hashMapRemove(&map, keys[i], KEY_LENGTH);
+  f64 removal = (now() - start) / KEY_COUNT * 1e9;
+
+  destroyHashMap(&map);
+
+  // - - - growing from the smallest table, the slowest single insert shows whether a resize stalls
+  createHashMap(&map, 1, NULL, NULL, NULL, NULL);
+  f64 slowest = 0;
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    f64 before = now();
+    hashMapInsert(&map, keys[i], KEY_LENGTH, (void*)(i + 1));
+    f64 took = now() - before;
+    if (took > slowest) slowest = took;
+  }
+  f64 growing = (now() - start) / KEY_COUNT * 1e9;
+  destroyHashMap(&map);
+
+  // - - - a map rebuilt every frame : destroyed and created again, or cleared and refilled in place
+  start = now();
+  for (u64 frame = 0; frame < FRAMES; ++frame)
+  {
+    createHashMap(&map, FRAME_KEYS, NULL, NULL, NULL, NULL);
+    for (u64 i = 0; i < FRAME_KEYS; ++i) hashMapInsert(&map, keys[i], KEY_LENGTH, (void*)(i + 1));
+    destroyHashMap(&map);
+  }
+  f64 rebuilt = (now() - start) / FRAMES * 1e6;
+
+  createHashMap(&map, FRAME_KEYS, NULL, NULL, NULL, NULL);
+  start = now();
+  for (u64 frame = 0; frame < FRAMES; ++frame)
+  {
+    hashMapClear(&map);
+    for (u64 i = 0; i < FRAME_KEYS; ++i) hashMapInsert(&map, keys[i], KEY_LENGTH, (void*)(i + 1));
+  }
+  f64 cleared = (now() - start) / FRAMES * 1e6;
+  destroyHashMap(&map);
+
+  FORGE_LOG_INFO("- - - HashMap : %d keys of %d bytes, %d random lookups - - -", KEY_COUNT, KEY_LENGTH, LOOKUPS);
+  FORGE_LOG_INFO("insert                  | %8.1f ns", insert);
+  FORGE_LOG_INFO("lookup, present         | %8.1f ns", hit);
+  FORGE_LOG_INFO("lookup, missing         | %8.1f ns", miss);
+  FORGE_LOG_INFO("remove                  | %8.1f ns", removal);
+  FORGE_LOG_INFO("insert, growing         | %8.1f ns", growing);
+  FORGE_LOG_INFO("slowest growing insert  | %8.1f us", slowest * 1e6);
+  FORGE_LOG_INFO("frame of %d, rebuilt | %8.1f us", FRAME_KEYS, rebuilt);
+  FORGE_LOG_INFO("frame of %d, cleared | %8.1f us", FRAME_KEYS, cleared);
+  FORGE_LOG_INFO("found %llu of %d", found, LOOKUPS);
+  return 0;
+}
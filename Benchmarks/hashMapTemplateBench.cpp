@@ -0,0 +1,129 @@
+#include "../Libraries/Forge/include/hashMap.hpp"
+#include "../Libraries/Forge/include/logger.h"
+#include <string>
+#include <string_view>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+
+#define KEY_COUNT   (1 << 20)
+#define KEY_LENGTH  24              // - - - past the small string buffer, so a std::string built for a lookup allocates
+#define LOOKUPS     (1 << 22)
+
+// - - - what a game or server keeps per key, the C map needs it allocated on its own
+struct Record
+{
+  u64 id;
+  u64 hits;
+  f64 score;
+};
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u64 next(u64* SEED)
+{
+  *SEED = *SEED * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *SEED >> 33;
+}
+
+int main(int argc, char *argv[])
+{
+  // - - - keys arrive as string_views into a request buffer, the way a parser hands them out
+  std::vector<char>             buffer(KEY_COUNT * KEY_LENGTH);
+  std::vector<std::string_view> keys(KEY_COUNT);
+  u64 seed = 1;
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    for (u64 j = 0; j < KEY_LENGTH; ++j) buffer[i * KEY_LENGTH + j] = 'a' + next(&seed) % 26;
+    keys[i] = std::string_view(&buffer[i * KEY_LENGTH], KEY_LENGTH);
+  }
+
+  f64 times[3][3];
+  u64 sum = 0;
+
+  // - - - the C map : hashing and compare through pointers, every value boxed
+  {
+    HashMap map;
+    createHashMap(&map, KEY_COUNT, NULL, NULL, NULL, NULL);
+
+    f64 start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) hashMapInsert(&map, (char*)keys[i].data(), KEY_LENGTH, new Record{ i, 0, 1.0 });
+    times[0][0] = (now() - start) / KEY_COUNT * 1e9;
+
+    seed  = 7;
+    start = now();
+    for (u64 i = 0; i < LOOKUPS; ++i)
+    {
+      std::string_view key    = keys[next(&seed) % KEY_COUNT];
+      Record*          record = (Record*)hashMapGet(&map, (char*)key.data(), key.size());
+      record->hits++;
+      sum += record->id;
+    }
+    times[0][1] = (now() - start) / LOOKUPS * 1e9;
+
+    start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) delete (Record*)hashMapRemove(&map, (char*)keys[i].data(), KEY_LENGTH);
+    times[0][2] = (now() - start) / KEY_COUNT * 1e9;
+    destroyHashMap(&map);
+  }
+
+  // - - - std::unordered_map without a transparent hash builds a std::string for every lookup
+  {
+    std::unordered_map<std::string, Record> map;
+    map.reserve(KEY_COUNT);
+
+    f64 start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) map.emplace(std::string(keys[i]), Record{ i, 0, 1.0 });
+    times[1][0] = (now() - start) / KEY_COUNT * 1e9;
+
+    seed  = 7;
+    start = now();
+    for (u64 i = 0; i < LOOKUPS; ++i)
+    {
+      Record& record = map.find(std::string(keys[next(&seed) % KEY_COUNT]))->second;
+      record.hits++;
+      sum += record.id;
+    }
+    times[1][1] = (now() - start) / LOOKUPS * 1e9;
+
+    start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) map.erase(std::string(keys[i]));
+    times[1][2] = (now() - start) / KEY_COUNT * 1e9;
+  }
+
+  // - - - forge::HashMap : inlined hash and compare, records in the table, string_views looked up as they are
+  {
+    forge::HashMap<std::string, Record> map(KEY_COUNT);
+
+    f64 start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) map.emplace(keys[i], Record{ i, 0, 1.0 });
+    times[2][0] = (now() - start) / KEY_COUNT * 1e9;
+
+    seed  = 7;
+    start = now();
+    for (u64 i = 0; i < LOOKUPS; ++i)
+    {
+      Record* record = map.find(keys[next(&seed) % KEY_COUNT]);
+      record->hits++;
+      sum += record->id;
+    }
+    times[2][1] = (now() - start) / LOOKUPS * 1e9;
+
+    start = now();
+    for (u64 i = 0; i < KEY_COUNT; ++i) map.remove(keys[i]);
+    times[2][2] = (now() - start) / KEY_COUNT * 1e9;
+  }
+
+  FORGE_LOG_INFO("- - - %d byte string keys, %d entries, %d random lookups - - -", KEY_LENGTH, KEY_COUNT, LOOKUPS);
+  FORGE_LOG_INFO("        | HashMap     | unordered_map | forge::HashMap");
+  FORGE_LOG_INFO("insert  | %8.1f ns | %10.1f ns | %11.1f ns", times[0][0], times[1][0], times[2][0]);
+  FORGE_LOG_INFO("lookup  | %8.1f ns | %10.1f ns | %11.1f ns", times[0][1], times[1][1], times[2][1]);
+  FORGE_LOG_INFO("remove  | %8.1f ns | %10.1f ns | %11.1f ns", times[0][2], times[1][2], times[2][2]);
+  FORGE_LOG_INFO("checksum %llu", sum);
+  return 0;
+}
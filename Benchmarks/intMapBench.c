@@ -0,0 +1,83 @@
+#include "../Libraries/Forge/include/intMap.h"
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+
+#define KEY_COUNT   (1 << 20)
+#define LOOKUPS     (1 << 22)
+
+static u64 keys[KEY_COUNT];
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u64 next(u64* SEED)
+{
+  *SEED = *SEED * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *SEED >> 33;
+}
+
+int main(int argc, char *argv[])
+{
+  // - - - ids handed out in no particular order, looked up at random
+  u64 seed = 1;
+  for (u64 i = 0; i < KEY_COUNT; ++i) keys[i] = (next(&seed) << 20) | i;
+
+  f64     times[2][4];
+  u64     found = 0;
+  HashMap hashMap;
+  IntMap  intMap;
+  createHashMap(&hashMap, KEY_COUNT, NULL, NULL, NULL, NULL);
+  createIntMap(&intMap, KEY_COUNT, NULL);
+
+  f64 start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) hashMapInsert(&hashMap, (char*)&keys[i], sizeof(u64), (void*)(i + 1));
+  times[0][0] = (now() - start) / KEY_COUNT * 1e9;
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) intMapInsert(&intMap, keys[i], (void*)(i + 1));
+  times[1][0] = (now() - start) / KEY_COUNT * 1e9;
+
+  seed  = 7;
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i) found += hashMapGet(&hashMap, (char*)&keys[next(&seed) % KEY_COUNT], sizeof(u64)) != NULL;
+  times[0][1] = (now() - start) / LOOKUPS * 1e9;
+  seed  = 7;
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i) found += intMapGet(&intMap, keys[next(&seed) % KEY_COUNT]) != NULL;
+  times[1][1] = (now() - start) / LOOKUPS * 1e9;
+
+  // - - - misses : the low bits are never handed out past KEY_COUNT
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i)
+  {
+    u64 key = (next(&seed) << 21) | (1 << 20);
+    found  += hashMapGet(&hashMap, (char*)&key, sizeof(u64)) != NULL;
+  }
+  times[0][2] = (now() - start) / LOOKUPS * 1e9;
+  start = now();
+  for (u64 i = 0; i < LOOKUPS; ++i) found += intMapGet(&intMap, (next(&seed) << 21) | (1 << 20)) != NULL;
+  times[1][2] = (now() - start) / LOOKUPS * 1e9;
+
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) hashMapRemove(&hashMap, (char*)&keys[i], sizeof(u64));
+  times[0][3] = (now() - start) / KEY_COUNT * 1e9;
+  start = now();
+  for (u64 i = 0; i < KEY_COUNT; ++i) intMapRemove(&intMap, keys[i]);
+  times[1][3] = (now() - start) / KEY_COUNT * 1e9;
+
+  destroyHashMap(&hashMap);
+  destroyIntMap(&intMap);
+
+  FORGE_LOG_INFO("- - - u64 keys : %d keys, %d random lookups - - -", KEY_COUNT, LOOKUPS);
+  FORGE_LOG_INFO("                | HashMap     | IntMap");
+  FORGE_LOG_INFO("insert          | %8.1f ns | %8.1f ns", times[0][0], times[1][0]);
+  FORGE_LOG_INFO("lookup, present | %8.1f ns | %8.1f ns", times[0][1], times[1][1]);
+  FORGE_LOG_INFO("lookup, missing | %8.1f ns | %8.1f ns", times[0][2], times[1][2]);
+  FORGE_LOG_INFO("remove          | %8.1f ns | %8.1f ns", times[0][3], times[1][3]);
+  FORGE_LOG_INFO("found %llu of %d", found, 2 * LOOKUPS);
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include "../Libraries/Forge/include/threadPool.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+
+#define ELEMENTS      (1 << 23)
+#define COMPUTE_STEPS 256
+#define REPEATS       5
+
+static f32* a;
+static f32* b;
+static f32* c;
+
+static volatile f64 sink = 0.0;
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// - - - memory bound : a = b * s + c, three streams and almost no arithmetic
+static void triad(u64 BEGIN, u64 END, void* CONTEXT)
+{
+  for (u64 i = BEGIN; i < END; ++i) a[i] = b[i] * 3.0f + c[i];
+}
+
+// - - - compute bound : a long dependent chain per element, the arrays stay in cache
+static void iterate(u64 BEGIN, u64 END, void* CONTEXT)
+{
+  for (u64 i = BEGIN; i < END; ++i)
+  {
+    f32 x = b[i & 4095];
+    for (int step = 0; step < COMPUTE_STEPS; ++step) x = sqrtf(x * x + 1.0f) * 0.5f;
+    a[i & 4095] = x;
+  }
+}
+
+static void sumReduce(u64 BEGIN, u64 END, void* CONTEXT, void* PARTIAL)
+{
+  f64 sum = 0.0;
+  for (u64 i = BEGIN; i < END; ++i) sum += b[i];
+  *(f64*)PARTIAL += sum;
+}
+
+static void sumCombine(void* INTO, const void* FROM, void* CONTEXT)
+{
+  *(f64*)INTO += *(const f64*)FROM;
+}
+
+typedef struct Kernel
+{
+  const char* name;
+  void        (*body)(u64, u64, void*);
+  u64         count;
+} Kernel;
+
+static f64 best(f64 A, f64 B) { return A < B ? A : B; }
+
+static f64 benchSerial(Kernel* KERNEL)
+{
+  f64 fastest = 1e30;
+  for (int r = 0; r < REPEATS; ++r)
+  {
+    f64 start = now();
+    KERNEL->body(0, KERNEL->count, NULL);
+    fastest = best(fastest, now() - start);
+  }
+  return fastest;
+}
+
+static f64 benchParallel(Kernel* KERNEL)
+{
+  f64 fastest = 1e30;
+  for (int r = 0; r < REPEATS; ++r)
+  {
+    f64 start = now();
+    parallelFor(0, KERNEL->count, 0, KERNEL->body, NULL);
+    fastest = best(fastest, now() - start);
+  }
+  return fastest;
+}
+
+static f64 benchSerialSum()
+{
+  f64 fastest = 1e30;
+  for (int r = 0; r < REPEATS; ++r)
+  {
+    f64 sum   = 0.0;
+    f64 start = now();
+    sumReduce(0, ELEMENTS, NULL, &sum);
+    fastest = best(fastest, now() - start);
+    sink    = sum;
+  }
+  return fastest;
+}
+
+static f64 benchParallelSum()
+{
+  f64 fastest   = 1e30;
+  f64 identity  = 0.0;
+  for (int r = 0; r < REPEATS; ++r)
+  {
+    f64 sum;
+    f64 start = now();
+    parallelReduce(0, ELEMENTS, 0, &sum, &identity, sizeof(f64), sumReduce, sumCombine, NULL);
+    fastest = best(fastest, now() - start);
+    sink    = sum;
+  }
+  return fastest;
+}
+
+int main(int argc, char *argv[])
+{
+  i64 cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1) cores = 4;
+
+  a = (f32*)malloc(ELEMENTS * sizeof(f32));
+  b = (f32*)malloc(ELEMENTS * sizeof(f32));
+  c = (f32*)malloc(ELEMENTS * sizeof(f32));
+  for (u64 i = 0; i < ELEMENTS; ++i) { a[i] = 0.0f; b[i] = (f32)(i & 1023); c[i] = 1.0f; }
+
+  Kernel kernels[] =
+  {
+    { "triad (memory bound)",       triad,   ELEMENTS },
+    { "sqrt chain (compute bound)", iterate, ELEMENTS / 64 },
+  };
+  const int kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+
+  f64 serial[3];
+  for (int k = 0; k < kernelCount; ++k) serial[k] = benchSerial(&kernels[k]);
+  serial[kernelCount] = benchSerialSum();
+
+  FORGE_LOG_INFO("- - - parallelFor / parallelReduce vs serial loop (best of %d) - - -", REPEATS);
+  FORGE_LOG_INFO("threads | %-28s | %-28s | %-28s", kernels[0].name, kernels[1].name, "sum reduce (memory bound)");
+  FORGE_LOG_INFO("serial  | %20.2f ms      | %20.2f ms      | %20.2f ms", serial[0] * 1e3, serial[1] * 1e3, serial[2] * 1e3);
+
+  for (i64 threads = 1; ; threads *= 2)
+  {
+    if (threads > cores) threads = cores;
+    threadPoolInit((u32)threads);
+
+    f64 parallel[3];
+    for (int k = 0; k < kernelCount; ++k) parallel[k] = benchParallel(&kernels[k]);
+    parallel[kernelCount] = benchParallelSum();
+
+    FORGE_LOG_INFO("%7d | %11.2f ms (x%5.2f) | %11.2f ms (x%5.2f) | %11.2f ms (x%5.2f)", (int)threads,
+                   parallel[0] * 1e3, serial[0] / parallel[0],
+                   parallel[1] * 1e3, serial[1] / parallel[1],
+                   parallel[2] * 1e3, serial[2] / parallel[2]);
+
+    threadPoolDestroy();
+    if (threads == cores) break;
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include "../Libraries/Forge/include/ringQueue.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+#include <unistd.h>
+
+#define ITEM_COUNT      (1 << 21)
+#define QUEUE_CAPACITY  1024
+#define MAX_THREADS     64
+
+// - - - bounded ring behind one mutex and two condition variables, kept as the baseline
+typedef struct MutexQueue
+{
+  Lock        lock;
+  Conditional notFull;
+  Conditional notEmpty;
+  u64         items[QUEUE_CAPACITY];
+  u64         head;
+  u64         tail;
+} MutexQueue;
+
+static void mutexQueueInit(MutexQueue* QUEUE)
+{
+  pthread_mutex_init(&QUEUE->lock,     NULL);
+  pthread_cond_init (&QUEUE->notFull,  NULL);
+  pthread_cond_init (&QUEUE->notEmpty, NULL);
+  QUEUE->head = 0;
+  QUEUE->tail = 0;
+}
+
+static void mutexQueueDestroy(MutexQueue* QUEUE)
+{
+  pthread_mutex_destroy(&QUEUE->lock);
+  pthread_cond_destroy (&QUEUE->notFull);
+  pthread_cond_destroy (&QUEUE->notEmpty);
+}
+
+static void mutexQueuePush(MutexQueue* QUEUE, u64 VALUE)
+{
+  pthread_mutex_lock(&QUEUE->lock);
+  while (QUEUE->head - QUEUE->tail == QUEUE_CAPACITY) pthread_cond_wait(&QUEUE->notFull, &QUEUE->lock);
+  QUEUE->items[QUEUE->head++ % QUEUE_CAPACITY] = VALUE;
+  pthread_cond_signal(&QUEUE->notEmpty);
+  pthread_mutex_unlock(&QUEUE->lock);
+}
+
+static u64 mutexQueuePop(MutexQueue* QUEUE)
+{
+  pthread_mutex_lock(&QUEUE->lock);
+  while (QUEUE->head == QUEUE->tail) pthread_cond_wait(&QUEUE->notEmpty, &QUEUE->lock);
+  u64 value = QUEUE->items[QUEUE->tail++ % QUEUE_CAPACITY];
+  pthread_cond_signal(&QUEUE->notFull);
+  pthread_mutex_unlock(&QUEUE->lock);
+  return value;
+}
+
+// - - - both queues behind the same calls
+typedef struct AnyQueue
+{
+  bool        ring;
+  RingQueue   forge;
+  MutexQueue  baseline;
+  u64         perThread;
+  volatile u64 sink;
+} AnyQueue;
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* producer(void* ARG)
+{
+  AnyQueue* queue = (AnyQueue*)ARG;
+  for (u64 i = 0; i < queue->perThread; ++i)
+  {
+    if (queue->ring) ringQueuePush(&queue->forge, &i);
+    else             mutexQueuePush(&queue->baseline, i);
+  }
+  return NULL;
+}
+
+static void* consumer(void* ARG)
+{
+  AnyQueue* queue = (AnyQueue*)ARG;
+  u64 sum = 0;
+  for (u64 i = 0; i < queue->perThread; ++i)
+  {
+    u64 value;
+    if (queue->ring) ringQueuePop(&queue->forge, &value);
+    else             value = mutexQueuePop(&queue->baseline);
+    sum += value;
+  }
+  __atomic_add_fetch(&queue->sink, sum, __ATOMIC_RELAXED);
+  return NULL;
+}
+
+// - - - THREADS producers and THREADS consumers moving ITEM_COUNT elements, reports elements per second
+static f64 benchThroughput(bool RING, u32 THREADS)
+{
+  static AnyQueue queue;
+  queue.ring      = RING;
+  queue.perThread = ITEM_COUNT / THREADS;
+  queue.sink      = 0;
+  if (RING) createRingQueue(&queue.forge, QUEUE_CAPACITY, sizeof(u64));
+  else      mutexQueueInit(&queue.baseline);
+
+  pthread_t producers[MAX_THREADS];
+  pthread_t consumers[MAX_THREADS];
+  f64 start = now();
+  for (u32 i = 0; i < THREADS; ++i) pthread_create(&consumers[i], NULL, consumer, &queue);
+  for (u32 i = 0; i < THREADS; ++i) pthread_create(&producers[i], NULL, producer, &queue);
+  for (u32 i = 0; i < THREADS; ++i) pthread_join(producers[i], NULL);
+  for (u32 i = 0; i < THREADS; ++i) pthread_join(consumers[i], NULL);
+  f64 elapsed = now() - start;
+
+  if (RING) destroyRingQueue(&queue.forge);
+  else      mutexQueueDestroy(&queue.baseline);
+  return queue.perThread * THREADS / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+  FORGE_LOG_INFO("- - - Bounded queue of %d u64 : mutex + condition variables vs ring queue (%d elements) - - -", QUEUE_CAPACITY, ITEM_COUNT);
+  FORGE_LOG_INFO("producers + consumers | %17s | %17s", "mutex", "ring");
+  for (u32 threads = 1; threads <= MAX_THREADS; threads *= 2)
+  {
+    FORGE_LOG_INFO("%9u + %-9u | %11.0f ops/s | %11.0f ops/s", threads, threads, benchThroughput(false, threads), benchThroughput(true, threads));
+  }
+  return 0;
+}
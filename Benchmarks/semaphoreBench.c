@@ -0,0 +1,178 @@
+#include "../Libraries/Forge/include/threadPool.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+#include <unistd.h>
+
+#define UNCONTENDED_OPS (1 << 22)
+#define PING_PONGS      (1 << 16)
+#define STREAM_OPS      (1 << 20)
+
+// - - - the mutex and condition variable semaphore the thread pool used before, kept as the baseline
+typedef struct PthreadSemaphore
+{
+  Lock        lock;
+  Conditional conditional;
+  u32         value;
+} PthreadSemaphore;
+
+static void pthreadSemaphoreInit(PthreadSemaphore* SEM)
+{
+  pthread_mutex_init(&SEM->lock,        NULL);
+  pthread_cond_init (&SEM->conditional, NULL);
+  SEM->value = 0;
+}
+
+static void pthreadSemaphoreDestroy(PthreadSemaphore* SEM)
+{
+  pthread_mutex_destroy(&SEM->lock);
+  pthread_cond_destroy (&SEM->conditional);
+}
+
+static void pthreadSemaphoreWait(PthreadSemaphore* SEM)
+{
+  pthread_mutex_lock(&SEM->lock);
+  while (SEM->value == 0) pthread_cond_wait(&SEM->conditional, &SEM->lock);
+  SEM->value--;
+  pthread_mutex_unlock(&SEM->lock);
+}
+
+static void pthreadSemaphorePost(PthreadSemaphore* SEM)
+{
+  pthread_mutex_lock(&SEM->lock);
+  SEM->value++;
+  pthread_cond_signal(&SEM->conditional);
+  pthread_mutex_unlock(&SEM->lock);
+}
+
+// - - - both implementations behind the same calls
+typedef struct AnySemaphore
+{
+  bool              futex;
+  Semaphore         forge;
+  PthreadSemaphore  baseline;
+} AnySemaphore;
+
+static void anyInit(AnySemaphore* SEM, bool FUTEX)
+{
+  SEM->futex = FUTEX;
+  if (FUTEX) createSemaphore(&SEM->forge, 0);
+  else       pthreadSemaphoreInit(&SEM->baseline);
+}
+
+static void anyDestroy(AnySemaphore* SEM)
+{
+  if (SEM->futex) destroySemaphore(&SEM->forge);
+  else            pthreadSemaphoreDestroy(&SEM->baseline);
+}
+
+static void anyWait(AnySemaphore* SEM)
+{
+  if (SEM->futex) semaphoreWait(&SEM->forge);
+  else            pthreadSemaphoreWait(&SEM->baseline);
+}
+
+static void anyPost(AnySemaphore* SEM)
+{
+  if (SEM->futex) semaphorePost(&SEM->forge);
+  else            pthreadSemaphorePost(&SEM->baseline);
+}
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// - - - post then wait on one thread, the path a busy pool takes on every push
+static f64 benchUncontended(bool FUTEX)
+{
+  AnySemaphore sem;
+  anyInit(&sem, FUTEX);
+
+  f64 start = now();
+  for (u32 i = 0; i < UNCONTENDED_OPS; ++i)
+  {
+    anyPost(&sem);
+    anyWait(&sem);
+  }
+  f64 elapsed = now() - start;
+
+  anyDestroy(&sem);
+  return elapsed / UNCONTENDED_OPS * 1e9;
+}
+
+typedef struct PingPong
+{
+  AnySemaphore ping;
+  AnySemaphore pong;
+} PingPong;
+
+static void* ponger(void* ARG)
+{
+  PingPong* pair = (PingPong*)ARG;
+  for (u32 i = 0; i < PING_PONGS; ++i)
+  {
+    anyWait(&pair->ping);
+    anyPost(&pair->pong);
+  }
+  return NULL;
+}
+
+// - - - one way wake up latency : half of a post -> wake -> post back -> wake round trip
+static f64 benchWakeLatency(bool FUTEX)
+{
+  PingPong pair;
+  anyInit(&pair.ping, FUTEX);
+  anyInit(&pair.pong, FUTEX);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, ponger, &pair);
+
+  f64 start = now();
+  for (u32 i = 0; i < PING_PONGS; ++i)
+  {
+    anyPost(&pair.ping);
+    anyWait(&pair.pong);
+  }
+  f64 elapsed = now() - start;
+
+  pthread_join(thread, NULL);
+  anyDestroy(&pair.ping);
+  anyDestroy(&pair.pong);
+  return elapsed / PING_PONGS / 2 * 1e9;
+}
+
+static void* consumer(void* ARG)
+{
+  AnySemaphore* sem = (AnySemaphore*)ARG;
+  for (u32 i = 0; i < STREAM_OPS; ++i) anyWait(sem);
+  return NULL;
+}
+
+// - - - one thread posting as fast as it can, another taking
+static f64 benchThroughput(bool FUTEX)
+{
+  AnySemaphore sem;
+  anyInit(&sem, FUTEX);
+
+  pthread_t thread;
+  f64 start = now();
+  pthread_create(&thread, NULL, consumer, &sem);
+  for (u32 i = 0; i < STREAM_OPS; ++i) anyPost(&sem);
+  pthread_join(thread, NULL);
+  f64 elapsed = now() - start;
+
+  anyDestroy(&sem);
+  return STREAM_OPS / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+  FORGE_LOG_INFO("- - - Semaphore : pthread mutex + condition variable vs futex spin then park - - -");
+  FORGE_LOG_INFO("                          | %16s | %16s", "pthread", "futex");
+  FORGE_LOG_INFO("uncontended post + wait   | %13.1f ns | %13.1f ns", benchUncontended(false), benchUncontended(true));
+  FORGE_LOG_INFO("wake up latency           | %13.1f ns | %13.1f ns", benchWakeLatency(false), benchWakeLatency(true));
+  FORGE_LOG_INFO("post -> wait throughput   | %11.0f ops/s | %11.0f ops/s", benchThroughput(false), benchThroughput(true));
+  return 0;
+}
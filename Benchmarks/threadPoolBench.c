@@ -0,0 +1,179 @@
+#include "../Libraries/Forge/include/threadPool.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <time.h>
+#include <unistd.h>
+
+#define TASK_COUNT  (1 << 20)
+#define FAN_OUT     256
+#define BLOCKING_COUNT 2048
+#define TIMER_COUNT    100000
+
+static volatile u64 sink = 0;
+
+static f64 now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void tinyTask(void* ARG)
+{
+  // - - - a few hundred nanoseconds of work, small enough that scheduling overhead dominates
+  u64 x = (u64)ARG;
+  for (int i = 0; i < 64; ++i) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+  __atomic_add_fetch(&sink, x & 1, __ATOMIC_RELAXED);
+}
+
+// - - - stands in for a blocking read, the thread sleeps and the core idles
+static void blockingTask(void* ARG)
+{
+  usleep(1000);
+}
+
+static void spawner(void* ARG)
+{
+  for (u64 i = 0; i < FAN_OUT; ++i) threadPoolTaskPush(tinyTask, (void*)i);
+}
+
+static f64 benchExternal(u32 THREADS)
+{
+  threadPoolInit(THREADS);
+  f64 start = now();
+  for (u64 i = 0; i < TASK_COUNT; ++i) threadPoolTaskPush(tinyTask, (void*)i);
+  threadPoolWaitToFinish();
+  f64 elapsed = now() - start;
+  threadPoolDestroy();
+  return TASK_COUNT / elapsed;
+}
+
+// - - - external push again with every task timed, the difference is the telemetry overhead
+static f64 benchTelemetry(u32 THREADS)
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { THREADS, 0, "bench", THREAD_POOL_PIN_NONE, NULL, 0, true };
+  createThreadPool(&pool, &config);
+  f64 start = now();
+  for (u64 i = 0; i < TASK_COUNT; ++i) threadPoolPush(&pool, tinyTask, (void*)i);
+  threadPoolWait(&pool);
+  f64 elapsed = now() - start;
+
+  ThreadPoolStats stats = threadPoolStatsSnapshot(&pool);
+  FORGE_LOG_INFO("%d threads : queue wait p50 %llu ns p99 %llu ns, run time p50 %llu ns p99 %llu ns, %llu steals", THREADS,
+                 threadPoolHistogramPercentile(&stats.workers.queueWait, 50.0), threadPoolHistogramPercentile(&stats.workers.queueWait, 99.0),
+                 threadPoolHistogramPercentile(&stats.workers.runTime,   50.0), threadPoolHistogramPercentile(&stats.workers.runTime,   99.0),
+                 stats.workers.steals);
+  destroyThreadPool(&pool);
+  return TASK_COUNT / elapsed;
+}
+
+static f64 benchBatch(u32 THREADS)
+{
+  static void (*functions[FAN_OUT])(void*);
+  static void*  arguments[FAN_OUT];
+  for (u64 i = 0; i < FAN_OUT; ++i)
+  {
+    functions[i] = tinyTask;
+    arguments[i] = (void*)i;
+  }
+
+  threadPoolInit(THREADS);
+  f64 start = now();
+  for (u64 i = 0; i < TASK_COUNT / FAN_OUT; ++i) threadPoolTaskPushBatch(functions, arguments, FAN_OUT);
+  threadPoolWaitToFinish();
+  f64 elapsed = now() - start;
+  threadPoolDestroy();
+  return TASK_COUNT / elapsed;
+}
+
+static f64 benchFanOut(u32 THREADS)
+{
+  threadPoolInit(THREADS);
+  f64 start = now();
+  for (u64 i = 0; i < TASK_COUNT / FAN_OUT; ++i) threadPoolTaskPush(spawner, NULL);
+  threadPoolWaitToFinish();
+  f64 elapsed = now() - start;
+  threadPoolDestroy();
+  return (TASK_COUNT + TASK_COUNT / FAN_OUT) / elapsed;
+}
+
+// - - - blocking tasks on a pool sized for the cores, fixed or allowed to grow to MAX_THREADS
+static f64 benchBlocking(u32 THREADS, u32 MAX_THREADS)
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { THREADS, 0, "bench", THREAD_POOL_PIN_NONE, NULL, 0, false, MAX_THREADS };
+  createThreadPool(&pool, &config);
+  f64 start = now();
+  for (u64 i = 0; i < BLOCKING_COUNT; ++i) threadPoolPush(&pool, blockingTask, NULL);
+  threadPoolWait(&pool);
+  f64 elapsed = now() - start;
+  destroyThreadPool(&pool);
+  return BLOCKING_COUNT / elapsed;
+}
+
+static void noop(void* ARG) {}
+
+// - - - schedule then cancel a crowd of timers spread over ten seconds, reports nanoseconds per call
+static void benchTimers(f64* SCHEDULE, f64* CANCEL)
+{
+  static Timer timers[TIMER_COUNT];
+  memset(timers, 0, sizeof(timers));
+  threadPoolInit(1);
+
+  u64 seed  = 1;
+  f64 start = now();
+  for (u64 i = 0; i < TIMER_COUNT; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    threadPoolTaskSchedule(&timers[i], noop, NULL, (seed >> 33) % 10000000000ULL);
+  }
+  *SCHEDULE = (now() - start) / TIMER_COUNT * 1e9;
+
+  start = now();
+  for (u64 i = 0; i < TIMER_COUNT; ++i) threadPoolCancelTimer(&timers[i]);
+  *CANCEL = (now() - start) / TIMER_COUNT * 1e9;
+  threadPoolDestroy();
+}
+
+int main(int argc, char *argv[])
+{
+  i64 cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1) cores = 4;
+
+  f64 externalRates[16];
+  f64 batchRates[16];
+  f64 telemetryRates[16];
+  f64 fanOutRates[16];
+  u32 threadCounts[16];
+  int runs = 0;
+
+  for (i64 threads = 1; runs < 16; threads *= 2)
+  {
+    if (threads > cores) threads = cores;
+    threadCounts[runs]  = (u32)threads;
+    externalRates[runs] = benchExternal((u32)threads);
+    batchRates[runs]    = benchBatch((u32)threads);
+    telemetryRates[runs] = benchTelemetry((u32)threads);
+    fanOutRates[runs]   = benchFanOut((u32)threads);
+    runs++;
+    if (threads == cores) break;
+  }
+
+  FORGE_LOG_INFO("- - - Thread Pool Throughput (%d tasks) - - -", TASK_COUNT);
+  FORGE_LOG_INFO("threads | external push (tasks/s) | with telemetry (tasks/s) | batches of %d (tasks/s) | pushed from tasks (tasks/s)", FAN_OUT);
+  for (int i = 0; i < runs; ++i)
+  {
+    FORGE_LOG_INFO("%7d | %23.0f | %24.0f | %24.0f | %27.0f", threadCounts[i], externalRates[i], telemetryRates[i], batchRates[i], fanOutRates[i]);
+  }
+
+  FORGE_LOG_INFO("- - - %d tasks sleeping 1 ms each, %d threads - - -", BLOCKING_COUNT, (int)cores);
+  FORGE_LOG_INFO("fixed                   | %11.0f tasks/s", benchBlocking((u32)cores, 0));
+  FORGE_LOG_INFO("elastic up to %3d       | %11.0f tasks/s", (int)cores * 16, benchBlocking((u32)cores, (u32)cores * 16));
+
+  f64 schedule, cancel;
+  benchTimers(&schedule, &cancel);
+  FORGE_LOG_INFO("- - - %d pending timers - - -", TIMER_COUNT);
+  FORGE_LOG_INFO("schedule                | %11.1f ns", schedule);
+  FORGE_LOG_INFO("cancel                  | %11.1f ns", cancel);
+  return 0;
+}
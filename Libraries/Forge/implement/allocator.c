@@ -0,0 +1,177 @@
+#include "../include/allocator.h"
+#include "../include/asserts.h"
+#include "../include/logger.h"
+
+#define ARENA_ALIGNMENT 16
+
+// - - - Heap - - -
+
+static void* heapAllocate(void* CONTEXT, u64 SIZE)
+{
+  return malloc(SIZE);
+}
+
+static void heapDeallocate(void* CONTEXT, void* MEMORY, u64 SIZE)
+{
+  free(MEMORY);
+}
+
+static void* heapReallocate(void* CONTEXT, void* MEMORY, u64 OLD_SIZE, u64 NEW_SIZE)
+{
+  return realloc(MEMORY, NEW_SIZE);
+}
+
+void createHeapAllocator(ForgeAllocator* ALLOCATOR)
+{
+  FORGE_ASSERT_MESSAGE(ALLOCATOR != NULL, "[ALLOCATOR] : Cannot initialize a NULL allocator");
+
+  ALLOCATOR->allocate   = heapAllocate;
+  ALLOCATOR->deallocate = heapDeallocate;
+  ALLOCATOR->reallocate = heapReallocate;
+  ALLOCATOR->context    = NULL;
+}
+
+// - - - Functions - - -
+
+typedef struct FunctionPair
+{
+  void*                 (*allocate)   (unsigned long SIZE);
+  void                  (*deallocate) (void* MEMORY);
+  struct FunctionPair*  next;
+} FunctionPair;
+
+// - - - every pair handed out so far, never freed. Programs use a handful of them at most
+static FunctionPair* functionPairs = NULL;
+
+static void* functionAllocate(void* CONTEXT, u64 SIZE)
+{
+  return ((FunctionPair*)CONTEXT)->allocate(SIZE);
+}
+
+static void functionDeallocate(void* CONTEXT, void* MEMORY, u64 SIZE)
+{
+  ((FunctionPair*)CONTEXT)->deallocate(MEMORY);
+}
+
+// - - - the shared pair for these two functions, pushed without a lock. Two threads racing on a new pair may both
+// - - - push it, either copy works
+static FunctionPair* functionPairFind(void* (*MALLOC)(unsigned long SIZE), void (*FREE)(void* MEMORY))
+{
+  for (FunctionPair* pair = __atomic_load_n(&functionPairs, __ATOMIC_ACQUIRE); pair; pair = pair->next)
+  {
+    if (pair->allocate == MALLOC && pair->deallocate == FREE) return pair;
+  }
+
+  FunctionPair* pair = (FunctionPair*)malloc(sizeof(FunctionPair));
+  FORGE_ASSERT_MESSAGE(pair, "[ALLOCATOR] : Failed to allocate memory for a pair of allocation functions");
+  pair->allocate    = MALLOC;
+  pair->deallocate  = FREE;
+  pair->next        = __atomic_load_n(&functionPairs, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&functionPairs, &pair->next, pair, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+  return pair;
+}
+
+void createFunctionAllocator(ForgeAllocator* ALLOCATOR, void* (*MALLOC)(unsigned long SIZE), void (*FREE)(void* MEMORY))
+{
+  FORGE_ASSERT_MESSAGE(ALLOCATOR != NULL, "[ALLOCATOR] : Cannot initialize a NULL allocator");
+
+  if (MALLOC == NULL) MALLOC = malloc;
+  if (FREE   == NULL) FREE   = free;
+  if (MALLOC == malloc && FREE == free)
+  {
+    createHeapAllocator(ALLOCATOR);
+    return;
+  }
+
+  // - - - plain functions cannot reallocate, none of the containers built on them needs it
+  ALLOCATOR->allocate   = functionAllocate;
+  ALLOCATOR->deallocate = functionDeallocate;
+  ALLOCATOR->reallocate = NULL;
+  ALLOCATOR->context    = functionPairFind(MALLOC, FREE);
+}
+
+// - - - Arena - - -
+
+static void* arenaAllocate(void* CONTEXT, u64 SIZE)
+{
+  LinearAllocator*  arena   = (LinearAllocator*)CONTEXT;
+  u64               padding = -((u64)arena->memory + arena->allocated) & (ARENA_ALIGNMENT - 1);
+
+  u8* block = linearAllocatorAllocate(arena, padding + SIZE);
+  return block ? block + padding : NULL;
+}
+
+static void arenaDeallocate(void* CONTEXT, void* MEMORY, u64 SIZE)
+{
+}
+
+static void* arenaReallocate(void* CONTEXT, void* MEMORY, u64 OLD_SIZE, u64 NEW_SIZE)
+{
+  LinearAllocator* arena = (LinearAllocator*)CONTEXT;
+
+  // - - - the last block handed out can grow or shrink in place
+  if (MEMORY && (u8*)MEMORY + OLD_SIZE == (u8*)arena->memory + arena->allocated && (u8*)MEMORY - (u8*)arena->memory + NEW_SIZE <= arena->totalSize)
+  {
+    arena->allocated = (u8*)MEMORY - (u8*)arena->memory + NEW_SIZE;
+    return MEMORY;
+  }
+
+  void* block = arenaAllocate(CONTEXT, NEW_SIZE);
+  if (block && MEMORY) memcpy(block, MEMORY, OLD_SIZE < NEW_SIZE ? OLD_SIZE : NEW_SIZE);
+  return block;
+}
+
+void createArenaAllocator(ForgeAllocator* ALLOCATOR, LinearAllocator* ARENA)
+{
+  FORGE_ASSERT_MESSAGE(ALLOCATOR != NULL, "[ALLOCATOR] : Cannot initialize a NULL allocator");
+  FORGE_ASSERT_MESSAGE(ARENA     != NULL, "[ALLOCATOR] : Cannot allocate from a NULL LinearAllocator");
+
+  if (ARENA->resizeFactor != 0)
+  {
+    FORGE_LOG_WARNING("[ALLOCATOR] : The arena can resize, which moves every block the container holds");
+  }
+
+  ALLOCATOR->allocate   = arenaAllocate;
+  ALLOCATOR->deallocate = arenaDeallocate;
+  ALLOCATOR->reallocate = arenaReallocate;
+  ALLOCATOR->context    = ARENA;
+}
+
+// - - - Pool - - -
+
+static void* poolAllocate(void* CONTEXT, u64 SIZE)
+{
+  ObjectPool* pool = (ObjectPool*)CONTEXT;
+  if (SIZE > pool->objectSize)
+  {
+    FORGE_LOG_ERROR("[ALLOCATOR] : %llu bytes do not fit in objects of %llu bytes", SIZE, pool->objectSize);
+    return NULL;
+  }
+  return takeObject(pool);
+}
+
+static void poolDeallocate(void* CONTEXT, void* MEMORY, u64 SIZE)
+{
+  if (MEMORY) returnObject((ObjectPool*)CONTEXT, MEMORY);
+}
+
+static void* poolReallocate(void* CONTEXT, void* MEMORY, u64 OLD_SIZE, u64 NEW_SIZE)
+{
+  ObjectPool* pool = (ObjectPool*)CONTEXT;
+  if (MEMORY == NULL) return poolAllocate(CONTEXT, NEW_SIZE);
+  if (NEW_SIZE <= pool->objectSize) return MEMORY;
+
+  FORGE_LOG_ERROR("[ALLOCATOR] : %llu bytes do not fit in objects of %llu bytes", NEW_SIZE, pool->objectSize);
+  return NULL;
+}
+
+void createPoolAllocator(ForgeAllocator* ALLOCATOR, ObjectPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(ALLOCATOR != NULL, "[ALLOCATOR] : Cannot initialize a NULL allocator");
+  FORGE_ASSERT_MESSAGE(POOL      != NULL, "[ALLOCATOR] : Cannot allocate from a NULL ObjectPool");
+
+  ALLOCATOR->allocate   = poolAllocate;
+  ALLOCATOR->deallocate = poolDeallocate;
+  ALLOCATOR->reallocate = poolReallocate;
+  ALLOCATOR->context    = POOL;
+}
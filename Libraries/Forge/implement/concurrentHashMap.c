@@ -0,0 +1,442 @@
+#include "../include/concurrentHashMap.h"
+#include "../include/asserts.h"
+#include "../include/logger.h"
+#include <sys/random.h>
+#include <time.h>
+
+// - - - chains average one entry before the bucket array doubles
+#define MAX_CHAIN_LOAD    1
+
+// - - - allocations a thread retires between two tries at freeing them
+#define RECLAIM_BATCH     64
+
+typedef struct ConcurrentNode
+{
+  struct ConcurrentNode* volatile   next;
+  void* volatile                    value;
+  unsigned long long                hash;
+  unsigned long long                keySize;
+  char                              key[];      // - - - in the same allocation
+} ConcurrentNode;
+
+typedef struct ConcurrentTable
+{
+  unsigned long long                size;       // - - - buckets, a power of two and at least the stripe count
+  ConcurrentNode* volatile          buckets[];
+} ConcurrentTable;
+
+// - - - the chains and then the buckets
+static void freeTable(ConcurrentTable* TABLE, memoryDeallocate* FREE)
+{
+  for (unsigned long long i = 0; i < TABLE->size; ++i)
+  {
+    for (ConcurrentNode* node = TABLE->buckets[i], *next; node; node = next)
+    {
+      next = node->next;
+      FREE(node);
+    }
+  }
+  FREE(TABLE);
+}
+
+// - - - Epochs - - -
+
+// - - - unlinked but maybe still seen by a reader that started before
+typedef struct RetiredItem
+{
+  void*                             memory;
+  memoryDeallocate*                 deallocator;
+  unsigned long long                epoch;
+  bool                              table;      // - - - a whole outgrown table, its chains go with it
+} RetiredItem;
+
+// - - - one per thread that ever used a map, reused after the thread exits. What a thread retires stays in its own
+// - - - record, so writers never share a list, and a record taken over carries on with what its last thread left
+typedef struct EpochRecord
+{
+  volatile unsigned long long       state;      // - - - epoch << 1 | 1 while reading, 0 otherwise
+  volatile bool                     inUse;
+  struct EpochRecord*               next;
+  u8                                padding[64 - 2 * sizeof(unsigned long long) - sizeof(void*)];
+  RetiredItem*                      retired;    // - - - owner only, off the line other threads read the state from
+  unsigned long long                retiredCount;
+  unsigned long long                retiredCapacity;
+} EpochRecord;
+
+static volatile unsigned long long  globalEpoch     = 1;
+static EpochRecord* volatile        epochRecords    = NULL;
+static pthread_key_t                epochKey;
+static pthread_once_t               epochOnce       = PTHREAD_ONCE_INIT;
+static __thread EpochRecord*        localRecord     = NULL;
+
+static bool epochTryAdvance ();
+static void epochReclaim    (EpochRecord* RECORD);
+
+static void epochRelease(void* RECORD)
+{
+  EpochRecord* record = (EpochRecord*)RECORD;
+  __atomic_store_n(&record->state, 0,     __ATOMIC_RELEASE);
+
+  // - - - free what is already safe, the rest waits for the next thread to take the record
+  epochTryAdvance();
+  epochReclaim(record);
+  __atomic_store_n(&record->inUse, false, __ATOMIC_RELEASE);
+}
+
+static void epochKeyCreate()
+{
+  pthread_key_create(&epochKey, epochRelease);
+}
+
+static EpochRecord* epochRegister()
+{
+  pthread_once(&epochOnce, epochKeyCreate);
+
+  // - - - take over the record of a thread that exited, or add a new one
+  EpochRecord* record = __atomic_load_n(&epochRecords, __ATOMIC_ACQUIRE);
+  for (; record; record = record->next)
+  {
+    bool expected = false;
+    if (!__atomic_load_n(&record->inUse, __ATOMIC_RELAXED) && __atomic_compare_exchange_n(&record->inUse, &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) break;
+  }
+
+  if (record == NULL)
+  {
+    if (posix_memalign((void**)&record, 64, sizeof(EpochRecord)) != 0)
+    {
+      FORGE_LOG_FATAL("[CONCURRENT HASH MAP] : Failed to allocate an epoch record");
+      abort();
+    }
+    record->state           = 0;
+    record->inUse           = true;
+    record->retired         = NULL;
+    record->retiredCount    = 0;
+    record->retiredCapacity = 0;
+    record->next  = __atomic_load_n(&epochRecords, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&epochRecords, &record->next, record, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+
+  localRecord = record;
+  pthread_setspecific(epochKey, record);
+  return record;
+}
+
+// - - - everything loaded after this is protected until epochExit
+static inline EpochRecord* epochEnter()
+{
+  EpochRecord* record = localRecord;
+  if (record == NULL) record = epochRegister();
+
+  __atomic_store_n(&record->state, (__atomic_load_n(&globalEpoch, __ATOMIC_RELAXED) << 1) | 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return record;
+}
+
+static inline void epochExit(EpochRecord* RECORD)
+{
+  __atomic_store_n(&RECORD->state, 0, __ATOMIC_RELEASE);
+}
+
+// - - - the epoch only moves on once every active reader has seen the current one. Any thread may try, the
+// - - - compare exchange lets one of them move it from the epoch they all checked
+static bool epochTryAdvance()
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  unsigned long long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_RELAXED);
+
+  for (EpochRecord* record = __atomic_load_n(&epochRecords, __ATOMIC_ACQUIRE); record; record = record->next)
+  {
+    unsigned long long state = __atomic_load_n(&record->state, __ATOMIC_ACQUIRE);
+    if ((state & 1) && (state >> 1) != epoch) return false;
+  }
+
+  return __atomic_compare_exchange_n(&globalEpoch, &epoch, epoch + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+// - - - caller owns RECORD. Two advances after retiring, no reader from back then is left
+static void epochReclaim(EpochRecord* RECORD)
+{
+  unsigned long long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_ACQUIRE);
+  RetiredItem*       items = RECORD->retired;
+
+  unsigned long long kept = 0;
+  for (unsigned long long i = 0; i < RECORD->retiredCount; ++i)
+  {
+    if (items[i].epoch + 2 > epoch) items[kept++] = items[i];
+    else if (items[i].table)        freeTable((ConcurrentTable*)items[i].memory, items[i].deallocator);
+    else                            items[i].deallocator(items[i].memory);
+  }
+  RECORD->retiredCount = kept;
+}
+
+// - - - TABLE retires an outgrown table with all of its chains as a single item
+static void epochRetire(void* MEMORY, memoryDeallocate* FREE, bool TABLE)
+{
+  EpochRecord* record = localRecord;
+  if (record == NULL) record = epochRegister();
+
+  if (record->retiredCount == record->retiredCapacity)
+  {
+    unsigned long long  capacity  = record->retiredCapacity ? record->retiredCapacity * 2 : RECLAIM_BATCH * 2;
+    RetiredItem*        grown     = realloc(record->retired, capacity * sizeof(RetiredItem));
+    if (grown == NULL)
+    {
+      FORGE_LOG_FATAL("[CONCURRENT HASH MAP] : Failed to grow the retired list");
+      abort();
+    }
+    record->retired         = grown;
+    record->retiredCapacity = capacity;
+  }
+
+  RetiredItem* item = &record->retired[record->retiredCount++];
+  item->memory      = MEMORY;
+  item->deallocator = FREE;
+  item->epoch       = __atomic_load_n(&globalEpoch, __ATOMIC_ACQUIRE);
+  item->table       = TABLE;
+
+  if (record->retiredCount % RECLAIM_BATCH == 0)
+  {
+    epochTryAdvance();
+    epochReclaim(record);
+  }
+}
+
+// - - - Helpers - - -
+
+static inline unsigned long long keyHash(ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+{
+  if (MAP->hash == NULL) return hashMapHashBytes(KEY, KEY_SIZE, MAP->seed);
+
+  // - - - user hashes get the same mixing HashMap gives them
+  unsigned long long hash = MAP->hash(KEY, KEY_SIZE) * 0x9E3779B97F4A7C15ULL;
+  return hash ^ (hash >> 32);
+}
+
+static inline ConcurrentStripe* stripeOf(ConcurrentHashMap* MAP, unsigned long long HASH)
+{
+  return &MAP->stripes[HASH & (CONCURRENT_HASH_MAP_STRIPES - 1)];
+}
+
+static ConcurrentTable* allocateTable(ConcurrentHashMap* MAP, unsigned long long SIZE)
+{
+  ConcurrentTable* table = MAP->allocator(sizeof(ConcurrentTable) + SIZE * sizeof(ConcurrentNode*));
+  if (table == NULL)
+  {
+    FORGE_LOG_ERROR("[CONCURRENT HASH MAP] : Memory Allocator failed for the buckets");
+    return NULL;
+  }
+  table->size = SIZE;
+  memset((void*)table->buckets, 0, SIZE * sizeof(ConcurrentNode*));
+  return table;
+}
+
+static ConcurrentNode* copyNode(ConcurrentHashMap* MAP, const char* KEY, unsigned long long KEY_SIZE, unsigned long long HASH, void* VALUE)
+{
+  ConcurrentNode* node = MAP->allocator(sizeof(ConcurrentNode) + KEY_SIZE);
+  if (node == NULL)
+  {
+    FORGE_LOG_ERROR("[CONCURRENT HASH MAP] : Memory Allocator failed for an entry");
+    return NULL;
+  }
+  node->next    = NULL;
+  node->value   = VALUE;
+  node->hash    = HASH;
+  node->keySize = KEY_SIZE;
+  memcpy(node->key, KEY, KEY_SIZE);
+  return node;
+}
+
+// - - - all stripes locked stop every writer while readers carry on in the old table. The entries are copied rather
+// - - - than relinked, a reader may be walking the old chains right now
+static void grow(ConcurrentHashMap* MAP, ConcurrentTable* OBSERVED)
+{
+  for (int i = 0; i < CONCURRENT_HASH_MAP_STRIPES; ++i) pthread_mutex_lock(&MAP->stripes[i].lock);
+
+  ConcurrentTable* old   = MAP->table;
+  ConcurrentTable* table = NULL;
+  if (old == OBSERVED && MAP->count > old->size * MAX_CHAIN_LOAD) table = allocateTable(MAP, old->size * 2);
+
+  bool copied = table != NULL;
+  for (unsigned long long i = 0; copied && i < old->size; ++i)
+  {
+    for (ConcurrentNode* node = old->buckets[i]; node; node = node->next)
+    {
+      ConcurrentNode* copy = copyNode(MAP, node->key, node->keySize, node->hash, node->value);
+      if (copy == NULL)
+      {
+        copied = false;
+        break;
+      }
+      ConcurrentNode* volatile* bucket = &table->buckets[node->hash & (table->size - 1)];
+      copy->next = *bucket;
+      *bucket    = copy;
+    }
+  }
+
+  // - - - out of memory half way, the map just stays at its size
+  if (table && !copied) freeTable(table, MAP->deallocator);
+  if (copied) __atomic_store_n(&MAP->table, table, __ATOMIC_RELEASE);
+
+  for (int i = CONCURRENT_HASH_MAP_STRIPES - 1; i >= 0; --i) pthread_mutex_unlock(&MAP->stripes[i].lock);
+  if (copied) epochRetire(old, MAP->deallocator, true);
+}
+
+// - - - ConcurrentHashMap - - -
+
+bool createConcurrentHashMap(ConcurrentHashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, memoryAllocate* MALLOC, memoryDeallocate* FREE, memoryCompare* MEMCMP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : Cannot initialize a NULL map");
+  FORGE_ASSERT_MESSAGE(SIZE > 0,    "[CONCURRENT HASH MAP] : The size of a map must be greater than 0");
+
+  // - - - NULL hash stays NULL, it means the seeded default hash
+  MAP->hash         = HASH_FUNCTION;
+  MAP->allocator    = MALLOC  ? MALLOC  : malloc;
+  MAP->deallocator  = FREE    ? FREE    : free;
+  MAP->compare      = MEMCMP  ? MEMCMP  : memcmp;
+  MAP->count        = 0;
+
+  if (getrandom(&MAP->seed, sizeof(MAP->seed), GRND_NONBLOCK) != sizeof(MAP->seed))
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    MAP->seed = hashMapHashBytes(&ts, sizeof(ts), (unsigned long long)MAP);
+  }
+
+  unsigned long long size = CONCURRENT_HASH_MAP_STRIPES;
+  while (size * MAX_CHAIN_LOAD < SIZE) size <<= 1;
+  MAP->table = allocateTable(MAP, size);
+  if (MAP->table == NULL) return false;
+
+  for (int i = 0; i < CONCURRENT_HASH_MAP_STRIPES; ++i) pthread_mutex_init(&MAP->stripes[i].lock, NULL);
+  return true;
+}
+
+bool destroyConcurrentHashMap(ConcurrentHashMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : Cannot destroy a NULL map");
+
+  freeTable(MAP->table, MAP->deallocator);
+  MAP->table = NULL;
+
+  for (int i = 0; i < CONCURRENT_HASH_MAP_STRIPES; ++i) pthread_mutex_destroy(&MAP->stripes[i].lock);
+
+  // - - - what this thread retired is freed as soon as readers of other maps allow, other threads free theirs
+  // - - - with their next batch or when they exit
+  EpochRecord* record = localRecord;
+  if (record)
+  {
+    epochTryAdvance();
+    epochTryAdvance();
+    epochReclaim(record);
+  }
+  return true;
+}
+
+bool concurrentHashMapInsert(ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE, void* VALUE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : Cannot insert into a NULL map");
+  FORGE_ASSERT_MESSAGE(KEY != NULL, "[CONCURRENT HASH MAP] : Cannot insert a NULL Key");
+  FORGE_ASSERT_MESSAGE(KEY_SIZE > 0,"[CONCURRENT HASH MAP] : Cannot insert with a non-positive KEY_SIZE");
+
+  if (VALUE == NULL)
+  {
+    FORGE_LOG_ERROR("[CONCURRENT HASH MAP] : Assiging a NULL value is the same as not assigning at all");
+    return false;
+  }
+
+  unsigned long long  hash   = keyHash(MAP, KEY, KEY_SIZE);
+  ConcurrentStripe*   stripe = stripeOf(MAP, hash);
+  pthread_mutex_lock(&stripe->lock);
+
+  // - - - growing needs every stripe, so the table cannot change while we hold one
+  ConcurrentTable*          table  = MAP->table;
+  ConcurrentNode* volatile* bucket = &table->buckets[hash & (table->size - 1)];
+  for (ConcurrentNode* node = *bucket; node; node = node->next)
+  {
+    if (node->hash == hash && node->keySize == KEY_SIZE && MAP->compare(node->key, KEY, KEY_SIZE) == 0)
+    {
+      __atomic_store_n(&node->value, VALUE, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&stripe->lock);
+      return true;
+    }
+  }
+
+  ConcurrentNode* node = copyNode(MAP, KEY, KEY_SIZE, hash, VALUE);
+  if (node == NULL)
+  {
+    pthread_mutex_unlock(&stripe->lock);
+    return false;
+  }
+  // - - - fully written before readers can reach it
+  node->next = *bucket;
+  __atomic_store_n(bucket, node, __ATOMIC_RELEASE);
+  unsigned long long count = __atomic_add_fetch(&MAP->count, 1, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&stripe->lock);
+
+  if (count > table->size * MAX_CHAIN_LOAD) grow(MAP, table);
+  return true;
+}
+
+void* concurrentHashMapGet(ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(KEY != NULL, "[CONCURRENT HASH MAP] : KEY cannot be NULL");
+
+  unsigned long long  hash   = keyHash(MAP, KEY, KEY_SIZE);
+  void*               value  = NULL;
+  EpochRecord*        record = epochEnter();
+
+  ConcurrentTable*    table  = __atomic_load_n(&MAP->table, __ATOMIC_ACQUIRE);
+  ConcurrentNode*     node   = __atomic_load_n(&table->buckets[hash & (table->size - 1)], __ATOMIC_ACQUIRE);
+  for (; node; node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))
+  {
+    if (node->hash == hash && node->keySize == KEY_SIZE && MAP->compare(node->key, KEY, KEY_SIZE) == 0)
+    {
+      value = __atomic_load_n(&node->value, __ATOMIC_ACQUIRE);
+      break;
+    }
+  }
+
+  epochExit(record);
+  return value;
+}
+
+void* concurrentHashMapRemove(ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(KEY != NULL, "[CONCURRENT HASH MAP] : KEY cannot be NULL");
+
+  unsigned long long  hash   = keyHash(MAP, KEY, KEY_SIZE);
+  ConcurrentStripe*   stripe = stripeOf(MAP, hash);
+  pthread_mutex_lock(&stripe->lock);
+
+  ConcurrentTable*          table = MAP->table;
+  ConcurrentNode* volatile* link  = &table->buckets[hash & (table->size - 1)];
+  ConcurrentNode*           node  = *link;
+  while (node && !(node->hash == hash && node->keySize == KEY_SIZE && MAP->compare(node->key, KEY, KEY_SIZE) == 0))
+  {
+    link = &node->next;
+    node = node->next;
+  }
+
+  if (node == NULL)
+  {
+    pthread_mutex_unlock(&stripe->lock);
+    return NULL;
+  }
+
+  // - - - readers already on the node still find the rest of the chain through its next
+  __atomic_store_n(link, node->next, __ATOMIC_RELEASE);
+  __atomic_sub_fetch(&MAP->count, 1, __ATOMIC_RELAXED);
+  void* value = node->value;
+  pthread_mutex_unlock(&stripe->lock);
+
+  epochRetire(node, MAP->deallocator, false);
+  return value;
+}
+
+unsigned long long concurrentHashMapCount(ConcurrentHashMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[CONCURRENT HASH MAP] : MAP cannot be NULL");
+  return __atomic_load_n(&MAP->count, __ATOMIC_RELAXED);
+}
@@ -1,39 +1,470 @@
 #include "../include/hashMap.h"
 #include "../include/logger.h"
 #include "../include/asserts.h"
+#include <time.h>
+#include <sys/random.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-static unsigned long long getIndex(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+// - - - control bytes. Full slots hold the top 7 bits of the hash, so the high bit alone tells used from free
+#define CONTROL_EMPTY     0x80
+#define CONTROL_DELETED   0xFE
+
+#define DEFAULT_MAX_LOAD  0.875f
+
+// - - - old slots moved to the new table per insert or remove while growing
+#define MIGRATE_SLOTS     (2 * HASH_MAP_GROUP_WIDTH)
+
+#define NOT_FOUND         ((unsigned long long)-1)
+
+// - - - Default hash - - -
+
+// - - - wyhash by Wang Yi, released into the public domain. A 64x64 -> 128 bit multiply folds 8 bytes of input
+// - - - into the state per multiply, which is fast and passes SMHasher
+static const unsigned long long wySecret[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+static inline void wyMultiply(unsigned long long* A, unsigned long long* B)
+{
+#if defined(__SIZEOF_INT128__)
+  __uint128_t product = (__uint128_t)*A * *B;
+  *A = (unsigned long long)product;
+  *B = (unsigned long long)(product >> 64);
+#else
+  unsigned long long aHigh = *A >> 32, aLow = (unsigned int)*A, bHigh = *B >> 32, bLow = (unsigned int)*B;
+  unsigned long long high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+  unsigned long long t    = low + (middle0 << 32);
+  unsigned long long carry = t < low;
+  unsigned long long lo   = t + (middle1 << 32);
+  carry += lo < t;
+  *A = lo;
+  *B = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+}
+
+static inline unsigned long long wyMix(unsigned long long A, unsigned long long B)
 {
-  return (MAP->hash(KEY, KEY_SIZE)) % MAP->size;
+  wyMultiply(&A, &B);
+  return A ^ B;
+}
+
+static inline unsigned long long wyRead8(const unsigned char* P) { unsigned long long v; memcpy(&v, P, 8); return v; }
+static inline unsigned long long wyRead4(const unsigned char* P) { unsigned int v;       memcpy(&v, P, 4); return v; }
+
+// - - - 1 to 3 bytes, the first, middle and last one cover them all
+static inline unsigned long long wyRead3(const unsigned char* P, unsigned long long K)
+{
+  return ((unsigned long long)P[0] << 16) | ((unsigned long long)P[K >> 1] << 8) | P[K - 1];
+}
+
+unsigned long long hashMapHashBytes(const void* KEY, unsigned long long KEY_SIZE, unsigned long long SEED)
+{
+  const unsigned char*  p   = (const unsigned char*)KEY;
+  unsigned long long    len = KEY_SIZE;
+  unsigned long long    a, b;
+
+  SEED ^= wyMix(SEED ^ wySecret[0], wySecret[1]);
+  if (len <= 16)
+  {
+    // - - - two overlapping reads from each end cover any length from 4 to 16
+    if (len >= 4)
+    {
+      a = (wyRead4(p) << 32)           | wyRead4(p + ((len >> 3) << 2));
+      b = (wyRead4(p + len - 4) << 32) | wyRead4(p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0)
+    {
+      a = wyRead3(p, len);
+      b = 0;
+    }
+    else a = b = 0;
+  }
+  else
+  {
+    unsigned long long i = len;
+    // - - - three independent lanes of 16 bytes keep the multipliers busy on long keys
+    if (i >= 48)
+    {
+      unsigned long long seed1 = SEED, seed2 = SEED;
+      do
+      {
+        SEED  = wyMix(wyRead8(p)      ^ wySecret[1], wyRead8(p + 8)  ^ SEED);
+        seed1 = wyMix(wyRead8(p + 16) ^ wySecret[2], wyRead8(p + 24) ^ seed1);
+        seed2 = wyMix(wyRead8(p + 32) ^ wySecret[3], wyRead8(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      SEED ^= seed1 ^ seed2;
+    }
+    while (i > 16)
+    {
+      SEED = wyMix(wyRead8(p) ^ wySecret[1], wyRead8(p + 8) ^ SEED);
+      i -= 16;
+      p += 16;
+    }
+    // - - - the last 16 bytes, overlapping what came before when the length is not a multiple of 16
+    a = wyRead8(p + i - 16);
+    b = wyRead8(p + i - 8);
+  }
+
+  a ^= wySecret[1];
+  b ^= SEED;
+  wyMultiply(&a, &b);
+  return wyMix(a ^ wySecret[0] ^ len, b ^ wySecret[1]);
 }
 
+// - - - the default hash function. Maps using it call hashMapHashBytes with their own seed instead
 static unsigned long long hash(const byteArray KEY, unsigned long long SIZE)
 {
-  const char* key = KEY;
-  unsigned int hash = 0;
-  while (*key) 
+  return hashMapHashBytes(KEY, SIZE, 0);
+}
+
+// - - - different for every map and every run of the program
+static unsigned long long newSeed(HashMap* MAP)
+{
+  static unsigned long long processSeed = 0;
+  static unsigned long long created     = 0;
+
+  unsigned long long base = __atomic_load_n(&processSeed, __ATOMIC_RELAXED);
+  if (base == 0)
   {
-    hash = (hash * 31) + *key++;
+    if (getrandom(&base, sizeof(base), GRND_NONBLOCK) != sizeof(base))
+    {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      base = wyMix((unsigned long long)ts.tv_nsec ^ wySecret[2], (unsigned long long)ts.tv_sec ^ (unsigned long long)&created);
+    }
+    base |= 1;
+    __atomic_store_n(&processSeed, base, __ATOMIC_RELAXED);
   }
-  return hash % SIZE;
+  return wyMix(base ^ (unsigned long long)MAP, __atomic_add_fetch(&created, 1, __ATOMIC_RELAXED) ^ wySecret[3]);
 }
 
-bool createHashMap(HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, memoryAllocate* MALLOC, memoryDeallocate* FREE, memoryCompare* MEMCMP)
+// - - - user hashes often only vary in a few bits, the probe needs all of them mixed into the top and the bottom
+static inline unsigned long long mixHash(unsigned long long HASH)
 {
-  FORGE_ASSERT_MESSAGE(MAP != NULL, "Cannot initialize a null HashMap");
-  FORGE_ASSERT_MESSAGE(SIZE > 0, "The size of a HashMap must be greater than 0");
+  HASH *= 0x9E3779B97F4A7C15ULL;
+  return HASH ^ (HASH >> 32);
+}
+
+static inline unsigned long long keyHash(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+{
+  if (MAP->hash == hash) return hashMapHashBytes(KEY, KEY_SIZE, MAP->seed);
+  return mixHash(MAP->hash(KEY, KEY_SIZE));
+}
+
+static inline unsigned char hashTag(unsigned long long HASH)
+{
+  return (unsigned char)(HASH >> 57);
+}
+
+// - - - where the entry's key bytes are, in the entry or behind its pointer
+static inline const char* entryKey(const MapEntry* ENTRY)
+{
+  return ENTRY->keySize <= HASH_MAP_INLINE_KEY ? ENTRY->inlineKey : ENTRY->key;
+}
+
+// - - - Memory - - -
+
+static inline void* mapAllocate(HashMap* MAP, unsigned long long SIZE)
+{
+  return MAP->memory.allocate(MAP->memory.context, SIZE);
+}
+
+static inline void mapDeallocate(HashMap* MAP, void* MEMORY, unsigned long long SIZE)
+{
+  MAP->memory.deallocate(MAP->memory.context, MEMORY, SIZE);
+}
+
+static inline unsigned long long tableBytes(unsigned long long SIZE)
+{
+  return SIZE + SIZE * sizeof(MapEntry);
+}
+
+// - - - Groups - - -
+
+// - - - bit i is set when control byte i of the group equals TAG
+static inline unsigned int groupMatch(const unsigned char* GROUP, unsigned char TAG)
+{
+#if defined(__SSE2__)
+  __m128i control = _mm_loadu_si128((const __m128i*)GROUP);
+  return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)TAG)));
+#else
+  unsigned int mask = 0;
+  for (int i = 0; i < HASH_MAP_GROUP_WIDTH; ++i) mask |= (unsigned int)(GROUP[i] == TAG) << i;
+  return mask;
+#endif
+}
+
+// - - - bit i is set when slot i of the group is empty or deleted
+static inline unsigned int groupMatchFree(const unsigned char* GROUP)
+{
+#if defined(__SSE2__)
+  return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)GROUP));
+#else
+  unsigned int mask = 0;
+  for (int i = 0; i < HASH_MAP_GROUP_WIDTH; ++i) mask |= (unsigned int)(GROUP[i] >> 7) << i;
+  return mask;
+#endif
+}
+
+// - - - Table - - -
+
+static bool allocateTable(HashMap* MAP, unsigned long long SIZE)
+{
+  unsigned char* memory = mapAllocate(MAP, tableBytes(SIZE));
+  if (memory == NULL)
+  {
+    FORGE_LOG_ERROR("Memory Allocator failed for HashMap entries");
+    return false;
+  }
+
+  MAP->size       = SIZE;
+  MAP->tombstones = 0;
+  MAP->control    = memory;
+  MAP->elements   = (MapEntry*)(memory + SIZE);
+  memset(MAP->control, CONTROL_EMPTY, SIZE);
+  return true;
+}
+
+// - - - groups are visited in triangular steps, which reaches every group of a power of two table exactly once
+static unsigned long long findSlot(HashMap* MAP, const unsigned char* CONTROL, MapEntry* ELEMENTS, unsigned long long SIZE, const byteArray KEY, unsigned long long KEY_SIZE, unsigned long long HASH)
+{
+  unsigned long long  groupMask = SIZE / HASH_MAP_GROUP_WIDTH - 1;
+  unsigned long long  group     = HASH & groupMask;
+  unsigned char       tag       = hashTag(HASH);
+
+  for (unsigned long long step = 1; ; ++step)
+  {
+    const unsigned char* control = CONTROL + group * HASH_MAP_GROUP_WIDTH;
+    for (unsigned int match = groupMatch(control, tag); match; match &= match - 1)
+    {
+      unsigned long long slot  = group * HASH_MAP_GROUP_WIDTH + __builtin_ctz(match);
+      MapEntry*          entry = &ELEMENTS[slot];
+      // - - - a tag match is 1 in 128 by chance, the full hash weeds those out without touching the key
+      if (entry->hash == HASH && entry->keySize == KEY_SIZE && MAP->compare(entryKey(entry), KEY, KEY_SIZE) == 0) return slot;
+    }
+
+    // - - - an empty slot ends the probe, the key would have been put there
+    if (groupMatch(control, CONTROL_EMPTY)) return NOT_FOUND;
+    if (step > groupMask) return NOT_FOUND;
+    group = (group + step) & groupMask;
+  }
+}
+
+static unsigned long long findFreeSlot(HashMap* MAP, unsigned long long HASH)
+{
+  unsigned long long groupMask = MAP->size / HASH_MAP_GROUP_WIDTH - 1;
+  unsigned long long group     = HASH & groupMask;
+
+  for (unsigned long long step = 1; ; ++step)
+  {
+    unsigned int free = groupMatchFree(MAP->control + group * HASH_MAP_GROUP_WIDTH);
+    if (free) return group * HASH_MAP_GROUP_WIDTH + __builtin_ctz(free);
+    group = (group + step) & groupMask;
+  }
+}
+
+// - - - a group that still has an empty slot never made a probe move on, so the slot can be empty again.
+// - - - Otherwise probes for other keys may run through it and it has to stay marked, true when it does
+static bool eraseSlot(unsigned char* CONTROL, unsigned long long SLOT)
+{
+  const unsigned char* group = CONTROL + SLOT / HASH_MAP_GROUP_WIDTH * HASH_MAP_GROUP_WIDTH;
+  if (groupMatch(group, CONTROL_EMPTY))
+  {
+    CONTROL[SLOT] = CONTROL_EMPTY;
+    return false;
+  }
+  CONTROL[SLOT] = CONTROL_DELETED;
+  return true;
+}
+
+// - - - moves up to COUNT slots of the old table into the current one, and frees the old one once it is drained.
+// - - - Moved slots are marked deleted so probes through the old table still reach the entries behind them
+static void migrate(HashMap* MAP, unsigned long long COUNT)
+{
+  if (MAP->oldControl == NULL) return;
+
+  unsigned long long end = MAP->migrated + COUNT;
+  if (end > MAP->oldSize) end = MAP->oldSize;
+
+  for (unsigned long long i = MAP->migrated; i < end && MAP->oldCount > 0; ++i)
+  {
+    if (MAP->oldControl[i] & CONTROL_EMPTY) continue;
+    MapEntry*          entry = &MAP->oldElements[i];
+    unsigned long long slot  = findFreeSlot(MAP, entry->hash);
+    if (MAP->control[slot] == CONTROL_DELETED) MAP->tombstones--;
+    MAP->control[slot]       = hashTag(entry->hash);
+    MAP->elements[slot]      = *entry;
+    MAP->oldControl[i]       = CONTROL_DELETED;
+    MAP->oldCount--;
+  }
+  MAP->migrated = end;
+
+  if (MAP->migrated == MAP->oldSize || MAP->oldCount == 0)
+  {
+    mapDeallocate(MAP, MAP->oldControl, tableBytes(MAP->oldSize));
+    MAP->oldControl   = NULL;
+    MAP->oldElements  = NULL;
+    MAP->oldSize      = 0;
+    MAP->oldCount     = 0;
+  }
+}
+
+// - - - the current table becomes the old one and drains into a fresh one of SIZE slots
+static bool startRehash(HashMap* MAP, unsigned long long SIZE)
+{
+  unsigned long long  oldSize     = MAP->size;
+  unsigned long long  tombstones  = MAP->tombstones;
+  unsigned char*      oldControl  = MAP->control;
+  MapEntry*           oldElements = MAP->elements;
+
+  if (!allocateTable(MAP, SIZE))
+  {
+    MAP->size       = oldSize;
+    MAP->tombstones = tombstones;
+    MAP->control    = oldControl;
+    MAP->elements   = oldElements;
+    return false;
+  }
+
+  MAP->oldSize      = oldSize;
+  MAP->oldCount     = MAP->count;
+  MAP->migrated     = 0;
+  MAP->oldControl   = oldControl;
+  MAP->oldElements  = oldElements;
+  return true;
+}
+
+// - - - makes room for one more entry. Everything still in the old table counts too, so a new table always has
+// - - - room for the rest of the migration. Mostly deleted slots get cleaned up into a table of the same size
+static bool reserveOne(HashMap* MAP)
+{
+  if (MAP->count + MAP->tombstones + 1 <= MAP->maxLoad * MAP->size) return true;
+
+  // - - - still draining the last resize, finish that first and look again
+  if (MAP->oldControl)
+  {
+    migrate(MAP, MAP->oldSize);
+    if (MAP->count + MAP->tombstones + 1 <= MAP->maxLoad * MAP->size) return true;
+  }
+
+  unsigned long long size = MAP->tombstones > MAP->count ? MAP->size : MAP->size * 2;
+  while (MAP->count + 1 > MAP->maxLoad * size) size *= 2;
+  return startRehash(MAP, size);
+}
+
+// - - - lookups and inserts once the key is hashed, the batches hash ahead of time
+static void* getHashed(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE, unsigned long long HASH)
+{
+  unsigned long long  slot = findSlot(MAP, MAP->control, MAP->elements, MAP->size, KEY, KEY_SIZE, HASH);
+  if (slot != NOT_FOUND)
+  {
+    return MAP->elements[slot].value;
+  }
+  if (MAP->oldControl == NULL)
+  {
+    return NULL;
+  }
+
+  slot = findSlot(MAP, MAP->oldControl, MAP->oldElements, MAP->oldSize, KEY, KEY_SIZE, HASH);
+  if (slot == NOT_FOUND)
+  {
+    return NULL;
+  }
+  return MAP->oldElements[slot].value;
+}
+
+static bool insertHashed(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE, void* VALUE, unsigned long long HASH)
+{
+  unsigned long long  slot = findSlot(MAP, MAP->control, MAP->elements, MAP->size, KEY, KEY_SIZE, HASH);
+  if (slot != NOT_FOUND)
+  {
+    MAP->elements[slot].value = VALUE;
+    return true;
+  }
+  if (MAP->oldControl)
+  {
+    slot = findSlot(MAP, MAP->oldControl, MAP->oldElements, MAP->oldSize, KEY, KEY_SIZE, HASH);
+    if (slot != NOT_FOUND)
+    {
+      MAP->oldElements[slot].value = VALUE;
+      return true;
+    }
+  }
+
+  if (!reserveOne(MAP)) return false;
+  migrate(MAP, MIGRATE_SLOTS);
+
+  char* key = NULL;
+  if (KEY_SIZE > HASH_MAP_INLINE_KEY)
+  {
+    key = mapAllocate(MAP, KEY_SIZE);
+    if (key == NULL)
+    {
+      FORGE_LOG_ERROR("Memory Allocator failed for a HashMap key");
+      return false;
+    }
+    memcpy(key, KEY, KEY_SIZE);
+  }
 
-  MAP->size         = SIZE;
+  slot = findFreeSlot(MAP, HASH);
+  if (MAP->control[slot] == CONTROL_DELETED) MAP->tombstones--;
+  MAP->control[slot]    = hashTag(HASH);
+  MapEntry* entry       = &MAP->elements[slot];
+  entry->hash           = HASH;
+  entry->keySize        = KEY_SIZE;
+  entry->value          = VALUE;
+  if (key) entry->key   = key;
+  else     memcpy(entry->inlineKey, KEY, KEY_SIZE);
+  MAP->count++;
+
+  return true;
+}
+
+// - - - HashMap - - -
+
+// - - - everything but where the memory comes from, which the callers set up
+static bool initHashMap(HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, const ForgeAllocator* ALLOCATOR, memoryCompare* MEMCMP)
+{
   MAP->hash         = HASH_FUNCTION;
-  MAP->allocator    = MALLOC;
+  MAP->maxLoad      = DEFAULT_MAX_LOAD;
+  MAP->seed         = newSeed(MAP);
+  MAP->count        = 0;
+  MAP->oldSize      = 0;
+  MAP->oldCount     = 0;
+  MAP->migrated     = 0;
+  MAP->oldControl   = NULL;
+  MAP->oldElements  = NULL;
+  MAP->memory       = *ALLOCATOR;
   MAP->compare      = MEMCMP;
-  MAP->deallocator  = FREE;
 
   if (HASH_FUNCTION == NULL)
   {
-    FORGE_LOG_WARNING("NULL passed as hash function, going to use a simple hash");
+    FORGE_LOG_WARNING("NULL passed as hash function, going with the seeded default hash");
     MAP->hash           = hash;    
   }
+  if (MEMCMP == NULL)
+  {
+    FORGE_LOG_WARNING("NULL passed as memory compare, going with memcmp from stdlib");
+    MAP->compare        = memcmp;
+  }
+  
+  // - - - enough slots for SIZE entries below the maximum load
+  unsigned long long slots = HASH_MAP_GROUP_WIDTH;
+  while (SIZE > MAP->maxLoad * slots) slots <<= 1;
+
+  return allocateTable(MAP, slots);
+}
+
+bool createHashMap(HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, memoryAllocate* MALLOC, memoryDeallocate* FREE, memoryCompare* MEMCMP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "Cannot initialize a null HashMap");
+  FORGE_ASSERT_MESSAGE(SIZE > 0, "The size of a HashMap must be greater than 0");
+
+  MAP->allocator    = MALLOC;
+  MAP->deallocator  = FREE;
+
   if (MALLOC == NULL)
   {
     FORGE_LOG_WARNING("NULL passed as memory allocator, going with malloc from stdlib");
@@ -44,42 +475,106 @@ bool createHashMap(HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUN
     FORGE_LOG_WARNING("NULL passed as memory deallocator, going with free from stdlib");
     MAP->deallocator    = free;
   }
-  if (MEMCMP == NULL)
+
+  ForgeAllocator memory;
+  createFunctionAllocator(&memory, MAP->allocator, MAP->deallocator);
+
+  return initHashMap(MAP, SIZE, HASH_FUNCTION, &memory, MEMCMP);
+}
+
+bool createHashMapWithAllocator(HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, const ForgeAllocator* ALLOCATOR, memoryCompare* MEMCMP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL,       "Cannot initialize a null HashMap");
+  FORGE_ASSERT_MESSAGE(SIZE > 0,          "The size of a HashMap must be greater than 0");
+  FORGE_ASSERT_MESSAGE(ALLOCATOR != NULL, "Cannot create a HashMap with a NULL allocator");
+
+  MAP->allocator    = NULL;
+  MAP->deallocator  = NULL;
+  return initHashMap(MAP, SIZE, HASH_FUNCTION, ALLOCATOR, MEMCMP);
+}
+
+bool destroyHashMap(HashMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "Cannot destroy a NULL HashMap");
+  FORGE_LOG_WARNING("Destroying HashMap");
+
+  for (unsigned long long i = 0; i < MAP->size; ++i)
   {
-    FORGE_LOG_WARNING("NULL passed as memory compare, going with memcmp from stdlib");
-    MAP->compare        = memcmp;
+    if (!(MAP->control[i] & CONTROL_EMPTY) && MAP->elements[i].keySize > HASH_MAP_INLINE_KEY) mapDeallocate(MAP, MAP->elements[i].key, MAP->elements[i].keySize);
   }
-  
-  MAP->elements         = MAP->allocator(sizeof(MapEntry*) * MAP->size);
-  if (MAP->elements == 0)
+  for (unsigned long long i = 0; MAP->oldControl && i < MAP->oldSize; ++i)
   {
-    FORGE_LOG_ERROR("Memory Allocator failed for HashMap entries");
-    return false;
+    if (!(MAP->oldControl[i] & CONTROL_EMPTY) && MAP->oldElements[i].keySize > HASH_MAP_INLINE_KEY) mapDeallocate(MAP, MAP->oldElements[i].key, MAP->oldElements[i].keySize);
   }
 
+  if (MAP->oldControl) mapDeallocate(MAP, MAP->oldControl, tableBytes(MAP->oldSize));
+  mapDeallocate(MAP, MAP->control, tableBytes(MAP->size));
+  MAP->control  = NULL;
+  MAP->elements = NULL;
+  MAP->count    = 0;
+
+  FORGE_LOG_WARNING("The memory associated with the Map and Values are not owned by the Map. Cannot deallocate them");
   return true;
 }
 
-bool destroyHashMap(HashMap* MAP)
+void hashMapSetMaxLoad(HashMap* MAP, float MAX_LOAD)
 {
-  FORGE_ASSERT_MESSAGE(MAP != NULL, "Cannot destroy a NULL HashMap");
-  FORGE_LOG_WARNING("Destroying HashMap");
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(MAX_LOAD > 0.0f && MAX_LOAD < 1.0f, "The max load of a HashMap must be between 0 and 1");
+
+  // - - - takes effect with the next insert
+  MAP->maxLoad = MAX_LOAD;
+}
+
+void hashMapSetSeed(HashMap* MAP, unsigned long long SEED)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(MAP->count == 0, "Cannot reseed a HashMap that has entries, they would be lost");
+
+  MAP->seed = SEED;
+}
+
+bool hashMapReserve(HashMap* MAP, unsigned long long COUNT)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
+
+  // - - - asked for explicitly, so a pending or new migration is done in one go instead of spread over inserts
+  migrate(MAP, MAP->oldSize);
+  if (COUNT + MAP->tombstones <= MAP->maxLoad * MAP->size) return true;
 
-  for (int i = 0; i < MAP->size; ++i)
+  unsigned long long size = MAP->size;
+  while (COUNT > MAP->maxLoad * size) size *= 2;
+  if (!startRehash(MAP, size)) return false;
+
+  migrate(MAP, MAP->oldSize);
+  return true;
+}
+
+void hashMapClear(HashMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
+
+  // - - - only long keys own memory, inline ones go with the control bytes
+  for (unsigned long long i = 0; MAP->count > 0 && i < MAP->size; ++i)
+  {
+    if (!(MAP->control[i] & CONTROL_EMPTY) && MAP->elements[i].keySize > HASH_MAP_INLINE_KEY) mapDeallocate(MAP, MAP->elements[i].key, MAP->elements[i].keySize);
+  }
+  if (MAP->oldControl)
   {
-    while (MAP->elements[i])
+    for (unsigned long long i = 0; i < MAP->oldSize; ++i)
     {
-      MapEntry* entry = MAP->elements[i];
-      MAP->elements[i] = MAP->elements[i]->next;
-      MAP->deallocator(entry->key);
-      MAP->deallocator(entry);
+      if (!(MAP->oldControl[i] & CONTROL_EMPTY) && MAP->oldElements[i].keySize > HASH_MAP_INLINE_KEY) mapDeallocate(MAP, MAP->oldElements[i].key, MAP->oldElements[i].keySize);
     }
+    mapDeallocate(MAP, MAP->oldControl, tableBytes(MAP->oldSize));
+    MAP->oldControl   = NULL;
+    MAP->oldElements  = NULL;
+    MAP->oldSize      = 0;
+    MAP->oldCount     = 0;
   }
 
-  MAP->deallocator(MAP->elements);
-
-  FORGE_LOG_WARNING("The memory associated with the Map and Values are not owned by the Map. Cannot deallocate them");
-  return true;
+  if (MAP->count + MAP->tombstones > 0) memset(MAP->control, CONTROL_EMPTY, MAP->size);
+  MAP->count      = 0;
+  MAP->tombstones = 0;
 }
 
 bool hashMapInsert(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE, void* VALUE)
@@ -94,77 +589,179 @@ bool hashMapInsert(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZ
     return false;
   }
 
-  unsigned long long  index = getIndex(MAP, KEY, KEY_SIZE);
-  MapEntry*           head  = MAP->elements[index];
-
-  while (head != NULL)
-  {
-    if (MAP->compare(head->key, KEY, KEY_SIZE) == 0)
-    {
-      head->value = VALUE;
-      return true;
-    }
-    head = head->next;
-  }
-
-  MapEntry* entry       = MAP->allocator(sizeof(*entry));
-  entry->value          = VALUE;
-  entry->key            = MAP->allocator(KEY_SIZE);
-  memcpy(entry->key, KEY, KEY_SIZE);
+  return insertHashed(MAP, KEY, KEY_SIZE, VALUE, keyHash(MAP, KEY, KEY_SIZE));
+}
 
-  entry->next           = MAP->elements[index];
-  MAP->elements[index]  = entry;
+void* hashMapGet(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(KEY != NULL, "KEY cannot be NULL");
 
-  return true;
+  return getHashed(MAP, KEY, KEY_SIZE, keyHash(MAP, KEY, KEY_SIZE));
 }
 
-void* hashMapGet(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+void* hashMapRemove(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
 {
   FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
   FORGE_ASSERT_MESSAGE(KEY != NULL, "KEY cannot be NULL");
 
-  unsigned long long  index = getIndex(MAP, KEY, KEY_SIZE);
-  MapEntry*           head  = MAP->elements[index];
+  unsigned long long  hash    = keyHash(MAP, KEY, KEY_SIZE);
+  unsigned long long  slot    = findSlot(MAP, MAP->control, MAP->elements, MAP->size, KEY, KEY_SIZE, hash);
+  MapEntry*           entry   = NULL;
 
-  while (head != NULL && MAP->compare(head->key, KEY, KEY_SIZE) != 0)
+  if (slot != NOT_FOUND)
   {
-    head = head->next;
+    entry = &MAP->elements[slot];
+    if (eraseSlot(MAP->control, slot)) MAP->tombstones++;
   }
-  if (head == NULL)
+  else if (MAP->oldControl)
   {
-    return NULL;
+    slot = findSlot(MAP, MAP->oldControl, MAP->oldElements, MAP->oldSize, KEY, KEY_SIZE, hash);
+    if (slot == NOT_FOUND) return NULL;
+    entry = &MAP->oldElements[slot];
+    eraseSlot(MAP->oldControl, slot);
+    MAP->oldCount--;
   }
-  return head->value;
+  else return NULL;
+
+  MAP->count--;
+  void* result = entry->value;
+  if (entry->keySize > HASH_MAP_INLINE_KEY) mapDeallocate(MAP, entry->key, entry->keySize);
+
+  migrate(MAP, MIGRATE_SLOTS);
+  return result;
 }
 
-void* hashMapRemove(HashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE)
+// - - - Batches - - -
+
+// - - - keys per round. Enough cache misses in flight to hide memory latency, few enough hashes for the stack
+#define BATCH_WIDTH       16
+
+// - - - stage one : the control bytes of the first group the probe will look at
+static inline void prefetchGroup(HashMap* MAP, unsigned long long HASH)
 {
-  FORGE_ASSERT_MESSAGE(MAP != NULL, "MAP cannot be NULL");
-  FORGE_ASSERT_MESSAGE(KEY != NULL, "KEY cannot be NULL");
+  unsigned long long group = HASH & (MAP->size / HASH_MAP_GROUP_WIDTH - 1);
+  __builtin_prefetch(MAP->control + group * HASH_MAP_GROUP_WIDTH);
+}
 
-  unsigned long long index = getIndex(MAP, KEY, KEY_SIZE);
+// - - - stage two, once the control bytes are likely in : the entry the probe will compare, or write when FREE
+static inline void prefetchEntry(HashMap* MAP, unsigned long long HASH, bool FREE)
+{
+  unsigned long long    group   = HASH & (MAP->size / HASH_MAP_GROUP_WIDTH - 1);
+  const unsigned char*  control = MAP->control + group * HASH_MAP_GROUP_WIDTH;
+  unsigned int          match   = groupMatch(control, hashTag(HASH));
+  if (match == 0 && FREE) match = groupMatchFree(control);
+  if (match == 0) return;
 
-  MapEntry* head = MAP->elements[index];
-  MapEntry* prev = NULL;
+  const MapEntry* entry = &MAP->elements[group * HASH_MAP_GROUP_WIDTH + __builtin_ctz(match)];
+  __builtin_prefetch(entry);
+  __builtin_prefetch((const char*)(entry + 1) - 1);
+}
 
-  while (head != NULL && MAP->compare(head->key, KEY, KEY_SIZE) != 0)
+unsigned long long hashMapGetBatch(HashMap* MAP, const byteArray* KEYS, const unsigned long long* KEY_SIZES, unsigned long long COUNT, void** VALUES)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL,                         "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(KEYS != NULL && KEY_SIZES != NULL,   "KEYS and KEY_SIZES cannot be NULL");
+  FORGE_ASSERT_MESSAGE(VALUES != NULL,                      "VALUES cannot be NULL");
+
+  unsigned long long found = 0;
+  unsigned long long hashes[BATCH_WIDTH];
+  for (unsigned long long base = 0; base < COUNT; base += BATCH_WIDTH)
   {
-    prev = head;
-    head = head->next;
+    unsigned long long width = COUNT - base < BATCH_WIDTH ? COUNT - base : BATCH_WIDTH;
+
+    for (unsigned long long i = 0; i < width; ++i)
+    {
+      hashes[i] = keyHash(MAP, KEYS[base + i], KEY_SIZES[base + i]);
+      prefetchGroup(MAP, hashes[i]);
+    }
+    for (unsigned long long i = 0; i < width; ++i) prefetchEntry(MAP, hashes[i], false);
+    for (unsigned long long i = 0; i < width; ++i)
+    {
+      VALUES[base + i] = getHashed(MAP, KEYS[base + i], KEY_SIZES[base + i], hashes[i]);
+      found           += VALUES[base + i] != NULL;
+    }
   }
+  return found;
+}
+
+unsigned long long hashMapInsertBatch(HashMap* MAP, const byteArray* KEYS, const unsigned long long* KEY_SIZES, void* const* VALUES, unsigned long long COUNT)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL,                         "Cannot insert into a null hashmap");
+  FORGE_ASSERT_MESSAGE(KEYS != NULL && KEY_SIZES != NULL,   "KEYS and KEY_SIZES cannot be NULL");
+  FORGE_ASSERT_MESSAGE(VALUES != NULL,                      "VALUES cannot be NULL");
 
-  if (head == NULL) return NULL;
-  if (prev == NULL)
+  unsigned long long inserted = 0;
+  unsigned long long hashes[BATCH_WIDTH];
+  for (unsigned long long base = 0; base < COUNT; base += BATCH_WIDTH)
   {
-    MAP->elements[index] = head->next;
+    unsigned long long width = COUNT - base < BATCH_WIDTH ? COUNT - base : BATCH_WIDTH;
+
+    for (unsigned long long i = 0; i < width; ++i)
+    {
+      FORGE_ASSERT_MESSAGE(KEYS[base + i] != NULL && KEY_SIZES[base + i] > 0, "Cannot insert a NULL or empty Key");
+      hashes[i] = keyHash(MAP, KEYS[base + i], KEY_SIZES[base + i]);
+      prefetchGroup(MAP, hashes[i]);
+    }
+    // - - - a resize half way through only makes the rest of the prefetches useless, never wrong
+    for (unsigned long long i = 0; i < width; ++i) prefetchEntry(MAP, hashes[i], true);
+    for (unsigned long long i = 0; i < width; ++i)
+    {
+      if (VALUES[base + i] == NULL)
+      {
+        FORGE_LOG_ERROR("Assiging a NULL value is the same as not assigning at all");
+        continue;
+      }
+      inserted += insertHashed(MAP, KEYS[base + i], KEY_SIZES[base + i], VALUES[base + i], hashes[i]);
+    }
   }
-  else 
+  return inserted;
+}
+
+// - - - Iteration - - -
+
+void createHashMapIter(HashMap* MAP, HashMapIterator* ITERATOR)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL,      "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(ITERATOR != NULL, "Cannot initialize a NULL iterator");
+
+  ITERATOR->slot = 0;
+  ITERATOR->old  = false;
+}
+
+bool hashMapIterNext(HashMap* MAP, HashMapIterator* ITERATOR, const char** KEY, unsigned long long* KEY_SIZE, void** VALUE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL,      "MAP cannot be NULL");
+  FORGE_ASSERT_MESSAGE(ITERATOR != NULL, "ITERATOR cannot be NULL");
+
+  for (;;)
   {
-    prev->next = head->next;
-  }
+    const unsigned char*  control  = ITERATOR->old ? MAP->oldControl  : MAP->control;
+    const MapEntry*       elements = ITERATOR->old ? MAP->oldElements : MAP->elements;
+    unsigned long long    size     = ITERATOR->old ? MAP->oldSize     : MAP->size;
 
-  void* result = head->value;
-  MAP->deallocator(head);
+    while (ITERATOR->slot < size)
+    {
+      // - - - full slots of the group, minus the ones before where the last call stopped
+      unsigned long long  group = ITERATOR->slot & ~(unsigned long long)(HASH_MAP_GROUP_WIDTH - 1);
+      unsigned int        full  = ~groupMatchFree(control + group) & ((1u << HASH_MAP_GROUP_WIDTH) - 1);
+      full &= ~0u << (ITERATOR->slot - group);
+      if (full == 0)
+      {
+        ITERATOR->slot = group + HASH_MAP_GROUP_WIDTH;
+        continue;
+      }
 
-  return result;
+      const MapEntry* entry = &elements[group + __builtin_ctz(full)];
+      ITERATOR->slot        = group + __builtin_ctz(full) + 1;
+      if (KEY)      *KEY      = entryKey(entry);
+      if (KEY_SIZE) *KEY_SIZE = entry->keySize;
+      if (VALUE)    *VALUE    = entry->value;
+      return true;
+    }
+
+    if (ITERATOR->old || MAP->oldControl == NULL) return false;
+    ITERATOR->old  = true;
+    ITERATOR->slot = 0;
+  }
 }
@@ -0,0 +1,229 @@
+#include "../include/intMap.h"
+#include "../include/asserts.h"
+#include "../include/logger.h"
+#include <sys/random.h>
+#include <time.h>
+
+#define MIN_SLOTS 16
+
+// - - - grows past 3 of 4 slots used, linear probes get long quickly above that
+static inline bool overLoaded(u64 COUNT, u64 SIZE)
+{
+  return COUNT * 4 > SIZE * 3;
+}
+
+// - - - one 64x64 -> 128 bit multiply, high and low halves folded. Every key bit reaches every hash bit, so ids that
+// - - - only differ high up still spread over the low bits used as the index
+static inline u64 mixKey(u64 KEY, u64 SEED)
+{
+#if defined(__SIZEOF_INT128__)
+  __uint128_t product = (__uint128_t)(KEY ^ SEED) * 0x9E3779B97F4A7C15ULL;
+  return (u64)product ^ (u64)(product >> 64);
+#else
+  u64 hash = (KEY ^ SEED) * 0x9E3779B97F4A7C15ULL;
+  hash ^= hash >> 32;
+  hash *= 0xD6E8FEB86659FD93ULL;
+  return hash ^ (hash >> 32);
+#endif
+}
+
+static inline u64 homeSlot(IntMap* MAP, u64 KEY)
+{
+  return mixKey(KEY, MAP->seed) & (MAP->size - 1);
+}
+
+static IntMapSlot* allocateSlots(IntMap* MAP, u64 SIZE)
+{
+  IntMapSlot* slots = MAP->memory.allocate(MAP->memory.context, SIZE * sizeof(IntMapSlot));
+  if (slots == NULL)
+  {
+    FORGE_LOG_ERROR("[INT MAP] : Memory Allocator failed for %llu slots", SIZE);
+    return NULL;
+  }
+  memset(slots, 0, SIZE * sizeof(IntMapSlot));
+  return slots;
+}
+
+// - - - the key is not in the slots and there is room for it
+static void place(IntMap* MAP, u64 KEY, void* VALUE)
+{
+  u64 mask = MAP->size - 1;
+  u64 slot = homeSlot(MAP, KEY);
+  while (MAP->slots[slot].key != INT_MAP_EMPTY_KEY) slot = (slot + 1) & mask;
+  MAP->slots[slot].key   = KEY;
+  MAP->slots[slot].value = VALUE;
+}
+
+static bool resize(IntMap* MAP, u64 SIZE)
+{
+  IntMapSlot* slots = allocateSlots(MAP, SIZE);
+  if (slots == NULL) return false;
+
+  IntMapSlot* old     = MAP->slots;
+  u64         oldSize = MAP->size;
+  MAP->slots          = slots;
+  MAP->size           = SIZE;
+  for (u64 i = 0; i < oldSize; ++i)
+  {
+    if (old[i].key != INT_MAP_EMPTY_KEY) place(MAP, old[i].key, old[i].value);
+  }
+  MAP->memory.deallocate(MAP->memory.context, old, oldSize * sizeof(IntMapSlot));
+  return true;
+}
+
+static u64 slotsFor(u64 COUNT)
+{
+  u64 size = MIN_SLOTS;
+  while (overLoaded(COUNT, size)) size <<= 1;
+  return size;
+}
+
+bool createIntMap(IntMap* MAP, u64 SIZE, const ForgeAllocator* ALLOCATOR)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : Cannot initialize a NULL map");
+
+  if (ALLOCATOR) MAP->memory = *ALLOCATOR;
+  else           createHeapAllocator(&MAP->memory);
+
+  // - - - random per map, so nobody can pick ids that all land on one slot
+  if (getrandom(&MAP->seed, sizeof(MAP->seed), GRND_NONBLOCK) != sizeof(MAP->seed))
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    MAP->seed = mixKey((u64)ts.tv_nsec, (u64)MAP);
+  }
+
+  MAP->count        = 0;
+  MAP->hasZeroKey   = false;
+  MAP->zeroKeyValue = NULL;
+  MAP->size         = slotsFor(SIZE);
+  MAP->slots        = allocateSlots(MAP, MAP->size);
+  return MAP->slots != NULL;
+}
+
+bool destroyIntMap(IntMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : Cannot destroy a NULL map");
+
+  MAP->memory.deallocate(MAP->memory.context, MAP->slots, MAP->size * sizeof(IntMapSlot));
+  MAP->slots      = NULL;
+  MAP->size       = 0;
+  MAP->count      = 0;
+  MAP->hasZeroKey = false;
+  return true;
+}
+
+bool intMapInsert(IntMap* MAP, u64 KEY, void* VALUE)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : Cannot insert into a NULL map");
+
+  if (VALUE == NULL)
+  {
+    FORGE_LOG_ERROR("[INT MAP] : Assiging a NULL value is the same as not assigning at all");
+    return false;
+  }
+
+  if (KEY == INT_MAP_EMPTY_KEY)
+  {
+    MAP->count       += !MAP->hasZeroKey;
+    MAP->hasZeroKey   = true;
+    MAP->zeroKeyValue = VALUE;
+    return true;
+  }
+
+  u64 mask = MAP->size - 1;
+  u64 slot = homeSlot(MAP, KEY);
+  for (; MAP->slots[slot].key != INT_MAP_EMPTY_KEY; slot = (slot + 1) & mask)
+  {
+    if (MAP->slots[slot].key == KEY)
+    {
+      MAP->slots[slot].value = VALUE;
+      return true;
+    }
+  }
+
+  if (overLoaded(MAP->count + 1, MAP->size))
+  {
+    if (!resize(MAP, MAP->size * 2)) return false;
+    place(MAP, KEY, VALUE);
+  }
+  else
+  {
+    MAP->slots[slot].key   = KEY;
+    MAP->slots[slot].value = VALUE;
+  }
+  MAP->count++;
+  return true;
+}
+
+void* intMapGet(IntMap* MAP, u64 KEY)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : MAP cannot be NULL");
+
+  if (KEY == INT_MAP_EMPTY_KEY) return MAP->zeroKeyValue;
+
+  u64 mask = MAP->size - 1;
+  for (u64 slot = homeSlot(MAP, KEY); ; slot = (slot + 1) & mask)
+  {
+    u64 key = MAP->slots[slot].key;
+    if (key == KEY)                 return MAP->slots[slot].value;
+    if (key == INT_MAP_EMPTY_KEY)   return NULL;
+  }
+}
+
+void* intMapRemove(IntMap* MAP, u64 KEY)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : MAP cannot be NULL");
+
+  if (KEY == INT_MAP_EMPTY_KEY)
+  {
+    void* value       = MAP->zeroKeyValue;
+    MAP->count       -= MAP->hasZeroKey;
+    MAP->hasZeroKey   = false;
+    MAP->zeroKeyValue = NULL;
+    return value;
+  }
+
+  u64 mask = MAP->size - 1;
+  u64 hole = homeSlot(MAP, KEY);
+  for (; MAP->slots[hole].key != KEY; hole = (hole + 1) & mask)
+  {
+    if (MAP->slots[hole].key == INT_MAP_EMPTY_KEY) return NULL;
+  }
+  void* value = MAP->slots[hole].value;
+
+  // - - - pull back every following entry whose home is not between the hole and where it sits, so no probe
+  // - - - ever runs into a gap before reaching its key
+  for (u64 next = (hole + 1) & mask; MAP->slots[next].key != INT_MAP_EMPTY_KEY; next = (next + 1) & mask)
+  {
+    u64 home = homeSlot(MAP, MAP->slots[next].key);
+    if (((next - home) & mask) >= ((next - hole) & mask))
+    {
+      MAP->slots[hole] = MAP->slots[next];
+      hole             = next;
+    }
+  }
+  MAP->slots[hole].key   = INT_MAP_EMPTY_KEY;
+  MAP->slots[hole].value = NULL;
+  MAP->count--;
+  return value;
+}
+
+bool intMapReserve(IntMap* MAP, u64 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : MAP cannot be NULL");
+
+  u64 size = slotsFor(COUNT);
+  return size <= MAP->size || resize(MAP, size);
+}
+
+void intMapClear(IntMap* MAP)
+{
+  FORGE_ASSERT_MESSAGE(MAP != NULL, "[INT MAP] : MAP cannot be NULL");
+
+  // - - - the empty key is 0, so empty slots are all zero bytes
+  memset(MAP->slots, 0, MAP->size * sizeof(IntMapSlot));
+  MAP->count        = 0;
+  MAP->hasZeroKey   = false;
+  MAP->zeroKeyValue = NULL;
+}
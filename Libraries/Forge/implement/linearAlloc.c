@@ -90,6 +90,14 @@ void linearAllocFree(LinearAllocator* ALLOCATOR)
   FORGE_LOG_WARNING("ALLOCATOR has freed all the memory");
 }
 
+// - - - O(1), everything handed out so far is free again. Nothing is cleared
+void linearAllocReset(LinearAllocator* ALLOCATOR)
+{
+  FORGE_ASSERT_MESSAGE(ALLOCATOR    != NULL, "Cannot reset a NULL ALLOACTOR");
+
+  ALLOCATOR->allocated = 0;
+}
+
 void setLinearAllocatorResizeFactor(LinearAllocator* ALLOCATOR, float RESIZE_FACTOR)
 {
   FORGE_ASSERT_MESSAGE(ALLOCATOR      != NULL, "Cannot channge resize factor of a NULL allocator");
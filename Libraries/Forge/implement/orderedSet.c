@@ -14,10 +14,18 @@ static i64 getHeight(AVLNode* NODE)  { return NODE ? NODE->height : 0; }
 static i64 getBalance(AVLNode* NODE) { return NODE ? getHeight(NODE->left) - getHeight(NODE->right) : 0; }
 
 
+// - - - memory - - -
+
+static void freeNode(OrderedSet* SET, AVLNode* NODE)
+{
+  SET->memory.deallocate(SET->memory.context, NODE, sizeof(AVLNode));
+}
+
+
 // - - - create Node - - - 
 static AVLNode* createNode(OrderedSet* SET, byteArray KEY)
 {
-  AVLNode* node = (AVLNode*) SET->allocator(sizeof(AVLNode));
+  AVLNode* node = (AVLNode*) SET->memory.allocate(SET->memory.context, sizeof(AVLNode));
   FORGE_ASSERT_MESSAGE(node, "[ORDERED SET] : Memory Allocation failed for AVL Node");
 
   node->key     = KEY;  
@@ -98,7 +106,7 @@ static AVLNode* insertNode(OrderedSet* SET, AVLNode* NODE, byteArray KEY)
   if (!NODE) return createNode(SET, KEY);
 
   // - - - compare
-  i8 cmp = SET->compare(KEY, NODE->key, SET->keySize);
+  i32 cmp = SET->compare(KEY, NODE->key, SET->keySize);
   if        (cmp == 0)  return NODE;
   else if   (cmp < 0)   NODE->left  = insertNode(SET, NODE->left, KEY);
   else if   (cmp > 0)   NODE->right = insertNode(SET, NODE->right, KEY);
@@ -175,7 +183,7 @@ static DeleteResult deleteNode(OrderedSet* SET, AVLNode* NODE, byteArray KEY)
         *NODE       = *temp;
         result.node = NODE;
       }
-      SET->deallocator(temp);
+      freeNode(SET, temp);
     }
     else 
     {
@@ -226,7 +234,7 @@ static void deleteSetNodes(OrderedSet* SET, AVLNode* NODE)
   {
     deleteSetNodes(SET, NODE->left);
     deleteSetNodes(SET, NODE->right);
-    SET->deallocator(NODE);
+    freeNode(SET, NODE);
   }
 }
 
@@ -290,6 +298,29 @@ void createOrderedSet(OrderedSet* SET, u64 KEY_SIZE, memoryCompare* COMPARE, mem
     FORGE_LOG_WARNING("[ORDERED SET] : No memory deallocation function passed. Will use 'free' from stdlib");
     SET->deallocator = free;
   }
+
+  createFunctionAllocator(&SET->memory, SET->allocator, SET->deallocator);
+}
+
+void createOrderedSetWithAllocator(OrderedSet* SET, u64 KEY_SIZE, memoryCompare* COMPARE, const ForgeAllocator* ALLOCATOR)
+{
+  FORGE_ASSERT_MESSAGE(SET,       "[ORDERED SET] : Cannot initialize a null OrderedSet");
+  FORGE_ASSERT_MESSAGE(KEY_SIZE,  "[ORDERED SET] : Cannot have a key size of less than 1 byte");
+  FORGE_ASSERT_MESSAGE(ALLOCATOR, "[ORDERED SET] : Cannot create an OrderedSet with a NULL allocator");
+
+  SET->compare      = COMPARE;
+  SET->allocator    = NULL;
+  SET->deallocator  = NULL;
+  SET->memory       = *ALLOCATOR;
+  SET->keySize      = KEY_SIZE;
+  SET->size         = 0;
+  SET->root         = NULL;
+
+  if (COMPARE == NULL)
+  {
+    FORGE_LOG_WARNING("[ORDERED SET] : No memory comparison function passed. Will use 'memcmp' from stdlib");
+    SET->compare = memcmp;
+  }
 }
 
 void destroyOrderedSet(OrderedSet* SET)
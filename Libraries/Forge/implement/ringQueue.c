@@ -0,0 +1,279 @@
+#include "../include/ringQueue.h"
+#include "../include/asserts.h"
+#include "../include/logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RING_QUEUE_SPIN_COUNT 128
+
+// - - - Helpers - - -
+
+static void ringQueuePause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
+}
+
+// - - - the other side cannot make progress while we spin on a single core
+static u32 ringQueueSpinCount()
+{
+  static i32 spinCount = -1;
+  i32 spins = __atomic_load_n(&spinCount, __ATOMIC_RELAXED);
+  if (spins < 0)
+  {
+    spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? RING_QUEUE_SPIN_COUNT : 0;
+    __atomic_store_n(&spinCount, spins, __ATOMIC_RELAXED);
+  }
+  return (u32)spins;
+}
+
+static inline volatile u64* ringQueueSequence(RingQueue* QUEUE, u64 POSITION)
+{
+  return (volatile u64*)(QUEUE->cells + (POSITION & QUEUE->mask) * QUEUE->stride);
+}
+
+static inline u8* ringQueueElement(RingQueue* QUEUE, u64 POSITION)
+{
+  return QUEUE->cells + (POSITION & QUEUE->mask) * QUEUE->stride + sizeof(u64);
+}
+
+// - - - the element is published before the waiter count is read, and a sleeper counts itself before checking
+// - - - the queue again, so one of the two always sees the other. Whoever wakes a sleeper also takes it off the count,
+// - - - so a burst of pushes posts once per sleeper instead of once per element
+static void ringQueueWake(Semaphore* SEM, volatile u32* WAITERS, u64 COUNT)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  u32 waiters = __atomic_load_n(WAITERS, __ATOMIC_RELAXED);
+  while (waiters > 0)
+  {
+    u32 woken = COUNT < waiters ? (u32)COUNT : waiters;
+    if (__atomic_compare_exchange_n(WAITERS, &waiters, waiters - woken, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+      semaphorePostMany(SEM, woken);
+      return;
+    }
+  }
+}
+
+// - - - counted as a sleeper but got what we wanted anyway. Take ourselves off the count, or when a waker already did,
+// - - - swallow the post it sent so the next sleeper does not wake for nothing
+static void ringQueueLeave(Semaphore* SEM, volatile u32* WAITERS)
+{
+  u32 waiters = __atomic_load_n(WAITERS, __ATOMIC_RELAXED);
+  while (waiters > 0)
+  {
+    if (__atomic_compare_exchange_n(WAITERS, &waiters, waiters - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+  }
+  semaphoreWait(SEM);
+}
+
+// - - - RingQueue - - -
+
+void createRingQueue(RingQueue* QUEUE, u64 CAPACITY, u64 ELEMENT_SIZE)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE,             "[RING QUEUE] : Cannot initialize a NULL Ring Queue");
+  FORGE_ASSERT_MESSAGE(CAPACITY > 0,      "[RING QUEUE] : Must be able to store atleast 1 element");
+  FORGE_ASSERT_MESSAGE(ELEMENT_SIZE > 0,  "[RING QUEUE] : Elements must be atleast 1 byte in size");
+
+  u64 capacity = 2;
+  while (capacity < CAPACITY) capacity <<= 1;
+  if (capacity != CAPACITY) FORGE_LOG_WARNING("[RING QUEUE] : Capacity %llu rounded up to %llu", CAPACITY, capacity);
+
+  QUEUE->capacity     = capacity;
+  QUEUE->mask         = capacity - 1;
+  QUEUE->elementSize  = ELEMENT_SIZE;
+  QUEUE->stride       = (sizeof(u64) + ELEMENT_SIZE + sizeof(u64) - 1) & ~(sizeof(u64) - 1);
+  QUEUE->cells        = (u8*)malloc(capacity * QUEUE->stride);
+  FORGE_ASSERT_MESSAGE(QUEUE->cells, "[RING QUEUE] : Failed to malloc memory for the ring queue");
+
+  // - - - a cell at position p is free to push when its sequence is p, and ready to pop when it is p + 1
+  for (u64 i = 0; i < capacity; ++i) *ringQueueSequence(QUEUE, i) = i;
+
+  QUEUE->head         = 0;
+  QUEUE->tail         = 0;
+  QUEUE->pushWaiters  = 0;
+  QUEUE->popWaiters   = 0;
+  createSemaphore(&QUEUE->notFull,  0);
+  createSemaphore(&QUEUE->notEmpty, 0);
+}
+
+void destroyRingQueue(RingQueue* QUEUE)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE, "[RING QUEUE] : Cannot destroy a NULL Ring Queue");
+
+  destroySemaphore(&QUEUE->notFull);
+  destroySemaphore(&QUEUE->notEmpty);
+  free(QUEUE->cells);
+  QUEUE->cells    = NULL;
+  QUEUE->capacity = 0;
+}
+
+bool ringQueueTryPush(RingQueue* QUEUE, const void* ELEMENT)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE,   "[RING QUEUE] : Cannot push to a NULL Ring Queue");
+  FORGE_ASSERT_MESSAGE(ELEMENT, "[RING QUEUE] : Cannot push a NULL element");
+
+  u64 position = __atomic_load_n(&QUEUE->head, __ATOMIC_RELAXED);
+  while (true)
+  {
+    u64 sequence = __atomic_load_n(ringQueueSequence(QUEUE, position), __ATOMIC_ACQUIRE);
+    i64 lag      = (i64)(sequence - position);
+
+    // - - - free for this lap, claim it. A failed claim reloads position and tries the next cell
+    if (lag == 0)
+    {
+      if (__atomic_compare_exchange_n(&QUEUE->head, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+    // - - - still holds last lap's element
+    else if (lag < 0) return false;
+    else position = __atomic_load_n(&QUEUE->head, __ATOMIC_RELAXED);
+  }
+
+  memcpy(ringQueueElement(QUEUE, position), ELEMENT, QUEUE->elementSize);
+  __atomic_store_n(ringQueueSequence(QUEUE, position), position + 1, __ATOMIC_RELEASE);
+  ringQueueWake(&QUEUE->notEmpty, &QUEUE->popWaiters, 1);
+  return true;
+}
+
+bool ringQueueTryPop(RingQueue* QUEUE, void* ELEMENT)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE,   "[RING QUEUE] : Cannot pop from a NULL Ring Queue");
+  FORGE_ASSERT_MESSAGE(ELEMENT, "[RING QUEUE] : Cannot pop into a NULL element");
+
+  u64 position = __atomic_load_n(&QUEUE->tail, __ATOMIC_RELAXED);
+  while (true)
+  {
+    u64 sequence = __atomic_load_n(ringQueueSequence(QUEUE, position), __ATOMIC_ACQUIRE);
+    i64 lag      = (i64)(sequence - (position + 1));
+
+    if (lag == 0)
+    {
+      if (__atomic_compare_exchange_n(&QUEUE->tail, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+    // - - - nothing pushed here yet
+    else if (lag < 0) return false;
+    else position = __atomic_load_n(&QUEUE->tail, __ATOMIC_RELAXED);
+  }
+
+  memcpy(ELEMENT, ringQueueElement(QUEUE, position), QUEUE->elementSize);
+  // - - - hand the cell to the push one lap ahead
+  __atomic_store_n(ringQueueSequence(QUEUE, position), position + QUEUE->capacity, __ATOMIC_RELEASE);
+  ringQueueWake(&QUEUE->notFull, &QUEUE->pushWaiters, 1);
+  return true;
+}
+
+u64 ringQueueTryPushBatch(RingQueue* QUEUE, const void* ELEMENTS, u64 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE,               "[RING QUEUE] : Cannot push to a NULL Ring Queue");
+  FORGE_ASSERT_MESSAGE(ELEMENTS || !COUNT,  "[RING QUEUE] : Cannot push NULL elements");
+
+  u64 position = __atomic_load_n(&QUEUE->head, __ATOMIC_RELAXED);
+  u64 claimed  = 0;
+  while (true)
+  {
+    // - - - a free cell stays free until someone claims its position, so counting them first and claiming all at once is safe
+    claimed = 0;
+    while (claimed < COUNT && __atomic_load_n(ringQueueSequence(QUEUE, position + claimed), __ATOMIC_ACQUIRE) == position + claimed) claimed++;
+    if (claimed == 0)
+    {
+      u64 sequence = __atomic_load_n(ringQueueSequence(QUEUE, position), __ATOMIC_ACQUIRE);
+      if ((i64)(sequence - position) < 0) return 0;
+      position = __atomic_load_n(&QUEUE->head, __ATOMIC_RELAXED);
+      continue;
+    }
+    if (__atomic_compare_exchange_n(&QUEUE->head, &position, position + claimed, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+  }
+
+  const u8* elements = (const u8*)ELEMENTS;
+  for (u64 i = 0; i < claimed; ++i) memcpy(ringQueueElement(QUEUE, position + i), elements + i * QUEUE->elementSize, QUEUE->elementSize);
+  for (u64 i = 0; i < claimed; ++i) __atomic_store_n(ringQueueSequence(QUEUE, position + i), position + i + 1, __ATOMIC_RELEASE);
+  ringQueueWake(&QUEUE->notEmpty, &QUEUE->popWaiters, claimed);
+  return claimed;
+}
+
+u64 ringQueueTryPopBatch(RingQueue* QUEUE, void* ELEMENTS, u64 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE,               "[RING QUEUE] : Cannot pop from a NULL Ring Queue");
+  FORGE_ASSERT_MESSAGE(ELEMENTS || !COUNT,  "[RING QUEUE] : Cannot pop into NULL elements");
+
+  u64 position = __atomic_load_n(&QUEUE->tail, __ATOMIC_RELAXED);
+  u64 claimed  = 0;
+  while (true)
+  {
+    claimed = 0;
+    while (claimed < COUNT && __atomic_load_n(ringQueueSequence(QUEUE, position + claimed), __ATOMIC_ACQUIRE) == position + claimed + 1) claimed++;
+    if (claimed == 0)
+    {
+      u64 sequence = __atomic_load_n(ringQueueSequence(QUEUE, position), __ATOMIC_ACQUIRE);
+      if ((i64)(sequence - (position + 1)) < 0) return 0;
+      position = __atomic_load_n(&QUEUE->tail, __ATOMIC_RELAXED);
+      continue;
+    }
+    if (__atomic_compare_exchange_n(&QUEUE->tail, &position, position + claimed, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+  }
+
+  u8* elements = (u8*)ELEMENTS;
+  for (u64 i = 0; i < claimed; ++i) memcpy(elements + i * QUEUE->elementSize, ringQueueElement(QUEUE, position + i), QUEUE->elementSize);
+  for (u64 i = 0; i < claimed; ++i) __atomic_store_n(ringQueueSequence(QUEUE, position + i), position + i + QUEUE->capacity, __ATOMIC_RELEASE);
+  ringQueueWake(&QUEUE->notFull, &QUEUE->pushWaiters, claimed);
+  return claimed;
+}
+
+void ringQueuePush(RingQueue* QUEUE, const void* ELEMENT)
+{
+  u32 spins = ringQueueSpinCount();
+  for (u32 i = 0; i < spins; ++i)
+  {
+    if (ringQueueTryPush(QUEUE, ELEMENT)) return;
+    ringQueuePause();
+  }
+
+  // - - - count ourselves in before the last check, a pop after it then has to post
+  while (true)
+  {
+    __atomic_add_fetch(&QUEUE->pushWaiters, 1, __ATOMIC_SEQ_CST);
+    if (ringQueueTryPush(QUEUE, ELEMENT))
+    {
+      ringQueueLeave(&QUEUE->notFull, &QUEUE->pushWaiters);
+      return;
+    }
+    semaphoreWait(&QUEUE->notFull);
+    if (ringQueueTryPush(QUEUE, ELEMENT)) return;
+  }
+}
+
+void ringQueuePop(RingQueue* QUEUE, void* ELEMENT)
+{
+  u32 spins = ringQueueSpinCount();
+  for (u32 i = 0; i < spins; ++i)
+  {
+    if (ringQueueTryPop(QUEUE, ELEMENT)) return;
+    ringQueuePause();
+  }
+
+  while (true)
+  {
+    __atomic_add_fetch(&QUEUE->popWaiters, 1, __ATOMIC_SEQ_CST);
+    if (ringQueueTryPop(QUEUE, ELEMENT))
+    {
+      ringQueueLeave(&QUEUE->notEmpty, &QUEUE->popWaiters);
+      return;
+    }
+    semaphoreWait(&QUEUE->notEmpty);
+    if (ringQueueTryPop(QUEUE, ELEMENT)) return;
+  }
+}
+
+u64 ringQueueSize(RingQueue* QUEUE)
+{
+  FORGE_ASSERT_MESSAGE(QUEUE, "[RING QUEUE] : Cannot get the size of a NULL Ring Queue");
+
+  u64 tail = __atomic_load_n(&QUEUE->tail, __ATOMIC_ACQUIRE);
+  u64 head = __atomic_load_n(&QUEUE->head, __ATOMIC_ACQUIRE);
+  // - - - pops may have moved tail past the head we read
+  return head > tail ? head - tail : 0;
+}
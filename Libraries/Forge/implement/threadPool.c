@@ -1,330 +1,2341 @@
+#define _GNU_SOURCE
 #include "../include/threadPool.h"
 #include "../include/asserts.h"
 #include "../include/logger.h"
 #include <pthread.h>
 #include <sys/prctl.h>
 #include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <stdint.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
+#include <dirent.h>
+#include <errno.h>
 
 
 // - - - Prototypes - - - 
 
-static ThreadPool     POOL;
-static volatile bool  created = false;
-static volatile bool  running = false;
+#define TASK_DEQUE_INITIAL_CAPACITY 256
+#define STEAL_ATTEMPTS              4
+#define TASK_CHUNK_SIZE             256
+#define TASK_CACHE_LIMIT            1024
+#define SEMAPHORE_SPIN_COUNT        128
+#define TOPOLOGY_MAX_NODES          64
+#define NORMAL_LANE_TURN            8     // - - - every 8th pull prefers the normal lane
+#define BACKGROUND_LANE_TURN        32    // - - - every 32nd pull prefers the background lane
+#define QUEUE_TURN                  16    // - - - every 16th task search of a thread starts at the shared queue
+#define THREAD_POOL_GROW_AFTER      1000000ULL      // - - - 1 ms of queue wait before an elastic pool grows
+#define THREAD_POOL_RETIRE_AFTER    2000000000ULL   // - - - 2 s of idling before an extra thread exits
+#define TIMER_TICK                  1000000ULL      // - - - wheel resolution, 1 ms
+#define TIMER_LEVEL_BITS            6
+#define TIMER_SLOTS                 (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVELS                6               // - - - 64^6 ticks, a bit over two years
+
+typedef struct TaskChunk
+{
+  struct TaskChunk*         next;
+  Task                      tasks[TASK_CHUNK_SIZE];
+} TaskChunk;
+
+// - - - hierarchical timing wheel : level L holds timers due in [64^L, 64^(L+1)) ticks, one slot per 64^L ticks.
+// - - - higher levels are poured into lower ones as time reaches them
+typedef struct TimerWheel
+{
+  Lock                      lock;
+  Semaphore                 wake;       // - - - posted when an earlier timer arrives or the pool stops
+  pthread_t                 thread;
+  bool                      started;
+  bool                      stopping;
+  u64                       current;    // - - - next tick to process, every earlier one has fired
+  u64                       count;      // - - - pending timers
+  u64                       sleepUntil; // - - - tick the thread sleeps until, an earlier timer wakes it
+  u64                       occupied[TIMER_LEVELS];   // - - - bit per non empty slot, finds the next one without a scan
+  Timer*                    slots[TIMER_LEVELS][TIMER_SLOTS];
+} TimerWheel;
+
+typedef struct TaskDequeBuffer
+{
+  i64                       capacity;   // - - - always a power of 2
+  struct TaskDequeBuffer*   retired;    // - - - smaller buffer this one replaced, thieves may still be reading it
+  Task*                     tasks[];
+} TaskDequeBuffer;
+
+// - - - the pool behind the free functions
+static ThreadPool     DEFAULT_POOL;
+
+// - - - the pool thread running the current code, NULL for threads outside the pool
+static __thread Thread* currentThread       = NULL;
+
+// - - - victim picking for threads outside the pool that help run tasks
+static __thread u64     externalRandomState = 0;
+
+static bool timerWheelCreate  (ThreadPool* POOL);
+static void timerWheelDestroy (ThreadPool* POOL);
+
+
+// - - - Topology - - - 
+
+// - - - which NUMA node every usable cpu belongs to, read once from /sys
+typedef struct Topology
+{
+  u32   cpuCount;                   // - - - cpus this process may run on
+  u16   nodeOf[CPU_SETSIZE];
+  u16   compact[CPU_SETSIZE];       // - - - usable cpus, one node after the other
+  u16   scatter[CPU_SETSIZE];       // - - - usable cpus, taking turns between the nodes
+  u32   nodeCount;                  // - - - 1 when /sys has no NUMA information
+} Topology;
+
+static Topology       topology;
+static pthread_once_t topologyOnce = PTHREAD_ONCE_INIT;
+
+// - - - "0-3,8-11" style lists from /sys
+static void topologyReadCpuList(const char* PATH, u16 NODE)
+{
+  FILE* file = fopen(PATH, "r");
+  if (!file) return;
+
+  char line[4096];
+  if (fgets(line, sizeof(line), file))
+  {
+    char* cursor = line;
+    while (*cursor && *cursor != '\n')
+    {
+      char* end;
+      long  first = strtol(cursor, &end, 10);
+      if (end == cursor) break;
+      long  last  = first;
+      if (*end == '-') last = strtol(end + 1, &end, 10);
+
+      for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) topology.nodeOf[cpu] = NODE;
+      cursor = (*end == ',') ? end + 1 : end;
+    }
+  }
+  fclose(file);
+}
+
+static void topologyLoad()
+{
+  memset(&topology, 0, sizeof(topology));
+  topology.nodeCount = 1;
+
+  DIR* nodes = opendir("/sys/devices/system/node");
+  if (nodes)
+  {
+    struct dirent* entry;
+    while ((entry = readdir(nodes)) != NULL)
+    {
+      char* end;
+      if (strncmp(entry->d_name, "node", 4) != 0) continue;
+      long node = strtol(entry->d_name + 4, &end, 10);
+      if (end == entry->d_name + 4 || *end != '\0' || node < 0 || node >= TOPOLOGY_MAX_NODES) continue;
+
+      char path[300];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+      topologyReadCpuList(path, (u16)node);
+      if ((u32)node + 1 > topology.nodeCount) topology.nodeCount = (u32)node + 1;
+    }
+    closedir(nodes);
+  }
+
+  // - - - only the cpus this process may run on
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+  {
+    i64 online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (i64 cpu = 0; cpu < online && cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &allowed);
+  }
+
+  for (u32 node = 0; node < topology.nodeCount; ++node)
+  {
+    for (u32 cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &allowed) && topology.nodeOf[cpu] == node) topology.compact[topology.cpuCount++] = (u16)cpu;
+    }
+  }
+
+  // - - - round r takes the r-th cpu of every node that still has one
+  u32 taken = 0;
+  for (u32 round = 0; taken < topology.cpuCount; ++round)
+  {
+    u32 seen = 0;
+    for (u32 i = 0; i < topology.cpuCount; ++i)
+    {
+      u16 node = topology.nodeOf[topology.compact[i]];
+      seen     = (i > 0 && topology.nodeOf[topology.compact[i - 1]] == node) ? seen + 1 : 0;
+      if (seen == round) topology.scatter[taken++] = topology.compact[i];
+    }
+  }
+
+  FORGE_LOG_TRACE("[THREAD POOL] : Found %u usable cpus on %u NUMA nodes", topology.cpuCount, topology.nodeCount);
+}
+
+// - - - cpu for the ID'th thread of a pool, -1 to leave it to the scheduler
+static i32 topologyPickCpu(const ThreadPoolConfig* CONFIG, u32 ID)
+{
+  pthread_once(&topologyOnce, topologyLoad);
+
+  switch (CONFIG->pinning)
+  {
+    case THREAD_POOL_PIN_COMPACT: return topology.cpuCount ? topology.compact[ID % topology.cpuCount] : -1;
+    case THREAD_POOL_PIN_SCATTER: return topology.cpuCount ? topology.scatter[ID % topology.cpuCount] : -1;
+    case THREAD_POOL_PIN_LIST:    return (CONFIG->cpus && CONFIG->cpuCount) ? (i32)CONFIG->cpus[ID % CONFIG->cpuCount] : -1;
+    default:                      return -1;
+  }
+}
+
+static u32 topologyNodeOf(i32 CPU)
+{
+  pthread_once(&topologyOnce, topologyLoad);
+  if (CPU < 0 || CPU >= CPU_SETSIZE) return 0;
+  return topology.nodeOf[CPU];
+}
+
+// - - - pages prefer NODE, any node will do when that one is full. Page granular, meant for per thread buffers
+static void* topologyAllocate(u64 SIZE, u32 NODE)
+{
+  void* memory = mmap(NULL, SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) return NULL;
+
+  if (topology.nodeCount > 1)
+  {
+    unsigned long mask[TOPOLOGY_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    mask[NODE / (8 * sizeof(unsigned long))] |= 1UL << (NODE % (8 * sizeof(unsigned long)));
+
+    // - - - failing only costs locality, the pages still come from first touch
+    if (syscall(SYS_mbind, memory, SIZE, MPOL_PREFERRED, mask, TOPOLOGY_MAX_NODES + 1, 0) != 0)
+    {
+      FORGE_LOG_TRACE("[THREAD POOL] : mbind to node %u failed, relying on first touch", NODE);
+    }
+  }
+  return memory;
+}
+
+
+// - - -  Semaphore - - - 
+
+static void semaphorePause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
+}
+
+// - - - sleeps only while VALUE still holds EXPECTED, the kernel checks that atomically.
+// - - - DEADLINE is absolute CLOCK_MONOTONIC or NULL for none, false once it passed
+static bool futexWait(volatile u32* VALUE, u32 EXPECTED, const struct timespec* DEADLINE)
+{
+  if (!DEADLINE) return syscall(SYS_futex, VALUE, FUTEX_WAIT_PRIVATE, EXPECTED, NULL, NULL, 0) == 0 || errno != ETIMEDOUT;
+  return syscall(SYS_futex, VALUE, FUTEX_WAIT_BITSET_PRIVATE, EXPECTED, DEADLINE, NULL, FUTEX_BITSET_MATCH_ANY) == 0 || errno != ETIMEDOUT;
+}
+
+static void futexWake(volatile u32* VALUE, u32 COUNT)
+{
+  syscall(SYS_futex, VALUE, FUTEX_WAKE_PRIVATE, COUNT > INT32_MAX ? INT32_MAX : COUNT, NULL, NULL, 0);
+}
+
+// - - - grab one of COUNTER without ever taking it below zero
+static bool semaphoreTake(volatile i32* COUNTER)
+{
+  i32 value = __atomic_load_n(COUNTER, __ATOMIC_RELAXED);
+  while (value > 0)
+  {
+    if (__atomic_compare_exchange_n(COUNTER, &value, value - 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return true;
+  }
+  return false;
+}
+
+void createSemaphore(Semaphore* SEM, u32 VALUE)
+{
+  FORGE_ASSERT_MESSAGE(SEM, "Cannot initialize a NULL  Semaphore");
+  FORGE_ASSERT_MESSAGE(VALUE <= INT32_MAX, "Semaphore value is too large");
+
+  SEM->count    = (i32)VALUE;
+  SEM->wakeups  = 0;
+}
+
+void destroySemaphore(Semaphore* SEM)
+{
+  FORGE_ASSERT_MESSAGE(SEM, "Cannot destroy a NULL  Semaphore");
+  FORGE_ASSERT_MESSAGE(__atomic_load_n(&SEM->count, __ATOMIC_ACQUIRE) >= 0, "Cannot destroy a Semaphore while threads are waiting on it");
+}
+
+static bool semaphoreWaitUntil(Semaphore* SEM, const struct timespec* DEADLINE)
+{
+  // - - - a post usually comes soon, spinning is much cheaper than a trip through the scheduler.
+  // - - - not on a single core though, the poster cannot run while we spin
+  static i32 spinCount = -1;
+  i32 spins = __atomic_load_n(&spinCount, __ATOMIC_RELAXED);
+  if (spins < 0)
+  {
+    spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SEMAPHORE_SPIN_COUNT : 0;
+    __atomic_store_n(&spinCount, spins, __ATOMIC_RELAXED);
+  }
+
+  for (i32 spin = 0; spin < spins; ++spin)
+  {
+    if (semaphoreTake(&SEM->count)) return true;
+    semaphorePause();
+  }
+
+  // - - - still positive, we got a post. Otherwise we are counted as a waiter and the next post hands us a wakeup
+  if (__atomic_fetch_sub(&SEM->count, 1, __ATOMIC_ACQUIRE) > 0) return true;
+
+  while (!semaphoreTake((volatile i32*)&SEM->wakeups))
+  {
+    if (futexWait(&SEM->wakeups, 0, DEADLINE)) continue;
+
+    // - - - timed out : stop being counted as a waiter, unless a post already counted us and its wakeup is on the way
+    i32 count = __atomic_load_n(&SEM->count, __ATOMIC_RELAXED);
+    while (count < 0)
+    {
+      if (__atomic_compare_exchange_n(&SEM->count, &count, count + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return false;
+    }
+    while (!semaphoreTake((volatile i32*)&SEM->wakeups)) futexWait(&SEM->wakeups, 0, NULL);
+    return true;
+  }
+  return true;
+}
+
+void semaphoreWait(Semaphore* SEM)
+{
+  FORGE_ASSERT_MESSAGE(SEM, "Cannot wait on a NULL  Semaphore");
+  semaphoreWaitUntil(SEM, NULL);
+}
+
+bool semaphoreWaitFor(Semaphore* SEM, u64 NANOSECONDS)
+{
+  FORGE_ASSERT_MESSAGE(SEM, "Cannot wait on a NULL  Semaphore");
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  u64 nanoseconds   = (u64)deadline.tv_nsec + NANOSECONDS % 1000000000ULL;
+  deadline.tv_sec  += NANOSECONDS / 1000000000ULL + nanoseconds / 1000000000ULL;
+  deadline.tv_nsec  = nanoseconds % 1000000000ULL;
+  return semaphoreWaitUntil(SEM, &deadline);
+}
+
+void semaphorePost(Semaphore* SEM)
+{
+  semaphorePostMany(SEM, 1);
+}
+
+void semaphorePostMany(Semaphore* SEM, u32 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(SEM, "Cannot post to a NULL  Semaphore");
+  if (COUNT == 0) return;
+
+  // - - - no waiters, no system call. Waiters already woken are not counted again, so a burst wakes each one once
+  i32 previous = __atomic_fetch_add(&SEM->count, (i32)COUNT, __ATOMIC_RELEASE);
+  if (previous >= 0) return;
+
+  u32 release = (u32)-previous < COUNT ? (u32)-previous : COUNT;
+  __atomic_add_fetch(&SEM->wakeups, release, __ATOMIC_RELEASE);
+  futexWake(&SEM->wakeups, release);
+}
+
+
+// - - - Telemetry - - - 
+
+static u64 telemetryNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static u32 histogramBucket(u64 VALUE)
+{
+  if (VALUE < 4) return (u32)VALUE;
+  u32 exponent = 63 - __builtin_clzll(VALUE);
+  u32 mantissa = (u32)(VALUE >> (exponent - 2)) & 3;
+  return (exponent - 1) * 4 + mantissa;
+}
+
+// - - - largest value that still lands in BUCKET
+static u64 histogramBucketTop(u32 BUCKET)
+{
+  if (BUCKET < 4) return BUCKET;
+  u32 exponent = BUCKET / 4 + 1;
+  u64 mantissa = BUCKET % 4;
+  u64 bottom   = (4 + mantissa) << (exponent - 2);
+  return bottom + (1ULL << (exponent - 2)) - 1;
+}
+
+// - - - the owner is the only writer, relaxed plain stores keep concurrent snapshots well defined without lock prefixes
+#define TELEMETRY_ADD(FIELD, VALUE) __atomic_store_n(&(FIELD), __atomic_load_n(&(FIELD), __ATOMIC_RELAXED) + (VALUE), __ATOMIC_RELAXED)
+#define TELEMETRY_MAX(FIELD, VALUE) do { if ((VALUE) > __atomic_load_n(&(FIELD), __ATOMIC_RELAXED)) __atomic_store_n(&(FIELD), (VALUE), __ATOMIC_RELAXED); } while (0)
+
+static void histogramRecord(ThreadPoolHistogram* HISTOGRAM, u64 VALUE)
+{
+  TELEMETRY_ADD(HISTOGRAM->counts[histogramBucket(VALUE)], 1);
+  TELEMETRY_ADD(HISTOGRAM->total, 1);
+  TELEMETRY_ADD(HISTOGRAM->sum,   VALUE);
+  TELEMETRY_MAX(HISTOGRAM->max,   VALUE);
+}
+
+// - - - telemetry times the wait, the supervisor of an elastic pool watches how old the queue gets
+static bool taskStamped(ThreadPool* POOL)
+{
+  return POOL->telemetry || POOL->elastic;
+}
+
+static void taskStamp(ThreadPool* POOL, Task* TASK)
+{
+  if (taskStamped(POOL)) TASK->enqueuedAt = telemetryNow();
+}
+
+
+// - - - Task Memory - - - 
+
+static Task* taskChunkCreate(ThreadPool* POOL)
+{
+  TaskChunk* chunk = (TaskChunk*)malloc(sizeof(TaskChunk));
+  FORGE_ASSERT_MESSAGE(chunk, "[THREAD POOL] : Failed to allocate memory for a chunk of tasks");
+
+  for (u32 i = 0; i < TASK_CHUNK_SIZE; ++i)
+  {
+    chunk->tasks[i].pooled    = true;
+    chunk->tasks[i].previous  = (i + 1 < TASK_CHUNK_SIZE) ? &chunk->tasks[i + 1] : NULL;
+  }
+
+  chunk->next = __atomic_load_n(&POOL->taskChunks, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&POOL->taskChunks, &chunk->next, chunk, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+
+  return chunk->tasks;
+}
+
+// - - - takes at most half a cache worth of tasks off the returned stack, so a thread cache never holds much more
+// - - - than TASK_CACHE_LIMIT and spilling it stays short. Returns how many were taken
+static u32 taskTakeReturned(ThreadPool* POOL, Task** FREE_TASKS)
+{
+  // - - - taking the whole returned stack at once cannot suffer from ABA
+  Task* taken = __atomic_exchange_n(&POOL->returnedTasks, NULL, __ATOMIC_ACQUIRE);
+  if (taken == NULL) return 0;
+
+  u32   count = 1;
+  Task* last  = taken;
+  while (last->previous && count < TASK_CACHE_LIMIT / 2)
+  {
+    last = last->previous;
+    count++;
+  }
+
+  Task* rest      = last->previous;
+  last->previous  = NULL;
+  *FREE_TASKS     = taken;
+
+  // - - - the rest goes back without walking it, which only works on an empty stack. Whatever was pushed in the
+  // - - - meantime is taken off again and put in front of it
+  while (rest)
+  {
+    Task* expected = NULL;
+    if (__atomic_compare_exchange_n(&POOL->returnedTasks, &expected, rest, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) break;
+
+    Task* pushed = __atomic_exchange_n(&POOL->returnedTasks, NULL, __ATOMIC_ACQUIRE);
+    if (pushed == NULL) continue;
+
+    Task* tail = pushed;
+    while (tail->previous) tail = tail->previous;
+    tail->previous = rest;
+    rest           = pushed;
+  }
+  return count;
+}
+
+// - - - FREE_TASKS is owned by the caller, either a thread cache or the queue free list under its lock.
+// - - - FREE_COUNT is the length of a thread cache and kept in step with it, NULL for the queue
+static Task* taskAllocate(ThreadPool* POOL, Task** FREE_TASKS, u32* FREE_COUNT)
+{
+  if (*FREE_TASKS == NULL)
+  {
+    u32 count = taskTakeReturned(POOL, FREE_TASKS);
+    if (*FREE_TASKS == NULL)
+    {
+      *FREE_TASKS = taskChunkCreate(POOL);
+      count       = TASK_CHUNK_SIZE;
+    }
+    if (FREE_COUNT) *FREE_COUNT = count;
+  }
+
+  Task* task  = *FREE_TASKS;
+  *FREE_TASKS = task->previous;
+  if (FREE_COUNT) (*FREE_COUNT)--;
+  return task;
+}
+
+// - - - SELF is NULL for threads outside the pool, they have no cache and return the task right away
+static void taskRelease(ThreadPool* POOL, Thread* SELF, Task* TASK)
+{
+  if (SELF == NULL)
+  {
+    TASK->previous = __atomic_load_n(&POOL->returnedTasks, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&POOL->returnedTasks, &TASK->previous, TASK, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+    return;
+  }
+
+  TASK->previous  = SELF->freeTasks;
+  SELF->freeTasks = TASK;
+  if (++SELF->freeTaskCount < TASK_CACHE_LIMIT) return;
+
+  // - - - the cache is full, hand everything back so pushes from outside the pool can reuse it
+  Task* last = TASK;
+  while (last->previous) last = last->previous;
+
+  last->previous = __atomic_load_n(&POOL->returnedTasks, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&POOL->returnedTasks, &last->previous, TASK, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+
+  SELF->freeTasks     = NULL;
+  SELF->freeTaskCount = 0;
+}
+
+static void taskMemoryDestroy(ThreadPool* POOL)
+{
+  TaskChunk* chunk = POOL->taskChunks;
+  while (chunk)
+  {
+    TaskChunk* tmp = chunk;
+    chunk          = chunk->next;
+    free(tmp);
+  }
+
+  POOL->taskChunks     = NULL;
+  POOL->returnedTasks  = NULL;
+}
+
+
+// - - - Task Queue - - - 
+
+static bool taskQueueInit(ThreadPool* POOL)
+{
+  TaskQueue* queue = &POOL->taskQueue;
+  if (pthread_mutex_init(&queue->readWriteLock, NULL) != 0)
+  {
+    FORGE_LOG_ERROR("[THREAD POOL] : Failed to create read write lock for the queue");
+    return false;
+  };    
+  createSemaphore(&queue->availability, 0);
+
+  for (u32 lane = 0; lane < TASK_PRIORITY_COUNT; ++lane)
+  {
+    queue->lanes[lane].front  = NULL;
+    queue->lanes[lane].end    = NULL;
+    queue->lanes[lane].size   = 0;
+  }
+  queue->size           = 0;
+  queue->pulls          = 0;
+  queue->sizeHighWater  = 0;
+  queue->freeTasks  = NULL;
+
+  return true;
+}
+
+static void taskQueueDestroy(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  TaskQueue* queue = &POOL->taskQueue;
+
+  // - - - queued tasks are either in the task chunks or owned by the caller, nothing to free
+  pthread_mutex_lock(&queue->readWriteLock);
+  for (u32 lane = 0; lane < TASK_PRIORITY_COUNT; ++lane)
+  {
+    queue->lanes[lane].front  = NULL;
+    queue->lanes[lane].end    = NULL;
+  }
+  queue->freeTasks  = NULL;
+
+  pthread_mutex_unlock  (&queue->readWriteLock);
+  pthread_mutex_destroy (&queue->readWriteLock);
+  destroySemaphore      (&queue->availability);
+}
+
+// - - - caller holds the readWriteLock
+static void taskQueueLink(TaskQueue* QUEUE, Task* TASK, TaskPriority PRIORITY)
+{
+  TaskLane* lane    = &QUEUE->lanes[PRIORITY];
+  TASK->previous    = NULL;
+
+  if (lane->size == 0)
+  {
+    lane->front = TASK;
+    lane->end   = TASK;
+  }
+  else 
+  {
+    lane->end->previous = TASK;
+    lane->end           = TASK;
+  }
+
+  __atomic_store_n(&lane->size,   lane->size   + 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&QUEUE->size,  QUEUE->size  + 1, __ATOMIC_RELAXED);
+  if (QUEUE->size > QUEUE->sizeHighWater) QUEUE->sizeHighWater = QUEUE->size;
+}
+
+static void taskQueuePush(ThreadPool* POOL, Task* TASK, TaskPriority PRIORITY)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  TaskQueue* queue = &POOL->taskQueue;
+
+  pthread_mutex_lock(&queue->readWriteLock);
+  taskQueueLink(queue, TASK, PRIORITY);
+  pthread_mutex_unlock(&queue->readWriteLock);
+}
+
+// - - - recycled task and queue slot under a single lock
+static void taskQueuePushNew(ThreadPool* POOL, void (*FUNCTION)(void*), void* ARGUMENT, TaskPriority PRIORITY)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  TaskQueue* queue = &POOL->taskQueue;
+
+  pthread_mutex_lock(&queue->readWriteLock);
+  Task* task      = taskAllocate(POOL, &queue->freeTasks, NULL);
+  task->function  = FUNCTION;
+  task->argument  = ARGUMENT;
+  taskStamp(POOL, task);
+  taskQueueLink(queue, task, PRIORITY);
+  pthread_mutex_unlock(&queue->readWriteLock);
+}
+
+// - - - the whole batch under a single lock
+static void taskQueuePushNewBatch(ThreadPool* POOL, void (**FUNCTIONS)(void*), void** ARGUMENTS, u64 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  TaskQueue* queue = &POOL->taskQueue;
+
+  u64 now = taskStamped(POOL) ? telemetryNow() : 0;
+
+  pthread_mutex_lock(&queue->readWriteLock);
+  for (u64 i = 0; i < COUNT; ++i)
+  {
+    Task* task        = taskAllocate(POOL, &queue->freeTasks, NULL);
+    task->function    = FUNCTIONS[i];
+    task->argument    = ARGUMENTS ? ARGUMENTS[i] : NULL;
+    task->enqueuedAt  = now;
+    taskQueueLink(queue, task, TASK_PRIORITY_NORMAL);
+  }
+  pthread_mutex_unlock(&queue->readWriteLock);
+}
+
+// - - - caller holds the readWriteLock and the queue is not empty
+static TaskLane* taskQueuePickLane(TaskQueue* QUEUE)
+{
+  TaskLane* lanes = QUEUE->lanes;
+  u64       turn  = QUEUE->pulls++;
+
+  // - - - a steady stream of urgent work must not starve the lanes below it
+  if (turn % BACKGROUND_LANE_TURN == BACKGROUND_LANE_TURN - 1 && lanes[TASK_PRIORITY_BACKGROUND].size > 0) return &lanes[TASK_PRIORITY_BACKGROUND];
+  if (turn % NORMAL_LANE_TURN     == NORMAL_LANE_TURN     - 1 && lanes[TASK_PRIORITY_NORMAL].size     > 0) return &lanes[TASK_PRIORITY_NORMAL];
+
+  for (u32 lane = 0; lane < TASK_PRIORITY_COUNT; ++lane)
+  {
+    if (lanes[lane].size > 0) return &lanes[lane];
+  }
+  return NULL;
+}
+
+static Task* taskQueuePull(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  TaskQueue* queue  = &POOL->taskQueue;
+
+  // - - - cheap check first so idle threads do not hammer the lock
+  if (__atomic_load_n(&queue->size, __ATOMIC_RELAXED) == 0) return NULL;
+
+  pthread_mutex_lock(&queue->readWriteLock);
+  Task*      task   = NULL;
+
+  if (queue->size > 0)
+  {
+    TaskLane* lane  = taskQueuePickLane(queue);
+    task            = lane->front;
+    lane->front     = task->previous;
+    if (lane->front == NULL) lane->end = NULL;
+
+    __atomic_store_n(&lane->size,  lane->size  - 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&queue->size, queue->size - 1, __ATOMIC_RELAXED);
+  }
+
+  pthread_mutex_unlock(&queue->readWriteLock);
+  return task;
+}
+
+
+// - - - Task Deque - - -
+
+static TaskDequeBuffer* taskDequeBufferCreate(i64 CAPACITY)
+{
+  TaskDequeBuffer* buffer = (TaskDequeBuffer*)malloc(sizeof(TaskDequeBuffer) + CAPACITY * sizeof(Task*));
+  FORGE_ASSERT_MESSAGE(buffer, "[THREAD POOL] : Failed to allocate memory for the task deque");
+  
+  buffer->capacity  = CAPACITY;
+  buffer->retired   = NULL;
+  return buffer;
+}
+
+static void taskDequeInit(TaskDeque* DEQUE)
+{
+  DEQUE->top    = 0;
+  DEQUE->bottom = 0;
+  DEQUE->buffer = taskDequeBufferCreate(TASK_DEQUE_INITIAL_CAPACITY);
+}
+
+static void taskDequeDestroy(TaskDeque* DEQUE)
+{
+  // - - - tasks nobody got to are in the task chunks or owned by the caller
+  TaskDequeBuffer* buffer = DEQUE->buffer;
+  while (buffer)
+  {
+    TaskDequeBuffer* tmp = buffer;
+    buffer               = buffer->retired;
+    free(tmp);
+  }
+  DEQUE->buffer = NULL;
+}
+
+// - - - only called by the owner. The old buffer stays alive until the pool dies since thieves may still read it
+static TaskDequeBuffer* taskDequeGrow(TaskDeque* DEQUE, TaskDequeBuffer* OLD, i64 TOP, i64 BOTTOM)
+{
+  TaskDequeBuffer* buffer = taskDequeBufferCreate(OLD->capacity * 2);
+  for (i64 i = TOP; i < BOTTOM; ++i) buffer->tasks[i & (buffer->capacity - 1)] = OLD->tasks[i & (OLD->capacity - 1)];
+  buffer->retired         = OLD;
+
+  __atomic_store_n(&DEQUE->buffer, buffer, __ATOMIC_RELEASE);
+  return buffer;
+}
+
+// - - - returns how many tasks the deque holds now
+static i64 taskDequePush(TaskDeque* DEQUE, Task* TASK)
+{
+  i64               bottom  = __atomic_load_n(&DEQUE->bottom, __ATOMIC_RELAXED);
+  i64               top     = __atomic_load_n(&DEQUE->top,    __ATOMIC_ACQUIRE);
+  TaskDequeBuffer*  buffer  = __atomic_load_n(&DEQUE->buffer, __ATOMIC_RELAXED);
+
+  if (bottom - top > buffer->capacity - 1) buffer = taskDequeGrow(DEQUE, buffer, top, bottom);
+
+  __atomic_store_n(&buffer->tasks[bottom & (buffer->capacity - 1)], TASK, __ATOMIC_RELAXED);
+  __atomic_store_n(&DEQUE->bottom, bottom + 1, __ATOMIC_RELEASE);
+  return bottom + 1 - top;
+}
+
+static Task* taskDequePop(TaskDeque* DEQUE)
+{
+  i64               bottom  = __atomic_load_n(&DEQUE->bottom, __ATOMIC_RELAXED) - 1;
+  TaskDequeBuffer*  buffer  = __atomic_load_n(&DEQUE->buffer, __ATOMIC_RELAXED);
+  __atomic_store_n(&DEQUE->bottom, bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  i64               top     = __atomic_load_n(&DEQUE->top,    __ATOMIC_RELAXED);
+
+  if (top > bottom)
+  {
+    // - - - empty
+    __atomic_store_n(&DEQUE->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+
+  Task* task = __atomic_load_n(&buffer->tasks[bottom & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+  if (top == bottom)
+  {
+    // - - - last task, race against the thieves for it
+    if (!__atomic_compare_exchange_n(&DEQUE->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) task = NULL;
+    __atomic_store_n(&DEQUE->bottom, bottom + 1, __ATOMIC_RELAXED);
+  }
+  return task;
+}
+
+// - - - callable from any thread. Sets CONTENDED when it lost a race, the deque might still have tasks
+static Task* taskDequeSteal(TaskDeque* DEQUE, bool* CONTENDED)
+{
+  i64 top     = __atomic_load_n(&DEQUE->top,    __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  i64 bottom  = __atomic_load_n(&DEQUE->bottom, __ATOMIC_ACQUIRE);
+
+  if (top >= bottom) return NULL;
+
+  TaskDequeBuffer*  buffer  = __atomic_load_n(&DEQUE->buffer, __ATOMIC_ACQUIRE);
+  Task*             task    = __atomic_load_n(&buffer->tasks[top & (buffer->capacity - 1)], __ATOMIC_RELAXED);
+
+  if (!__atomic_compare_exchange_n(&DEQUE->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+  {
+    *CONTENDED = true;
+    return NULL;
+  }
+  return task;
+}
+
+// - - - a hint only, thieves may empty it right after
+static bool taskDequeIsEmpty(TaskDeque* DEQUE)
+{
+  return __atomic_load_n(&DEQUE->bottom, __ATOMIC_RELAXED) <= __atomic_load_n(&DEQUE->top, __ATOMIC_RELAXED);
+}
+
+
+// - - - Threads - - - 
+
+static u64 nextRandom(u64* STATE)
+{
+  // - - - xorshift64, good enough to spread the thieves around
+  u64 x   = *STATE;
+  x      ^= x << 13;
+  x      ^= x >> 7;
+  x      ^= x << 17;
+  *STATE  = x;
+  return x;
+}
+
+static void threadPushLocal(Thread* SELF, Task* TASK)
+{
+  u64 depth = (u64)taskDequePush(&SELF->deque, TASK);
+  TELEMETRY_MAX(SELF->stats.queueDepthHighWater, depth);
+}
+
+// - - - SELF is NULL when a thread outside the pool steals. Pool threads try their own NUMA node first.
+// - - - retired slots of an elastic pool are still visited, their deques are empty and never freed before the pool
+static Task* threadSteal(ThreadPool* POOL, Thread* SELF, u64* RANDOM_STATE)
+{
+  u32 count = __atomic_load_n(&POOL->threadSlots, __ATOMIC_ACQUIRE);
+  if (count < (SELF ? 2 : 1)) return NULL;
+
+  for (u32 attempt = 0; attempt < STEAL_ATTEMPTS; ++attempt)
+  {
+    bool contended  = false;
+    u32  start      = nextRandom(RANDOM_STATE) % count;
+
+    for (u32 pass = (SELF ? 0 : 1); pass < 2; ++pass)
+    {
+      for (u32 i = 0; i < count; ++i)
+      {
+        Thread* victim = POOL->threads[(start + i) % count];
+        if (victim == SELF) continue;
+        if (SELF && (victim->node == SELF->node) != (pass == 0)) continue;
+
+        Task* task = taskDequeSteal(&victim->deque, &contended);
+        if (task && SELF) TELEMETRY_ADD(SELF->stats.steals, 1);
+        if (task) return task;
+      }
+    }
+
+    if (!contended) break;
+  }
+
+  return NULL;
+}
+
+static Task* threadFindTask(Thread* SELF)
+{
+  // - - - urgent work from the queue first, then own work (LIFO, still hot in cache), then the rest of the queue,
+  // - - - then other threads (FIFO). Work that keeps spawning more of itself never empties the deque, so every
+  // - - - QUEUE_TURN-th search goes to the queue first and its lanes take their turns
+  Task* task;
+  if (++SELF->turns % QUEUE_TURN == 0 ||
+      __atomic_load_n(&SELF->pool->taskQueue.lanes[TASK_PRIORITY_HIGH].size, __ATOMIC_RELAXED) > 0)
+  {
+    task = taskQueuePull(SELF->pool);
+    if (task) return task;
+  }
+
+  task = taskDequePop(&SELF->deque);
+  if (task) return task;
+
+  task = taskQueuePull(SELF->pool);
+  if (task) return task;
+
+  return threadSteal(SELF->pool, SELF, &SELF->randomState);
+}
+
+static void taskFinished(ThreadPool* POOL)
+{
+  if (__atomic_sub_fetch(&POOL->numTasksPending, 1, __ATOMIC_ACQ_REL) == 0)
+  {
+    pthread_mutex_lock(&POOL->threadCountLock);
+    pthread_cond_broadcast(&POOL->allIdle);
+    pthread_mutex_unlock(&POOL->threadCountLock);
+  }
+}
+
+static void taskRun(ThreadPool* POOL, Thread* SELF, Task* TASK)
+{
+  __atomic_add_fetch(&POOL->numThreadsWorking, 1, __ATOMIC_RELAXED);
+
+  // - - - recycle before running, the task may push again and reuse the node while it is still hot.
+  // - - - intrusive tasks are not touched after this point, their function may free them
+  void (*function)(void*) = TASK->function;
+  void* argument          = TASK->argument;
+  u64   enqueuedAt        = TASK->enqueuedAt;
+  if (TASK->pooled) taskRelease(POOL, SELF, TASK);
+
+  // - - - threads outside the pool have nowhere to keep stats without sharing
+  bool  timed             = SELF && POOL->telemetry;
+  u64   start             = timed ? telemetryNow() : 0;
+
+  // - - - run the task
+  function(argument);
+
+  if (SELF)
+  {
+    TELEMETRY_ADD(SELF->stats.tasksExecuted, 1);
+    if (timed)
+    {
+      histogramRecord(&SELF->stats.queueWait, start > enqueuedAt ? start - enqueuedAt : 0);
+      histogramRecord(&SELF->stats.runTime,   telemetryNow() - start);
+    }
+  }
+
+  __atomic_sub_fetch(&POOL->numThreadsWorking, 1, __ATOMIC_RELAXED);
+  taskFinished(POOL);
+}
+
+// - - - run one queued task of POOL on the calling thread, whichever thread that is. False when none was found
+static bool threadPoolRunOne(ThreadPool* POOL)
+{
+  Thread* self = currentThread;
+  Task*   task = NULL;
+
+  if (self && self->pool == POOL)
+  {
+    task = threadFindTask(self);
+    if (task) taskRun(POOL, self, task);
+    return task != NULL;
+  }
+
+  if (externalRandomState == 0) externalRandomState = (u64)time(NULL) ^ (u64)(uintptr_t)&task;
+
+  task = taskQueuePull(POOL);
+  if (!task) task = threadSteal(POOL, NULL, &externalRandomState);
+  if (task) taskRun(POOL, NULL, task);
+  return task != NULL;
+}
+
+// - - - true when the calling thread may exit, never below the pool's minimum
+static bool threadRetire(ThreadPool* POOL)
+{
+  u32 alive = __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_RELAXED);
+  while (alive > POOL->minThreads)
+  {
+    if (__atomic_compare_exchange_n(&POOL->numThreadsAlive, &alive, alive - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return true;
+  }
+  return false;
+}
+
+static void* threadDo(void* ARG)
+{
+  Thread*     self  = (Thread*)ARG;
+  ThreadPool* POOL  = self->pool;
+  currentThread     = self;
+
+  // - - - shows up in top, gdb and perf. Linux cuts it to 15 characters
+  char name[32];
+  snprintf(name, sizeof(name), "%s-%d", POOL->name, self->id);
+  prctl(PR_SET_NAME, name, 0, 0, 0);
+
+  __atomic_add_fetch(&POOL->numThreadsAlive, 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&self->state, THREAD_STATE_RUNNING, __ATOMIC_RELEASE);
+
+  bool retired = false;
+  while (true)
+  {
+    // - - - threads of an elastic pool only wait so long before they offer to retire. Idle time is only clocked
+    // - - - with telemetry on, like the run times
+    u64  asleep = POOL->telemetry ? telemetryNow() : 0;
+    bool woken  = true;
+    if (POOL->elastic) woken = semaphoreWaitFor(&POOL->taskQueue.availability, POOL->retireAfter);
+    else               semaphoreWait(&POOL->taskQueue.availability);
+    if (POOL->telemetry) TELEMETRY_ADD(self->stats.idleNanoseconds, telemetryNow() - asleep);
+    if (!__atomic_load_n(&POOL->running, __ATOMIC_ACQUIRE)) break;
+
+    // - - - no post taken means nothing was pushed for us, the deque is empty and nobody else pushes to it
+    if (!woken)
+    {
+      if ((retired = threadRetire(POOL))) break;
+      continue;
+    }
+
+    // - - - keep going until there is nothing left anywhere, then go back to sleep
+    Task* task;
+    while (__atomic_load_n(&POOL->running, __ATOMIC_ACQUIRE) && (task = threadFindTask(self)) != NULL)
+    {
+      taskRun(POOL, self, task);
+    }
+  }
+
+  currentThread = NULL;
+  if (retired)
+  {
+    FORGE_LOG_TRACE("[THREAD POOL] : Thread %d of %s retired after idling", self->id, POOL->name);
+    __atomic_store_n(&self->state, THREAD_STATE_RETIRED, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+// - - - CPU is -1 for threads the scheduler places, the extra threads of an elastic pool always are
+static Thread* threadCreate(ThreadPool* POOL, u32 ID, i32 CPU)
+{
+  // - - - the deque indices are hammered by the owner, keep them on its node
+  u32     node          = topologyNodeOf(CPU);
+  Thread* thread        = (Thread*)(CPU >= 0 ? topologyAllocate(sizeof(Thread), node) : malloc(sizeof(Thread)));
+  FORGE_ASSERT_MESSAGE(thread, "[THREAD POOL] : Failed to allocate memory for a thread");
+
+  thread->cpu           = CPU;
+  thread->node          = node;
+  thread->id            = (i32)ID;
+  thread->pool          = POOL;
+  thread->randomState   = (u64)time(NULL) ^ (0x9E3779B97F4A7C15ULL * (ID + 1));
+  thread->turns         = 0;
+  thread->freeTasks     = NULL;
+  thread->freeTaskCount = 0;
+  thread->state         = THREAD_STATE_EMPTY;
+  memset(&thread->stats,         0, sizeof(thread->stats));
+  memset(&thread->statsBaseline, 0, sizeof(thread->statsBaseline));
+  taskDequeInit(&thread->deque);
+  return thread;
+}
+
+static void threadFree(Thread* THREAD)
+{
+  taskDequeDestroy(&THREAD->deque);
+  if (THREAD->cpu >= 0) munmap(THREAD, sizeof(Thread));
+  else                  free(THREAD);
+}
+
+static bool threadInit(ThreadPool* POOL, i32 ID)
+{
+  Thread* thread      = POOL->threads[ID];
+  __atomic_store_n(&thread->state, THREAD_STATE_STARTING, __ATOMIC_RELEASE);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  if (POOL->stackSize > 0 && pthread_attr_setstacksize(&attr, POOL->stackSize) != 0)
+  {
+    FORGE_LOG_WARNING("[THREAD POOL] : Stack size of %llu bytes rejected, using the default", POOL->stackSize);
+  }
+
+  // - - - pinned from the first instruction, so everything the thread touches first lands on its node
+  if (thread->cpu >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(thread->cpu, &cpus);
+    if (pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus) != 0)
+    {
+      FORGE_LOG_WARNING("[THREAD POOL] : Cannot pin thread %d to cpu %d, leaving it to the scheduler", ID, thread->cpu);
+    }
+  }
+
+  if (pthread_create(&thread->pthread, &attr, threadDo, (void*)thread) != 0)
+  {
+    FORGE_LOG_ERROR("[THREAD POOL] : Failed to initialize thread %d", ID);
+    __atomic_store_n(&thread->state, THREAD_STATE_EMPTY, __ATOMIC_RELEASE);
+    pthread_attr_destroy(&attr);
+    return false;
+  }
+  pthread_attr_destroy(&attr);
+
+  return true;
+}
+
+static void threadDestroy(ThreadPool* POOL, i32 ID)
+{
+  FORGE_ASSERT_MESSAGE(POOL->created, "Thread pool needs to be started first")
+
+  Thread* thread = POOL->threads[ID];
+  if (__atomic_load_n(&thread->state, __ATOMIC_ACQUIRE) != THREAD_STATE_EMPTY) pthread_join(thread->pthread, NULL);
+  __atomic_store_n(&thread->state, THREAD_STATE_EMPTY, __ATOMIC_RELAXED);
+}
+
+
+// - - - Elastic pools - - - 
+
+// - - - how long the oldest task in the shared queue has been waiting
+static u64 threadPoolOldestWait(ThreadPool* POOL, u64 NOW)
+{
+  TaskQueue* queue  = &POOL->taskQueue;
+  if (__atomic_load_n(&queue->size, __ATOMIC_RELAXED) == 0) return 0;
+
+  u64 oldest        = NOW;
+  pthread_mutex_lock(&queue->readWriteLock);
+  for (u32 lane = 0; lane < TASK_PRIORITY_COUNT; ++lane)
+  {
+    Task* front = queue->lanes[lane].front;
+    if (front && front->enqueuedAt < oldest) oldest = front->enqueuedAt;
+  }
+  pthread_mutex_unlock(&queue->readWriteLock);
+  return NOW - oldest;
+}
+
+// - - - joins the threads that retired, their slots can take new threads
+static void threadPoolReap(ThreadPool* POOL)
+{
+  u32 slots = __atomic_load_n(&POOL->threadSlots, __ATOMIC_RELAXED);
+  for (u32 i = 0; i < slots; ++i)
+  {
+    Thread* thread = POOL->threads[i];
+    if (__atomic_load_n(&thread->state, __ATOMIC_ACQUIRE) != THREAD_STATE_RETIRED) continue;
+    pthread_join(thread->pthread, NULL);
+    __atomic_store_n(&thread->state, THREAD_STATE_EMPTY, __ATOMIC_RELEASE);
+  }
+}
+
+// - - - only the supervisor starts threads once the pool is up, so the maximum cannot be overshot
+static void threadPoolGrow(ThreadPool* POOL)
+{
+  u32 slots = __atomic_load_n(&POOL->threadSlots, __ATOMIC_RELAXED);
+  i64 slot  = -1;
+  for (u32 i = 0; i < slots && slot < 0; ++i)
+  {
+    if (__atomic_load_n(&POOL->threads[i]->state, __ATOMIC_ACQUIRE) == THREAD_STATE_EMPTY) slot = i;
+  }
+
+  // - - - a new slot is published only once its thread struct is ready, thieves may look at it right away
+  if (slot < 0 && slots < POOL->maxThreads)
+  {
+    slot                = slots;
+    POOL->threads[slot] = threadCreate(POOL, (u32)slot, -1);
+    __atomic_store_n(&POOL->threadSlots, slots + 1, __ATOMIC_RELEASE);
+  }
+
+  // - - - a thread that just gave up its place has not exited yet, try again on the next tick
+  if (slot < 0 || !threadInit(POOL, (i32)slot)) return;
+  while (__atomic_load_n(&POOL->threads[slot]->state, __ATOMIC_ACQUIRE) == THREAD_STATE_STARTING) sched_yield();
+
+  FORGE_LOG_TRACE("[THREAD POOL] : %s grew to %u threads", POOL->name, __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_RELAXED));
+
+  // - - - so somebody looks at the queue right away, a spare post only costs a look
+  semaphorePost(&POOL->taskQueue.availability);
+}
+
+// - - - adds a thread whenever queued work waits too long or every thread is stuck in a task with more work behind it
+static void* threadPoolSupervise(void* ARG)
+{
+  ThreadPool* POOL  = (ThreadPool*)ARG;
+
+  char name[32];
+  snprintf(name, sizeof(name), "%s-grow", POOL->name);
+  prctl(PR_SET_NAME, name, 0, 0, 0);
+
+  u64 tick      = POOL->growAfter / 2;
+  if (tick < 50000)     tick = 50000;
+  if (tick > 10000000)  tick = 10000000;
+  u64 busySince = 0;
+
+  while (true)
+  {
+    semaphoreWaitFor(&POOL->supervisorWake, tick);
+    if (!__atomic_load_n(&POOL->running, __ATOMIC_ACQUIRE)) break;
+    threadPoolReap(POOL);
+
+    // - - - tasks in the deques of blocked threads never show up in the queue, this catches them
+    u64  now        = telemetryNow();
+    u32  alive      = __atomic_load_n(&POOL->numThreadsAlive,   __ATOMIC_RELAXED);
+    u32  working    = __atomic_load_n(&POOL->numThreadsWorking, __ATOMIC_RELAXED);
+    u64  pending    = __atomic_load_n(&POOL->numTasksPending,   __ATOMIC_RELAXED);
+    bool saturated  = working >= alive && pending > working;
+    if (!saturated)           busySince = 0;
+    else if (busySince == 0)  busySince = now;
+
+    bool starved    = threadPoolOldestWait(POOL, now) >= POOL->growAfter || (busySince && now - busySince >= POOL->growAfter);
+    if (starved && alive < POOL->maxThreads)
+    {
+      threadPoolGrow(POOL);
+      busySince = 0;
+    }
+  }
+  return NULL;
+}
+
+
+// - - - Thread pool - - - 
+
+bool createThreadPool(ThreadPool* POOL, const ThreadPoolConfig* CONFIG)
+{
+  FORGE_ASSERT_MESSAGE(POOL, "Cannot create a NULL thread pool");
+
+  ThreadPoolConfig config = { 0, 0, NULL, THREAD_POOL_PIN_NONE, NULL, 0, false, 0, 0, 0 };
+  if (CONFIG) config = *CONFIG;
+ 
+  // - - - assign the number of threads
+  POOL->numThreadsAlive     = 0;
+  POOL->numThreadsWorking   = 0;
+  POOL->numTasksPending     = 0;
+  POOL->returnedTasks       = NULL;
+  POOL->taskChunks          = NULL;
+  POOL->stackSize           = config.stackSize;
+  POOL->telemetry           = config.telemetry;
+  u32 threadCount           = config.threadCount;
+
+  snprintf(POOL->name, sizeof(POOL->name), "%s", config.name ? config.name : "forge");
+
+  if (threadCount == 0)   
+  {
+    i64 cores       = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cores > 0 ? (u32)cores : 4;
+    FORGE_LOG_WARNING("[THREAD POOL] : Creating thread pool %s with hardware defined thread count: %u", POOL->name, threadCount);
+  }
+
+  POOL->minThreads          = threadCount;
+  POOL->maxThreads          = config.maxThreadCount > threadCount ? config.maxThreadCount : threadCount;
+  POOL->elastic             = POOL->maxThreads > threadCount;
+  POOL->growAfter           = config.growAfter   ? config.growAfter   : THREAD_POOL_GROW_AFTER;
+  POOL->retireAfter         = config.retireAfter ? config.retireAfter : THREAD_POOL_RETIRE_AFTER;
+
+  FORGE_LOG_TRACE("[THREAD_POOL] : Starting %s with %u threads, at most %u", POOL->name, threadCount, POOL->maxThreads);
+
+  // - - - initialize the lock and conditional
+  pthread_mutex_init(&(POOL->threadCountLock), NULL);
+  pthread_mutex_init(&POOL->statsLock, NULL);
+  pthread_cond_init(&POOL->allIdle, NULL);
+
+  // - - - initialize task queue 
+  if (!taskQueueInit(POOL))
+  {
+    FORGE_LOG_ERROR("[THREAD POOL] : Failed to initialize task queue");
+    return false;    
+  };
+
+  // - - - make threads, all of them exist before any starts stealing from the others.
+  // - - - an elastic pool gets room for all of its slots now, thieves walk the array without a lock
+  POOL->threads = (Thread**) calloc (POOL->maxThreads, sizeof(Thread*));
+  if (POOL->threads == NULL)
+  {
+    FORGE_LOG_ERROR("[THREAD POOL] : Failed to allocate memory for threads");
+    return false;
+  }
+  for (u32 i = 0; i < threadCount; i++)
+  {
+    // - - - already taken, the supervisor must not hand these slots out
+    POOL->threads[i]        = threadCreate(POOL, i, topologyPickCpu(&config, i));
+    __atomic_store_n(&POOL->threads[i]->state, THREAD_STATE_STARTING, __ATOMIC_RELAXED);
+  }
+  POOL->threadSlots = threadCount;
+
+  POOL->running = true;
+
+  // - - - before the threads, they decide how to wait by whether it runs
+  if (POOL->elastic)
+  {
+    createSemaphore(&POOL->supervisorWake, 0);
+    if (pthread_create(&POOL->supervisor, NULL, threadPoolSupervise, POOL) != 0)
+    {
+      FORGE_LOG_WARNING("[THREAD POOL] : Failed to start the supervisor of %s, it keeps %u threads", POOL->name, threadCount);
+      destroySemaphore(&POOL->supervisorWake);
+      POOL->elastic = false;
+    }
+  }
+
+  for (u32 i = 0; i < threadCount; i++)    threadInit(POOL, i); 
+
+  FORGE_LOG_TRACE("[THREAD POOL] : Waiting for all the threads to be ready")
+  while (__atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_ACQUIRE) != threadCount){}
+  FORGE_LOG_TRACE("[THREAD POOL] : Wait finished. All the threads are ready to go");
+
+  if (!timerWheelCreate(POOL)) FORGE_LOG_WARNING("[THREAD POOL] : Failed to allocate the timer wheel of %s", POOL->name);
+
+  POOL->created = true;
+  return true;
+}
+
+void threadPoolPush(ThreadPool* POOL, void (*FUNCTION)(void*), void* ARGUMENT)
+{
+  threadPoolPushPriority(POOL, FUNCTION, ARGUMENT, TASK_PRIORITY_NORMAL);
+}
+
+void threadPoolPushPriority(ThreadPool* POOL, void (*FUNCTION)(void*), void* ARGUMENT, TaskPriority PRIORITY)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot add a NULL Function to a task");
+  FORGE_ASSERT_MESSAGE(PRIORITY < TASK_PRIORITY_COUNT, "Unknown task priority");
+
+  __atomic_add_fetch(&POOL->numTasksPending, 1, __ATOMIC_SEQ_CST);
+
+  // - - - pushed from inside a task of this pool, keep it local so it is still warm in this thread's cache.
+  // - - - other priorities go through the lanes, the deque has no notion of them
+  Thread* self = currentThread;
+  if (self && self->pool == POOL && PRIORITY == TASK_PRIORITY_NORMAL)
+  {
+    Task* newTask     = taskAllocate(POOL, &self->freeTasks, &self->freeTaskCount);
+    newTask->function = FUNCTION;
+    newTask->argument = ARGUMENT;
+    taskStamp(POOL, newTask);
+    threadPushLocal(self, newTask);
+  }
+  else taskQueuePushNew(POOL, FUNCTION, ARGUMENT, PRIORITY);
+
+  semaphorePost(&POOL->taskQueue.availability);
+}
+
+void threadPoolPushBatch(ThreadPool* POOL, void (**FUNCTIONS)(void*), void** ARGUMENTS, u64 COUNT)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(FUNCTIONS || COUNT == 0, "Cannot add NULL Functions to tasks");
+  if (COUNT == 0) return;
+
+  __atomic_add_fetch(&POOL->numTasksPending, COUNT, __ATOMIC_SEQ_CST);
+
+  Thread* self = currentThread;
+  if (self && self->pool == POOL)
+  {
+    u64 now = taskStamped(POOL) ? telemetryNow() : 0;
+    for (u64 i = 0; i < COUNT; ++i)
+    {
+      FORGE_ASSERT_MESSAGE(FUNCTIONS[i], "Cannot add a NULL Function to a task");
+      Task* newTask       = taskAllocate(POOL, &self->freeTasks, &self->freeTaskCount);
+      newTask->function   = FUNCTIONS[i];
+      newTask->argument   = ARGUMENTS ? ARGUMENTS[i] : NULL;
+      newTask->enqueuedAt = now;
+      threadPushLocal(self, newTask);
+    }
+  }
+  else taskQueuePushNewBatch(POOL, FUNCTIONS, ARGUMENTS, COUNT);
+
+  // - - - busy threads look for more work before sleeping, so only the idle ones need a wakeup.
+  // - - - one post always goes out, the idle count is only a guess and some thread must see the batch
+  u32 alive = __atomic_load_n(&POOL->numThreadsAlive,   __ATOMIC_RELAXED);
+  u32 busy  = __atomic_load_n(&POOL->numThreadsWorking, __ATOMIC_RELAXED);
+  u64 wake  = alive > busy ? alive - busy : 0;
+  if (wake > COUNT) wake = COUNT;
+  if (wake == 0)    wake = 1;
+  semaphorePostMany(&POOL->taskQueue.availability, (u32)wake);
+}
+
+void threadPoolPushIntrusive(ThreadPool* POOL, Task* TASK, void (*FUNCTION)(void*), void* ARGUMENT)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(TASK,     "Cannot push a NULL Task");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot add a NULL Function to a task");
+
+  TASK->function  = FUNCTION;
+  TASK->argument  = ARGUMENT;
+  TASK->pooled    = false;
+  taskStamp(POOL, TASK);
+
+  __atomic_add_fetch(&POOL->numTasksPending, 1, __ATOMIC_SEQ_CST);
+
+  Thread* self = currentThread;
+  if (self && self->pool == POOL) threadPushLocal(self, TASK);
+  else                            taskQueuePush(POOL, TASK, TASK_PRIORITY_NORMAL);
+
+  semaphorePost(&POOL->taskQueue.availability);
+}
+
+void threadPoolWait(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started. Call `createThreadPool` first");
+  FORGE_ASSERT_MESSAGE(currentThread == NULL || currentThread->pool != POOL, "Cannot wait for the thread pool from inside one of its tasks");
+
+  FORGE_LOG_INFO("[THREAD POOL] : Waiting for all tasks of %s to finish", POOL->name);
+  pthread_mutex_lock(&POOL->threadCountLock);  
+  u64 pending;
+  while ((pending = __atomic_load_n(&POOL->numTasksPending, __ATOMIC_ACQUIRE)) > 0)
+  {
+    FORGE_LOG_TRACE("[THREAD POOL] : Main thread waiting for all idle, current tasks pending : %llu, current threads working : %d", pending, __atomic_load_n(&POOL->numThreadsWorking, __ATOMIC_RELAXED))
+    pthread_cond_wait(&POOL->allIdle, &POOL->threadCountLock);
+  }
+  pthread_mutex_unlock(&POOL->threadCountLock);
+  FORGE_LOG_INFO("[THREAD POOL] : Finished waiting for all tasks")
+}
+
+void destroyThreadPool(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started. Call `createThreadPool` first");
+  
+  FORGE_LOG_WARNING("[THREAD POOL] : Destroying Thread Pool %s", POOL->name);
+
+  // - - - timers push tasks, they stop before the threads do. Pending ones never fire
+  timerWheelDestroy(POOL);
+
+  // - - - signal all threads to stop
+  __atomic_store_n(&POOL->running, false, __ATOMIC_RELEASE);
+
+  // - - - the supervisor goes first, after that nobody starts or reaps threads behind our back
+  if (POOL->elastic)
+  {
+    semaphorePost(&POOL->supervisorWake);
+    pthread_join(POOL->supervisor, NULL);
+    destroySemaphore(&POOL->supervisorWake);
+  }
+
+  // - - - wake up all threads, retired ones that were not joined yet are joined here too
+  u32 slots = POOL->threadSlots;
+  semaphorePostMany(&POOL->taskQueue.availability, slots);
+  for (u32 i = 0; i < slots; ++i) threadDestroy(POOL, i);
+
+  // - - - only once every thread is gone, someone might still be stealing until then
+  for (u32 i = 0; i < slots; ++i) threadFree(POOL->threads[i]);
+
+  free(POOL->threads);
+  taskQueueDestroy(POOL);
+  taskMemoryDestroy(POOL);
+
+  pthread_mutex_destroy(&POOL->threadCountLock);
+  pthread_mutex_destroy(&POOL->statsLock);
+  pthread_cond_destroy(&POOL->allIdle);
+  
+  POOL->numThreadsAlive = 0;
+  POOL->threadSlots     = 0;
+  POOL->created         = false;
+}
+
+
+void* threadPoolAllocateLocal(u64 SIZE)
+{
+  FORGE_ASSERT_MESSAGE(SIZE > 0, "Cannot allocate 0 bytes");
+
+  Thread* self = currentThread;
+  i32     cpu  = (self && self->cpu >= 0) ? self->cpu : sched_getcpu();
+  void*   memory = topologyAllocate(SIZE, topologyNodeOf(cpu));
+  FORGE_ASSERT_MESSAGE(memory, "[THREAD POOL] : Failed to allocate node local memory");
+  return memory;
+}
+
+void threadPoolFreeLocal(void* MEMORY, u64 SIZE)
+{
+  if (MEMORY) munmap(MEMORY, SIZE);
+}
+
+// - - - Telemetry - - - 
+
+// - - - relaxed loads of what the owner is writing, a snapshot may be a few tasks behind. The stats are nothing but u64
+static void workerStatsRead(const ThreadPoolWorkerStats* STATS, ThreadPoolWorkerStats* OUT)
+{
+  const u64* from = (const u64*)STATS;
+  u64*       to   = (u64*)OUT;
+  for (u64 i = 0; i < sizeof(ThreadPoolWorkerStats) / sizeof(u64); ++i) to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+}
+
+// - - - adds or subtracts every counter, maxima are kept as they are
+static void histogramAccumulate(ThreadPoolHistogram* INTO, const ThreadPoolHistogram* FROM, i32 SIGN)
+{
+  for (u32 i = 0; i < THREAD_POOL_HISTOGRAM_BUCKETS; ++i) INTO->counts[i] += SIGN * FROM->counts[i];
+  INTO->total += SIGN * FROM->total;
+  INTO->sum   += SIGN * FROM->sum;
+}
+
+static void workerStatsAccumulate(ThreadPoolWorkerStats* INTO, const ThreadPoolWorkerStats* FROM, i32 SIGN)
+{
+  INTO->tasksExecuted   += SIGN * FROM->tasksExecuted;
+  INTO->steals          += SIGN * FROM->steals;
+  INTO->idleNanoseconds += SIGN * FROM->idleNanoseconds;
+  histogramAccumulate(&INTO->queueWait, &FROM->queueWait, SIGN);
+  histogramAccumulate(&INTO->runTime,   &FROM->runTime,   SIGN);
+}
+
+// - - - caller holds statsLock
+static void workerStatsSince(Thread* THREAD, ThreadPoolWorkerStats* OUT)
+{
+  workerStatsRead(&THREAD->stats, OUT);
+  workerStatsAccumulate(OUT, &THREAD->statsBaseline, -1);
+}
+
+ThreadPoolWorkerStats threadPoolWorkerStatsSnapshot(ThreadPool* POOL, u32 WORKER)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(WORKER < __atomic_load_n(&POOL->threadSlots, __ATOMIC_ACQUIRE), "No such thread in the pool");
+
+  ThreadPoolWorkerStats stats;
+  pthread_mutex_lock(&POOL->statsLock);
+  workerStatsSince(POOL->threads[WORKER], &stats);
+  pthread_mutex_unlock(&POOL->statsLock);
+  return stats;
+}
+
+ThreadPoolStats threadPoolStatsSnapshot(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+
+  ThreadPoolStats stats;
+  memset(&stats, 0, sizeof(stats));
+  stats.threadCount = __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_RELAXED);
+
+  // - - - retired threads of an elastic pool still count, their work happened
+  u32 slots = __atomic_load_n(&POOL->threadSlots, __ATOMIC_ACQUIRE);
+  pthread_mutex_lock(&POOL->statsLock);
+  for (u32 i = 0; i < slots; ++i)
+  {
+    ThreadPoolWorkerStats worker;
+    workerStatsSince(POOL->threads[i], &worker);
+    workerStatsAccumulate(&stats.workers, &worker, 1);
+
+    if (worker.queueDepthHighWater > stats.workers.queueDepthHighWater) stats.workers.queueDepthHighWater = worker.queueDepthHighWater;
+    if (worker.queueWait.max       > stats.workers.queueWait.max)       stats.workers.queueWait.max       = worker.queueWait.max;
+    if (worker.runTime.max         > stats.workers.runTime.max)         stats.workers.runTime.max         = worker.runTime.max;
+  }
+  pthread_mutex_unlock(&POOL->statsLock);
+
+  pthread_mutex_lock(&POOL->taskQueue.readWriteLock);
+  stats.queueDepthHighWater = POOL->taskQueue.sizeHighWater;
+  pthread_mutex_unlock(&POOL->taskQueue.readWriteLock);
+  return stats;
+}
+
+void threadPoolStatsReset(ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+
+  // - - - counters cannot be zeroed under the owner's feet, the baseline is subtracted instead.
+  // - - - maxima are plain stores, losing a race only leaves one stale maximum
+  pthread_mutex_lock(&POOL->statsLock);
+  u32 slots = __atomic_load_n(&POOL->threadSlots, __ATOMIC_ACQUIRE);
+  for (u32 i = 0; i < slots; ++i)
+  {
+    Thread* thread = POOL->threads[i];
+    workerStatsRead(&thread->stats, &thread->statsBaseline);
+    __atomic_store_n(&thread->stats.queueDepthHighWater, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&thread->stats.queueWait.max,       0, __ATOMIC_RELAXED);
+    __atomic_store_n(&thread->stats.runTime.max,         0, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&POOL->statsLock);
+
+  pthread_mutex_lock(&POOL->taskQueue.readWriteLock);
+  POOL->taskQueue.sizeHighWater = POOL->taskQueue.size;
+  pthread_mutex_unlock(&POOL->taskQueue.readWriteLock);
+}
+
+u64 threadPoolHistogramPercentile(const ThreadPoolHistogram* HISTOGRAM, f64 PERCENTILE)
+{
+  FORGE_ASSERT_MESSAGE(HISTOGRAM, "Cannot read a NULL histogram");
+  if (HISTOGRAM->total == 0) return 0;
 
+  u64 rank = (u64)(PERCENTILE / 100.0 * (f64)HISTOGRAM->total);
+  if (rank >= HISTOGRAM->total) rank = HISTOGRAM->total - 1;
+
+  u64 seen = 0;
+  for (u32 i = 0; i < THREAD_POOL_HISTOGRAM_BUCKETS; ++i)
+  {
+    seen += HISTOGRAM->counts[i];
+    if (seen > rank) return histogramBucketTop(i);
+  }
+  return HISTOGRAM->max;
+}
 
-// - - -  Semaphore - - - 
 
-static void seminit(Semaphore* SEM, u8 VALUE)
+// - - - Futures - - - 
+
+typedef struct TaskFutureLink
 {
-  FORGE_ASSERT_MESSAGE(SEM, "Cannot initialize a NULL  Semaphore");
+  TaskFuture*               future;     // - - - successor waiting on the future holding this link
+  struct TaskFutureLink*    next;
+} TaskFutureLink;
 
-  pthread_mutex_init(&SEM->lock,        NULL);
-  pthread_cond_init (&SEM->conditional, NULL);
-  SEM->value = VALUE;
+static void taskFutureRun(void* ARG);
+
+static void taskFutureSchedule(TaskFuture* FUTURE)
+{
+  threadPoolPushIntrusive(FUTURE->pool, &FUTURE->task, taskFutureRun, FUTURE);
 }
 
-static void semDestroy(Semaphore* SEM)
+static void taskFutureRun(void* ARG)
 {
-  FORGE_ASSERT_MESSAGE(SEM, "Cannot destroy a NULL  Semaphore");
+  TaskFuture* future = (TaskFuture*)ARG;
+  future->result     = future->function(future->argument);
+
+  pthread_mutex_lock(&future->lock);
+  TaskFutureLink* successors = future->successors;
+  future->successors         = NULL;
+  __atomic_store_n(&future->done, true, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&future->finished);
+  pthread_mutex_unlock(&future->lock);
+
+  // - - - the waiter may destroy the future from here on, only the links are touched
+  while (successors)
+  {
+    TaskFutureLink* link = successors;
+    successors           = link->next;
 
-  pthread_mutex_destroy(&SEM->lock);
-  pthread_cond_destroy (&SEM->conditional);
+    if (__atomic_sub_fetch(&link->future->dependencies, 1, __ATOMIC_ACQ_REL) == 0) taskFutureSchedule(link->future);
+    free(link);
+  }
 }
 
-static void semWait(Semaphore* SEM)
+void createTaskFuture(TaskFuture* FUTURE, ThreadPool* POOL, void* (*FUNCTION)(void*), void* ARGUMENT)
 {
-  FORGE_ASSERT_MESSAGE(SEM, "Cannot destroy a NULL  Semaphore");
-  
-  pthread_mutex_lock(&SEM->lock);
-  while (SEM->value == 0) pthread_cond_wait(&SEM->conditional, &SEM->lock);
-  SEM->value--;
-  pthread_mutex_unlock(&SEM->lock);
+  FORGE_ASSERT_MESSAGE(FUTURE,   "Cannot create a NULL future");
+  FORGE_ASSERT_MESSAGE(POOL,     "A future needs a thread pool to run on");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot create a future with a NULL function");
+
+  FUTURE->pool          = POOL;
+  FUTURE->function      = FUNCTION;
+  FUTURE->argument      = ARGUMENT;
+  FUTURE->result        = NULL;
+  FUTURE->dependencies  = 1;        // - - - held back until taskFutureSubmit
+  FUTURE->submitted     = false;
+  FUTURE->done          = false;
+  FUTURE->successors    = NULL;
+
+  pthread_mutex_init(&FUTURE->lock, NULL);
+  pthread_cond_init(&FUTURE->finished, NULL);
 }
 
-static void semPost(Semaphore* SEM)
+void taskFutureAddDependency(TaskFuture* FUTURE, TaskFuture* DEPENDENCY)
 {
-  FORGE_ASSERT_MESSAGE(SEM, "Cannot destroy a NULL  Semaphore");
-  
-  pthread_mutex_lock(&SEM->lock);
-  SEM->value++;
-  pthread_cond_signal(&SEM->conditional);
-  pthread_mutex_unlock(&SEM->lock);
+  FORGE_ASSERT_MESSAGE(FUTURE && DEPENDENCY,  "Cannot add a dependency to or on a NULL future");
+  FORGE_ASSERT_MESSAGE(FUTURE != DEPENDENCY,  "A future cannot depend on itself");
+  FORGE_ASSERT_MESSAGE(!FUTURE->submitted,    "Dependencies must be added before the future is submitted");
+
+  pthread_mutex_lock(&DEPENDENCY->lock);
+  if (!DEPENDENCY->done)
+  {
+    TaskFutureLink* link = (TaskFutureLink*)malloc(sizeof(TaskFutureLink));
+    FORGE_ASSERT_MESSAGE(link, "[THREAD POOL] : Failed to allocate memory for a future dependency");
+
+    link->future            = FUTURE;
+    link->next              = DEPENDENCY->successors;
+    DEPENDENCY->successors  = link;
+    __atomic_add_fetch(&FUTURE->dependencies, 1, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&DEPENDENCY->lock);
 }
 
+void taskFutureSubmit(TaskFuture* FUTURE)
+{
+  FORGE_ASSERT_MESSAGE(FUTURE,             "Cannot submit a NULL future");
+  FORGE_ASSERT_MESSAGE(!FUTURE->submitted, "A future can only be submitted once");
+
+  FUTURE->submitted = true;
+  if (__atomic_sub_fetch(&FUTURE->dependencies, 1, __ATOMIC_ACQ_REL) == 0) taskFutureSchedule(FUTURE);
+}
 
-// - - - Task Queue - - - 
+bool taskFutureIsDone(TaskFuture* FUTURE)
+{
+  FORGE_ASSERT_MESSAGE(FUTURE, "Cannot check a NULL future");
+  return __atomic_load_n(&FUTURE->done, __ATOMIC_ACQUIRE);
+}
 
-static bool taskQueueInit()
+void* taskFutureWait(TaskFuture* FUTURE)
 {
-  TaskQueue* queue = &POOL.taskQueue;
-  if (pthread_mutex_init(&queue->readWriteLock, NULL) != 0)
+  FORGE_ASSERT_MESSAGE(FUTURE,            "Cannot wait on a NULL future");
+  FORGE_ASSERT_MESSAGE(FUTURE->submitted, "Waiting on a future that was never submitted would block forever");
+
+  // - - - a thread of the same pool must not sleep, the future may be queued right behind it
+  Thread* self = currentThread;
+  if (self && self->pool == FUTURE->pool)
   {
-    FORGE_LOG_ERROR("[THREAD POOL] : Failed to create read write lock for the queue");
-    return false;
-  };    
-  seminit(&queue->availability, 0);
+    while (!__atomic_load_n(&FUTURE->done, __ATOMIC_ACQUIRE))
+    {
+      if (!threadPoolRunOne(FUTURE->pool)) sched_yield();
+    }
+    return FUTURE->result;
+  }
 
-  queue->front  = NULL;
-  queue->end    = NULL;
-  queue->size   = 0;
+  pthread_mutex_lock(&FUTURE->lock);
+  while (!FUTURE->done) pthread_cond_wait(&FUTURE->finished, &FUTURE->lock);
+  pthread_mutex_unlock(&FUTURE->lock);
 
-  return true;
+  return FUTURE->result;
 }
 
-static void taskQueueDestroy()
+void destroyTaskFuture(TaskFuture* FUTURE)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread pool needs to be started first")
+  FORGE_ASSERT_MESSAGE(FUTURE, "Cannot destroy a NULL future");
+  FORGE_ASSERT_MESSAGE(!FUTURE->submitted || FUTURE->done, "Cannot destroy a future that has not finished, wait on it first");
 
-  TaskQueue* queue = &POOL.taskQueue;
+  // - - - the runner unlocks one last time after setting done, taking the lock waits that out
+  pthread_mutex_lock(&FUTURE->lock);
+  pthread_mutex_unlock(&FUTURE->lock);
 
-  pthread_mutex_lock(&queue->readWriteLock);
-  Task* current = queue->front;
+  pthread_mutex_destroy(&FUTURE->lock);
+  pthread_cond_destroy(&FUTURE->finished);
+}
 
-  while (current)
-  {
-    Task* tmp = current;
-    current   = current->previous;
-    free(tmp);
-  }
 
-  pthread_mutex_unlock  (&queue->readWriteLock);
-  pthread_mutex_destroy (&queue->readWriteLock);
-  semDestroy            (&queue->availability);
+// - - - Task groups - - - 
+
+typedef enum TaskGroupItemState
+{
+  TASK_GROUP_ITEM_QUEUED    = 0,
+  TASK_GROUP_ITEM_CLAIMED   = 1,      // - - - a pool thread, the waiter or a cancel took it, exactly one of them
+} TaskGroupItemState;
+
+// - - - one pushed task. The pool holds it through the intrusive task and the group through its list,
+// - - - whoever claims it runs or drops it and the other side only lets go of its reference
+typedef struct TaskGroupItem
+{
+  Task                      task;
+  TaskGroup*                group;
+  void                      (*function)(void*);
+  void*                     argument;
+  struct TaskGroupItem*     next;       // - - - neighbours in the group's list while unclaimed
+  struct TaskGroupItem*     previous;
+  volatile u32              state;
+  volatile u32              references;
+} TaskGroupItem;
+
+static __thread TaskGroup* currentGroup = NULL;
+
+static void taskGroupItemRelease(TaskGroupItem* ITEM)
+{
+  if (__atomic_sub_fetch(&ITEM->references, 1, __ATOMIC_ACQ_REL) == 0) free(ITEM);
 }
 
-static void taskQueuePush(Task* TASK)
+static bool taskGroupItemClaim(TaskGroupItem* ITEM)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread pool needs to be started first")
+  u32 expected = TASK_GROUP_ITEM_QUEUED;
+  return __atomic_compare_exchange_n(&ITEM->state, &expected, TASK_GROUP_ITEM_CLAIMED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
 
-  TaskQueue* queue  = &POOL.taskQueue;
-  TASK->previous    = NULL;
+// - - - caller holds the group lock and has claimed ITEM
+static void taskGroupUnlink(TaskGroup* GROUP, TaskGroupItem* ITEM)
+{
+  if (ITEM->previous) ITEM->previous->next = ITEM->next;
+  else                GROUP->front         = ITEM->next;
+  if (ITEM->next)     ITEM->next->previous = ITEM->previous;
+  else                GROUP->end           = ITEM->previous;
+}
 
-  pthread_mutex_lock(&queue->readWriteLock);
-  if (queue->size == 0)
+// - - - caller holds the group lock. After the unlock the group may be gone
+static void taskGroupFinished(TaskGroup* GROUP)
+{
+  GROUP->pending--;
+  if (GROUP->pending == 0 || GROUP->waiters > 0) pthread_cond_broadcast(&GROUP->changed);
+}
+
+// - - - caller claimed ITEM and unlinked it, runs it unless the group was cancelled meanwhile
+static void taskGroupExecute(TaskGroupItem* ITEM)
+{
+  TaskGroup* group = ITEM->group;
+  if (!__atomic_load_n(&group->cancelled, __ATOMIC_ACQUIRE))
   {
-    queue->front  = TASK;
-    queue->end    = TASK;
+    TaskGroup* outer = currentGroup;
+    currentGroup     = group;
+    ITEM->function(ITEM->argument);
+    currentGroup     = outer;
   }
-  else 
+
+  pthread_mutex_lock(&group->lock);
+  taskGroupFinished(group);
+  pthread_mutex_unlock(&group->lock);
+}
+
+// - - - the pool's side. Loses the claim when the waiter or a cancel got there first, then the group is not touched at all
+static void taskGroupRun(void* ARG)
+{
+  TaskGroupItem* item = (TaskGroupItem*)ARG;
+  if (taskGroupItemClaim(item))
   {
-    queue->end->previous  = TASK;
-    queue->end            = TASK;
-  }
+    pthread_mutex_lock(&item->group->lock);
+    taskGroupUnlink(item->group, item);
+    pthread_mutex_unlock(&item->group->lock);
 
-  queue->size++;
-  pthread_mutex_unlock(&queue->readWriteLock);
+    taskGroupExecute(item);
+    taskGroupItemRelease(item);
+  }
+  taskGroupItemRelease(item);
+}
 
-  semPost(&queue->availability);
+void createTaskGroup(TaskGroup* GROUP, ThreadPool* POOL)
+{
+  FORGE_ASSERT_MESSAGE(GROUP, "Cannot create a NULL task group");
+  FORGE_ASSERT_MESSAGE(POOL,  "A task group needs a thread pool to run on");
+
+  GROUP->pool       = POOL;
+  GROUP->front      = NULL;
+  GROUP->end        = NULL;
+  GROUP->pending    = 0;
+  GROUP->waiters    = 0;
+  GROUP->cancelled  = false;
+
+  pthread_mutex_init(&GROUP->lock, NULL);
+  pthread_cond_init(&GROUP->changed, NULL);
 }
 
-static Task* taskQueuePull()
+void taskGroupPush(TaskGroup* GROUP, void (*FUNCTION)(void*), void* ARGUMENT)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread pool needs to be started first")
+  FORGE_ASSERT_MESSAGE(GROUP,    "Cannot push to a NULL task group");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot add a NULL Function to a task");
+  if (__atomic_load_n(&GROUP->cancelled, __ATOMIC_ACQUIRE)) return;
+
+  TaskGroupItem* item = (TaskGroupItem*)malloc(sizeof(TaskGroupItem));
+  FORGE_ASSERT_MESSAGE(item, "[THREAD POOL] : Failed to allocate memory for a group task");
+
+  item->group       = GROUP;
+  item->function    = FUNCTION;
+  item->argument    = ARGUMENT;
+  item->state       = TASK_GROUP_ITEM_QUEUED;
+  item->references  = 2;        // - - - the pool's task and the group's list
+  item->next        = NULL;
+
+  pthread_mutex_lock(&GROUP->lock);
+  item->previous    = GROUP->end;
+  if (GROUP->end) GROUP->end->next = item;
+  else            GROUP->front     = item;
+  GROUP->end        = item;
+  GROUP->pending++;
+  if (GROUP->waiters > 0) pthread_cond_broadcast(&GROUP->changed);
+  pthread_mutex_unlock(&GROUP->lock);
+
+  threadPoolPushIntrusive(GROUP->pool, &item->task, taskGroupRun, item);
+}
 
-  TaskQueue* queue  = &POOL.taskQueue;
+void taskGroupWait(TaskGroup* GROUP)
+{
+  FORGE_ASSERT_MESSAGE(GROUP, "Cannot wait on a NULL task group");
+  FORGE_ASSERT_MESSAGE(currentGroup != GROUP, "Cannot wait for a task group from inside one of its tasks");
 
-  pthread_mutex_lock(&queue->readWriteLock);
-  Task*      task   = queue->front;
+  Thread* self    = currentThread;
+  bool    worker  = self && self->pool == GROUP->pool;
 
-  if (queue->size > 0)
+  pthread_mutex_lock(&GROUP->lock);
+  GROUP->waiters++;
+  while (GROUP->pending > 0)
   {
-    queue->front = task->previous;
-    if (queue->front == NULL) queue->end = NULL;
+    // - - - oldest first, the pool works from the same end so the two rarely fight over an item
+    TaskGroupItem* item = GROUP->front;
+    while (item && !taskGroupItemClaim(item)) item = item->next;
+
+    if (item)
+    {
+      taskGroupUnlink(GROUP, item);
+      pthread_mutex_unlock(&GROUP->lock);
+      taskGroupExecute(item);
+      taskGroupItemRelease(item);
+      pthread_mutex_lock(&GROUP->lock);
+      continue;
+    }
 
-    queue->size--;
+    // - - - everything left is running elsewhere. A thread of the same pool keeps working instead of sleeping
+    if (worker)
+    {
+      pthread_mutex_unlock(&GROUP->lock);
+      if (!threadPoolRunOne(GROUP->pool)) sched_yield();
+      pthread_mutex_lock(&GROUP->lock);
+      continue;
+    }
+    pthread_cond_wait(&GROUP->changed, &GROUP->lock);
   }
+  GROUP->waiters--;
+  pthread_mutex_unlock(&GROUP->lock);
+}
 
-  pthread_mutex_unlock(&queue->readWriteLock);
-  return task;
+void taskGroupCancel(TaskGroup* GROUP)
+{
+  FORGE_ASSERT_MESSAGE(GROUP, "Cannot cancel a NULL task group");
+
+  pthread_mutex_lock(&GROUP->lock);
+  __atomic_store_n(&GROUP->cancelled, true, __ATOMIC_RELEASE);
+
+  // - - - drop what has not started, the pool's tasks for them find nothing to claim
+  TaskGroupItem* item = GROUP->front;
+  while (item)
+  {
+    TaskGroupItem* next = item->next;
+    if (taskGroupItemClaim(item))
+    {
+      taskGroupUnlink(GROUP, item);
+      taskGroupFinished(GROUP);
+      taskGroupItemRelease(item);
+    }
+    item = next;
+  }
+  pthread_mutex_unlock(&GROUP->lock);
 }
 
-static bool isTaskQueueEmpty()
+bool taskGroupIsCancelled(TaskGroup* GROUP)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread pool needs to be started first");
-  
-  pthread_mutex_lock(&POOL.taskQueue.readWriteLock);
-  bool isEmpty = (POOL.taskQueue.size == 0);
-  pthread_mutex_unlock(&POOL.taskQueue.readWriteLock);
+  FORGE_ASSERT_MESSAGE(GROUP, "Cannot check a NULL task group");
+  return __atomic_load_n(&GROUP->cancelled, __ATOMIC_ACQUIRE);
+}
 
-  return isEmpty;
+TaskGroup* taskGroupCurrent()
+{
+  return currentGroup;
 }
 
+void destroyTaskGroup(TaskGroup* GROUP)
+{
+  FORGE_ASSERT_MESSAGE(GROUP, "Cannot destroy a NULL task group");
 
-// - - - Threads - - - 
+  // - - - the last task unlocks once more after finishing, taking the lock waits that out
+  pthread_mutex_lock(&GROUP->lock);
+  FORGE_ASSERT_MESSAGE(GROUP->pending == 0, "Cannot destroy a task group with pending tasks, wait on it first");
+  pthread_mutex_unlock(&GROUP->lock);
 
-static void* threadDo(void* ARG)
+  pthread_mutex_destroy(&GROUP->lock);
+  pthread_cond_destroy(&GROUP->changed);
+}
+
+
+// - - - Timers - - - 
+
+static u64 timerNowTick()
 {
-  Thread* self = (Thread*)ARG;
+  return telemetryNow() / TIMER_TICK;
+}
 
-  while (true)
-  {
-    semWait(&POOL.taskQueue.availability);
-    if (!running) break;
+// - - - caller holds the wheel lock
+static void timerWheelLink(TimerWheel* WHEEL, Timer* TIMER)
+{
+  if (TIMER->deadline < WHEEL->current) TIMER->deadline = WHEEL->current;
+
+  u64 delta = TIMER->deadline - WHEEL->current;
+  u32 level = 0;
+  while (level < TIMER_LEVELS - 1 && delta >= (1ULL << (TIMER_LEVEL_BITS * (level + 1)))) level++;
+
+  // - - - past the top level it waits in the last slot it can reach and is placed again from there
+  u64 reach     = 1ULL << (TIMER_LEVEL_BITS * TIMER_LEVELS);
+  u64 position  = delta >= reach ? WHEEL->current + reach - 1 : TIMER->deadline;
+
+  u32 slot          = (u32)(position >> (TIMER_LEVEL_BITS * level)) & (TIMER_SLOTS - 1);
+  Timer** head      = &WHEEL->slots[level][slot];
+  TIMER->slot       = level * TIMER_SLOTS + slot;
+  TIMER->previous   = NULL;
+  TIMER->next       = *head;
+  if (*head) (*head)->previous = TIMER;
+  *head             = TIMER;
+  WHEEL->occupied[level] |= 1ULL << slot;
+}
+
+// - - - caller holds the wheel lock
+static void timerWheelUnlink(TimerWheel* WHEEL, Timer* TIMER)
+{
+  u32 level = TIMER->slot / TIMER_SLOTS;
+  u32 slot  = TIMER->slot % TIMER_SLOTS;
+
+  if (TIMER->previous) TIMER->previous->next    = TIMER->next;
+  else                 WHEEL->slots[level][slot] = TIMER->next;
+  if (TIMER->next)     TIMER->next->previous    = TIMER->previous;
+
+  if (!WHEEL->slots[level][slot]) WHEEL->occupied[level] &= ~(1ULL << slot);
+}
+
+// - - - processes tick WHEEL->current : pours the levels that reached a boundary, then fires what is due.
+// - - - NOW is the real tick, periodic timers that fell behind skip to the next period after it
+static void timerWheelTick(ThreadPool* POOL, TimerWheel* WHEEL, u64 NOW)
+{
+  u64 tick = WHEEL->current;
+
+  u32 top = 0;
+  while (top < TIMER_LEVELS - 1 && (tick & ((1ULL << (TIMER_LEVEL_BITS * (top + 1))) - 1)) == 0) top++;
 
-    Task* task = taskQueuePull();
+  // - - - highest first, what it pours may land in a lower slot that is poured right after
+  for (u32 level = top; level > 0; --level)
+  {
+    u32    slot   = (u32)(tick >> (TIMER_LEVEL_BITS * level)) & (TIMER_SLOTS - 1);
+    Timer* timer  = WHEEL->slots[level][slot];
+    WHEEL->slots[level][slot]  = NULL;
+    WHEEL->occupied[level]    &= ~(1ULL << slot);
 
-    if (task)
+    while (timer)
     {
-      pthread_mutex_lock(&POOL.threadCountLock);
-      POOL.numThreadsWorking++;
-      pthread_mutex_unlock(&POOL.threadCountLock);
+      Timer* next = timer->next;
+      timerWheelLink(WHEEL, timer);
+      timer       = next;
+    }
+  }
 
-      // - - - run the task
-      task->function(task->argument);
-      free(task);
+  u32    slot   = (u32)tick & (TIMER_SLOTS - 1);
+  Timer* timer  = WHEEL->slots[0][slot];
+  WHEEL->slots[0][slot]  = NULL;
+  WHEEL->occupied[0]    &= ~(1ULL << slot);
+  WHEEL->current         = tick + 1;
 
-      bool noneLeft = isTaskQueueEmpty();
+  while (timer)
+  {
+    Timer* next = timer->next;
+    threadPoolPush(POOL, timer->function, timer->argument);
 
-      pthread_mutex_lock(&POOL.threadCountLock);
-      POOL.numThreadsWorking--;
-      if (POOL.numThreadsWorking == 0 && noneLeft)
-      {
-        pthread_cond_broadcast(&POOL.allIdle);
-      }
-      pthread_mutex_unlock(&POOL.threadCountLock);
+    if (timer->period > 0)
+    {
+      timer->deadline = tick + timer->period;
+      if (timer->deadline <= NOW) timer->deadline += ((NOW - timer->deadline) / timer->period + 1) * timer->period;
+      timerWheelLink(WHEEL, timer);
+    }
+    else
+    {
+      timer->pending = false;
+      WHEEL->count--;
     }
+    timer = next;
   }
+}
 
-  return NULL;
+// - - - bit k of the rotated OCCUPIED is slot FIRST + k, the distance from FIRST to the next non empty slot
+static u32 timerWheelNextSlot(u64 OCCUPIED, u32 FIRST)
+{
+  u64 rotated = FIRST ? (OCCUPIED >> FIRST) | (OCCUPIED << (TIMER_SLOTS - FIRST)) : OCCUPIED;
+  return (u32)__builtin_ctzll(rotated);
 }
 
-static bool threadInit(i32 ID)
+// - - - the next tick with something to do, UINT64_MAX when the wheel is empty
+static u64 timerWheelNextEvent(TimerWheel* WHEEL)
 {
-  Thread* thread  = (Thread*)malloc(sizeof(Thread));
-  thread->id      = ID;
+  if (WHEEL->count == 0) return UINT64_MAX;
 
-  pthread_attr_t attr;
-  pthread_attr_init(&attr);
+  u64 next = UINT64_MAX;
+  if (WHEEL->occupied[0]) next = WHEEL->current + timerWheelNextSlot(WHEEL->occupied[0], (u32)WHEEL->current & (TIMER_SLOTS - 1));
 
-  if (pthread_create(&thread->pthread, &attr, threadDo, (void*)thread) != 0)
+  // - - - slot i of level L pours on the first tick of its span, a multiple of 64^L. Counted from the first span
+  // - - - that starts at current or later, so a distant timer wakes the wheel once per level instead of every 64 ticks.
+  // - - - A pour can bring down an earlier deadline than anything already on level 0, so the earliest of them wins
+  for (u32 level = 1; level < TIMER_LEVELS; ++level)
   {
-    FORGE_LOG_ERROR("[THREAD POOL] : Failed to initialize thread %d", ID);
-    pthread_attr_destroy(&attr);
-    free(thread);
-    return false;
+    if (WHEEL->occupied[level] == 0) continue;
+
+    u32 bits  = TIMER_LEVEL_BITS * level;
+    u64 span  = (WHEEL->current + (1ULL << bits) - 1) >> bits;
+    u64 pour  = (span + timerWheelNextSlot(WHEEL->occupied[level], (u32)span & (TIMER_SLOTS - 1))) << bits;
+    if (pour < next) next = pour;
   }
-  pthread_attr_destroy(&attr);
+  return next;
+}
+
+static void* timerWheelRun(void* ARG)
+{
+  ThreadPool* POOL  = (ThreadPool*)ARG;
+  TimerWheel* wheel = POOL->timers;
+
+  char name[32];
+  snprintf(name, sizeof(name), "%s-timer", POOL->name);
+  prctl(PR_SET_NAME, name, 0, 0, 0);
 
-  pthread_mutex_lock(&POOL.threadCountLock);
-  POOL.threads[ID] = thread;
-  POOL.numThreadsAlive++;
-  pthread_mutex_unlock(&POOL.threadCountLock);
+  pthread_mutex_lock(&wheel->lock);
+  while (!wheel->stopping)
+  {
+    u64 now = timerNowTick();
+    if (wheel->count == 0 && wheel->current < now) wheel->current = now;
+    while (wheel->current <= now) timerWheelTick(POOL, wheel, now);
+
+    u64 next          = timerWheelNextEvent(wheel);
+    wheel->sleepUntil = next;
+    pthread_mutex_unlock(&wheel->lock);
+
+    if (next == UINT64_MAX) semaphoreWait(&wheel->wake);
+    else
+    {
+      u64 nanoseconds = telemetryNow();
+      u64 due         = next * TIMER_TICK;
+      if (due > nanoseconds) semaphoreWaitFor(&wheel->wake, due - nanoseconds);
+    }
+    pthread_mutex_lock(&wheel->lock);
+  }
+  pthread_mutex_unlock(&wheel->lock);
+  return NULL;
+}
 
+static bool timerWheelCreate(ThreadPool* POOL)
+{
+  TimerWheel* wheel = (TimerWheel*)calloc(1, sizeof(TimerWheel));
+  POOL->timers      = wheel;
+  if (!wheel) return false;
+
+  pthread_mutex_init(&wheel->lock, NULL);
+  createSemaphore(&wheel->wake, 0);
+  wheel->current    = timerNowTick();
+  wheel->sleepUntil = UINT64_MAX;
   return true;
 }
 
-static void threadDestroy(i32 ID)
+static void timerWheelDestroy(ThreadPool* POOL)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread pool needs to be started first")
+  TimerWheel* wheel = POOL->timers;
+  if (!wheel) return;
 
-  Thread* thread = POOL.threads[ID];
-  pthread_join(thread->pthread, NULL);
-  free(thread);
-}
+  pthread_mutex_lock(&wheel->lock);
+  wheel->stopping = true;
+  bool started    = wheel->started;
+  pthread_mutex_unlock(&wheel->lock);
 
+  if (started)
+  {
+    semaphorePost(&wheel->wake);
+    pthread_join(wheel->thread, NULL);
+  }
 
-// - - - Thread pool - - - 
+  // - - - the caller owns the timers, they only learn they are no longer pending
+  for (u32 level = 0; level < TIMER_LEVELS; ++level)
+  {
+    for (u32 slot = 0; slot < TIMER_SLOTS; ++slot)
+    {
+      for (Timer* timer = wheel->slots[level][slot]; timer; timer = timer->next) timer->pending = false;
+    }
+  }
 
-bool threadPoolInit(u8 THREAD_COUNT)
-{
-  FORGE_ASSERT_MESSAGE(!created, "Cannot simply recreate the thread pool. Call threadPoolDestroy() first!");
- 
-  // - - - assign the number of threads and pinning to cpu 
-  POOL.numThreadsAlive     = 0;
-  POOL.numThreadsWorking   = 0;
-  u8 threadCount           = THREAD_COUNT;
+  pthread_mutex_destroy(&wheel->lock);
+  destroySemaphore(&wheel->wake);
+  free(wheel);
+  POOL->timers = NULL;
+}
 
-  if (THREAD_COUNT == 0)   
+void threadPoolSchedulePeriodic(ThreadPool* POOL, Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY, u64 PERIOD)
+{
+  FORGE_ASSERT_MESSAGE(POOL && POOL->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(POOL->timers, "Thread Pool has no timer wheel");
+  FORGE_ASSERT_MESSAGE(TIMER,    "Cannot schedule a NULL Timer");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot add a NULL Function to a timer");
+
+  TimerWheel* wheel = POOL->timers;
+
+  // - - - rounded up, a timer may fire late but never early
+  u64 deadline      = (telemetryNow() + DELAY + TIMER_TICK - 1) / TIMER_TICK;
+  u64 period        = (PERIOD + TIMER_TICK - 1) / TIMER_TICK;
+  if (PERIOD > 0 && period == 0) period = 1;
+
+  pthread_mutex_lock(&wheel->lock);
+  FORGE_ASSERT_MESSAGE(!TIMER->pending, "Timer is already pending, cancel it first");
+
+  // - - - an empty wheel may be far behind while its thread sleeps, catch up without walking every tick
+  u64 now           = timerNowTick();
+  if (wheel->count == 0 && wheel->current < now) wheel->current = now;
+
+  TIMER->pool       = POOL;
+  TIMER->function   = FUNCTION;
+  TIMER->argument   = ARGUMENT;
+  TIMER->deadline   = deadline;
+  TIMER->period     = period;
+  TIMER->pending    = true;
+  timerWheelLink(wheel, TIMER);
+  wheel->count++;
+
+  // - - - the thread only exists once somebody needs it
+  if (!wheel->started)
   {
-    i64 cores       = sysconf(_SC_NPROCESSORS_ONLN);
-        threadCount = (cores > 0 && cores < 256) ? (u8)cores : 4;
-    FORGE_LOG_WARNING("[THREAD POOL] : Creating a thread pool with hardware defined thread count: %d", threadCount);
+    wheel->started = pthread_create(&wheel->thread, NULL, timerWheelRun, POOL) == 0;
+    FORGE_ASSERT_MESSAGE(wheel->started, "[THREAD POOL] : Failed to start the timer thread");
   }
 
-  FORGE_LOG_TRACE("[THREAD_POOL] : Starting with %d threads", threadCount);
+  bool earlier      = TIMER->deadline < wheel->sleepUntil;
+  if (earlier) wheel->sleepUntil = TIMER->deadline;
+  pthread_mutex_unlock(&wheel->lock);
 
-  // - - - initialize the lock and conditional
-  pthread_mutex_init(&(POOL.threadCountLock), NULL);
-  pthread_cond_init(&POOL.allIdle, NULL);
+  if (earlier) semaphorePost(&wheel->wake);
+}
 
-  // - - - initialize task queue 
-  if (!taskQueueInit())
-  {
-    FORGE_LOG_ERROR("[THREAD POOL] : Failed to initialize task queue");
-    return false;    
-  };
+void threadPoolSchedule(ThreadPool* POOL, Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY)
+{
+  threadPoolSchedulePeriodic(POOL, TIMER, FUNCTION, ARGUMENT, DELAY, 0);
+}
+
+bool threadPoolCancelTimer(Timer* TIMER)
+{
+  FORGE_ASSERT_MESSAGE(TIMER, "Cannot cancel a NULL Timer");
+  if (!TIMER->pool || !TIMER->pool->timers) return false;
 
-  // - - - make threads 
-  POOL.threads = (Thread**) calloc (threadCount, sizeof(Thread*));
-  if (POOL.threads == NULL)
+  TimerWheel* wheel = TIMER->pool->timers;
+  pthread_mutex_lock(&wheel->lock);
+  bool pending = TIMER->pending;
+  if (pending)
   {
-    FORGE_LOG_ERROR("[THREAD POOL] : Failed to allocate memory for threads");
-    return false;
+    timerWheelUnlink(wheel, TIMER);
+    TIMER->pending = false;
+    wheel->count--;
   }
-  for (u8 i = 0; i < threadCount; i++)    threadInit(i); 
+  pthread_mutex_unlock(&wheel->lock);
 
-  FORGE_LOG_TRACE("[THREAD POOL] : Waiting for all the threads to be ready")
-  while (POOL.numThreadsAlive != threadCount){}
-  FORGE_LOG_TRACE("[THREAD POOL] : Wait finished. All the threads are ready to go");
+  // - - - an earlier wake up than needed costs the thread one look, no need to tell it
+  return pending;
+}
 
-  created = true;
-  running = true;
-  return true;
+
+// - - - Parallel loops - - - 
+
+#define PARALLEL_CHUNKS_PER_THREAD  64
+#define PARALLEL_INLINE_RESULT      64
+
+typedef struct ParallelJob
+{
+  ThreadPool*   pool;
+  u64           grain;
+  void          (*body)   (u64, u64, void*);
+  void          (*reduce) (u64, u64, void*, void*);
+  void          (*combine)(void*, const void*, void*);
+  void*         context;
+  const void*   identity;
+  u64           resultSize;
+} ParallelJob;
+
+// - - - the right half of a split range. Lives on the stack of the thread that split it, which waits for it
+typedef struct ParallelSplit
+{
+  Task          task;
+  ParallelJob*  job;
+  u64           begin;
+  u64           end;
+  void*         result;                           // - - - partial result of this half, NULL for parallelFor
+  volatile bool done;
+  u8            inlineResult[PARALLEL_INLINE_RESULT];
+} ParallelSplit;
+
+static void parallelRange(ParallelJob* JOB, u64 BEGIN, u64 END, void* RESULT);
+
+static void parallelSplitRun(void* ARG)
+{
+  ParallelSplit* split = (ParallelSplit*)ARG;
+  parallelRange(split->job, split->begin, split->end, split->result);
+  __atomic_store_n(&split->done, true, __ATOMIC_RELEASE);
 }
 
-void threadPoolTaskPush(void (*FUNCTION)(void*), void* ARGUMENT)
+static bool parallelShouldSplit(ThreadPool* POOL)
 {
-  FORGE_ASSERT_MESSAGE(created,  "Thread Pool is not started yet");
-  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot add a NULL Function to a task");
+  // - - - lazy splitting : a worker only splits again once the last half it handed out got stolen.
+  // - - - the calling thread has no deque, it splits while some worker has nothing to do
+  Thread* self = currentThread;
+  if (self && self->pool == POOL) return taskDequeIsEmpty(&self->deque);
+  return __atomic_load_n(&POOL->numThreadsWorking, __ATOMIC_RELAXED) < __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_RELAXED);
+}
 
-  Task* newTask = (Task*)malloc(sizeof(Task));
-  if (newTask == NULL)
+static void parallelChunk(ParallelJob* JOB, u64 BEGIN, u64 END, void* RESULT)
+{
+  if (JOB->reduce) JOB->reduce(BEGIN, END, JOB->context, RESULT);
+  else             JOB->body  (BEGIN, END, JOB->context);
+}
+
+static void parallelRange(ParallelJob* JOB, u64 BEGIN, u64 END, void* RESULT)
+{
+  while (END - BEGIN > JOB->grain)
   {
-    FORGE_LOG_ERROR("[THREAD POOL] : Could not allocate memory for new job");
+    if (!parallelShouldSplit(JOB->pool))
+    {
+      // - - - everybody is busy, eat one chunk and look again
+      parallelChunk(JOB, BEGIN, BEGIN + JOB->grain, RESULT);
+      BEGIN += JOB->grain;
+      continue;
+    }
+
+    ParallelSplit split;
+    split.job     = JOB;
+    split.begin   = BEGIN + (END - BEGIN) / 2;
+    split.end     = END;
+    split.done    = false;
+    split.result  = NULL;
+    if (JOB->reduce)
+    {
+      split.result = JOB->resultSize <= PARALLEL_INLINE_RESULT ? split.inlineResult : malloc(JOB->resultSize);
+      FORGE_ASSERT_MESSAGE(split.result, "[THREAD POOL] : Failed to allocate memory for a partial result");
+      memcpy(split.result, JOB->identity, JOB->resultSize);
+    }
+    threadPoolPushIntrusive(JOB->pool, &split.task, parallelSplitRun, &split);
+
+    parallelRange(JOB, BEGIN, split.begin, RESULT);
+
+    // - - - usually nobody stole it and it comes right back off our own deque
+    while (!__atomic_load_n(&split.done, __ATOMIC_ACQUIRE))
+    {
+      if (!threadPoolRunOne(JOB->pool)) sched_yield();
+    }
+
+    // - - - the left half is always folded first, COMBINE does not need to commute
+    if (JOB->reduce)
+    {
+      JOB->combine(RESULT, split.result, JOB->context);
+      if (split.result != split.inlineResult) free(split.result);
+    }
     return;
   }
 
-  newTask->function = FUNCTION;
-  newTask->argument = ARGUMENT;
-  newTask->previous = NULL;
-
-  taskQueuePush(newTask);
+  if (BEGIN < END) parallelChunk(JOB, BEGIN, END, RESULT);
 }
 
-void threadPoolWaitToFinish()
+static void parallelRun(ParallelJob* JOB, u64 BEGIN, u64 END, void* RESULT)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread Pool is not started. Call `threadPoolCreate` first");
+  FORGE_ASSERT_MESSAGE(JOB->pool && JOB->pool->created, "Thread Pool is not started yet");
+  FORGE_ASSERT_MESSAGE(BEGIN <= END, "Parallel loop range ends before it begins");
 
-  FORGE_LOG_INFO("[THREAD POOL] : Waiting for all tasks to finish");
-  pthread_mutex_lock(&POOL.threadCountLock);  
-  while (POOL.taskQueue.size > 0 || !isTaskQueueEmpty())
+  if (JOB->grain == 0)
   {
-    FORGE_LOG_TRACE("[THREAD POOL] : Main thread waiting for all idle, current task queue size : %d, current threads working : %d", POOL.taskQueue.size, POOL.numThreadsWorking)
-    pthread_cond_wait(&POOL.allIdle, &POOL.threadCountLock);
+    u64 chunks = (u64)__atomic_load_n(&JOB->pool->numThreadsAlive, __ATOMIC_RELAXED) * PARALLEL_CHUNKS_PER_THREAD;
+    JOB->grain = (END - BEGIN) / chunks;
+    if (JOB->grain == 0) JOB->grain = 1;
   }
-  pthread_mutex_unlock(&POOL.threadCountLock);
-  FORGE_LOG_INFO("[THREAD POOL] : Finished waiting for all tasks")
+
+  parallelRange(JOB, BEGIN, END, RESULT);
 }
 
-void threadPoolDestroy()
+void threadPoolParallelFor(ThreadPool* POOL, u64 BEGIN, u64 END, u64 GRAIN, void (*FUNCTION)(u64, u64, void*), void* CONTEXT)
 {
-  FORGE_ASSERT_MESSAGE(created, "Thread Pool is not started. Call `threadPoolCreate` first");
-  
-  FORGE_LOG_WARNING("[THREAD POOL] : Destroying Thread Pool");
+  FORGE_ASSERT_MESSAGE(FUNCTION, "Cannot run a NULL Function in parallel");
 
-  // - - - signal all threads to stop
-  running = false;
+  ParallelJob job = { POOL, GRAIN, FUNCTION, NULL, NULL, CONTEXT, NULL, 0 };
+  parallelRun(&job, BEGIN, END, NULL);
+}
 
-  // - - - wake up all threads 
-  for (u8 i = 0; i < POOL.numThreadsAlive; ++i) semPost(&POOL.taskQueue.availability);
-  for (u8 i = 0; i < POOL.numThreadsAlive; ++i) threadDestroy(i);
+void threadPoolParallelReduce(ThreadPool* POOL, u64 BEGIN, u64 END, u64 GRAIN, void* RESULT, const void* IDENTITY, u64 RESULT_SIZE, void (*REDUCE)(u64, u64, void*, void*), void (*COMBINE)(void*, const void*, void*), void* CONTEXT)
+{
+  FORGE_ASSERT_MESSAGE(REDUCE && COMBINE,  "Cannot reduce with a NULL Function");
+  FORGE_ASSERT_MESSAGE(RESULT && IDENTITY, "Cannot reduce without a result and an identity");
 
-  free(POOL.threads);
-  taskQueueDestroy();
+  memcpy(RESULT, IDENTITY, RESULT_SIZE);
 
-  pthread_mutex_destroy(&POOL.threadCountLock);
-  pthread_cond_destroy(&POOL.allIdle);
-  
-  created = false;
+  ParallelJob job = { POOL, GRAIN, NULL, REDUCE, COMBINE, CONTEXT, IDENTITY, RESULT_SIZE };
+  parallelRun(&job, BEGIN, END, RESULT);
+}
+
+
+// - - - Default pool - - - 
+
+ThreadPool* threadPoolGetDefault()
+{
+  return &DEFAULT_POOL;
+}
+
+bool threadPoolInit(u32 THREAD_COUNT)
+{
+  FORGE_ASSERT_MESSAGE(!DEFAULT_POOL.created, "Cannot simply recreate the thread pool. Call threadPoolDestroy() first!");
+
+  ThreadPoolConfig config = { THREAD_COUNT, 0, "forge", THREAD_POOL_PIN_NONE, NULL, 0, false, 0, 0, 0 };
+  return createThreadPool(&DEFAULT_POOL, &config);
+}
+
+bool threadPoolInitElastic(u32 MIN_THREADS, u32 MAX_THREADS)
+{
+  FORGE_ASSERT_MESSAGE(!DEFAULT_POOL.created, "Cannot simply recreate the thread pool. Call threadPoolDestroy() first!");
+  FORGE_ASSERT_MESSAGE(MIN_THREADS > 0 && MAX_THREADS >= MIN_THREADS, "An elastic pool needs 0 < MIN_THREADS <= MAX_THREADS");
+
+  ThreadPoolConfig config = { MIN_THREADS, 0, "forge", THREAD_POOL_PIN_NONE, NULL, 0, false, MAX_THREADS, 0, 0 };
+  return createThreadPool(&DEFAULT_POOL, &config);
+}
+
+void threadPoolTaskPush(void (*FUNCTION)(void*), void* ARGUMENT)
+{
+  threadPoolPush(&DEFAULT_POOL, FUNCTION, ARGUMENT);
+}
+
+void threadPoolTaskPushPriority(void (*FUNCTION)(void*), void* ARGUMENT, TaskPriority PRIORITY)
+{
+  threadPoolPushPriority(&DEFAULT_POOL, FUNCTION, ARGUMENT, PRIORITY);
+}
+
+void threadPoolTaskPushBatch(void (**FUNCTIONS)(void*), void** ARGUMENTS, u64 COUNT)
+{
+  threadPoolPushBatch(&DEFAULT_POOL, FUNCTIONS, ARGUMENTS, COUNT);
+}
+
+void threadPoolTaskPushIntrusive(Task* TASK, void (*FUNCTION)(void*), void* ARGUMENT)
+{
+  threadPoolPushIntrusive(&DEFAULT_POOL, TASK, FUNCTION, ARGUMENT);
+}
+
+void threadPoolTaskSchedule(Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY)
+{
+  threadPoolSchedule(&DEFAULT_POOL, TIMER, FUNCTION, ARGUMENT, DELAY);
+}
+
+void threadPoolTaskSchedulePeriodic(Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY, u64 PERIOD)
+{
+  threadPoolSchedulePeriodic(&DEFAULT_POOL, TIMER, FUNCTION, ARGUMENT, DELAY, PERIOD);
+}
+
+void threadPoolWaitToFinish()
+{
+  threadPoolWait(&DEFAULT_POOL);
+}
+
+void threadPoolDestroy()
+{
+  destroyThreadPool(&DEFAULT_POOL);
+}
+
+void parallelFor(u64 BEGIN, u64 END, u64 GRAIN, void (*FUNCTION)(u64, u64, void*), void* CONTEXT)
+{
+  threadPoolParallelFor(&DEFAULT_POOL, BEGIN, END, GRAIN, FUNCTION, CONTEXT);
+}
+
+void parallelReduce(u64 BEGIN, u64 END, u64 GRAIN, void* RESULT, const void* IDENTITY, u64 RESULT_SIZE, void (*REDUCE)(u64, u64, void*, void*), void (*COMBINE)(void*, const void*, void*), void* CONTEXT)
+{
+  threadPoolParallelReduce(&DEFAULT_POOL, BEGIN, END, GRAIN, RESULT, IDENTITY, RESULT_SIZE, REDUCE, COMBINE, CONTEXT);
 }
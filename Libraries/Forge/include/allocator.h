@@ -0,0 +1,41 @@
+#pragma once
+#include "defines.h"
+#include "linearAlloc.h"
+#include "objectPool.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* (allocateFunction)   (void* CONTEXT, u64 SIZE);
+typedef void  (deallocateFunction) (void* CONTEXT, void* MEMORY, u64 SIZE);
+typedef void* (reallocateFunction) (void* CONTEXT, void* MEMORY, u64 OLD_SIZE, u64 NEW_SIZE);
+
+// - - - where a container gets its memory from. CONTEXT goes back into every call, so each container can have its
+// - - - own arena or pool without globals. Deallocate and reallocate are told the size that was asked for
+typedef struct ForgeAllocator
+{
+  allocateFunction*     allocate;
+  deallocateFunction*   deallocate;
+  reallocateFunction*   reallocate;
+  void*                 context;
+} ForgeAllocator;
+
+
+// - - - malloc, free and realloc from stdlib
+FORGE_API void      createHeapAllocator     (ForgeAllocator* ALLOCATOR);
+
+// - - - a plain malloc and free pair, stdlib for either one that is NULL. The pair is kept for the life of the program
+// - - - and shared by every allocator made from it, so the allocator holds no pointer to whoever created it and can be
+// - - - copied along with the container
+FORGE_API void      createFunctionAllocator (ForgeAllocator* ALLOCATOR, void* (*MALLOC)(unsigned long SIZE), void (*FREE)(void* MEMORY));
+
+// - - - 16 byte aligned blocks out of ARENA. Deallocating does nothing, linearAllocReset frees everything at once.
+// - - - Give the arena a RESIZE_FACTOR of 0, resizing moves its memory out from under the blocks handed out
+FORGE_API void      createArenaAllocator    (ForgeAllocator* ALLOCATOR, LinearAllocator* ARENA);
+
+// - - - one object of POOL per allocation, requests bigger than its object size fail
+FORGE_API void      createPoolAllocator     (ForgeAllocator* ALLOCATOR, ObjectPool* POOL);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include "defines.h"
+#include "hashMap.h"
+#include <pthread.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONCURRENT_HASH_MAP_STRIPES 64
+
+// - - - one writer lock per stripe of buckets, each on its own cache line
+typedef struct ConcurrentStripe
+{
+  pthread_mutex_t       lock;
+  u8                    padding[64 - sizeof(pthread_mutex_t) % 64];
+} ConcurrentStripe;
+
+// - - - a HashMap any thread can use at any time. Readers take no lock and write nothing shared, they only announce
+// - - - which epoch they read in. Writers lock the stripe of the key's bucket, and removed entries and outgrown tables
+// - - - are freed once every reader that could still see them has left
+typedef struct ConcurrentHashMap
+{
+  struct ConcurrentTable* volatile  table;      // - - - swapped whole when growing
+  volatile unsigned long long       count;
+  unsigned long long                seed;
+  hashFunction*                     hash;
+  memoryAllocate*                   allocator;
+  memoryDeallocate*                 deallocator;
+  memoryCompare*                    compare;
+  ConcurrentStripe                  stripes[CONCURRENT_HASH_MAP_STRIPES];
+} ConcurrentHashMap;
+
+
+// - - - same arguments as createHashMap, SIZE is the number of entries expected
+FORGE_API bool      createConcurrentHashMap     (ConcurrentHashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, memoryAllocate* MALLOC, memoryDeallocate* FREE, memoryCompare* MEMCMP);
+
+// - - - nobody may use the map anymore
+FORGE_API bool      destroyConcurrentHashMap    (ConcurrentHashMap* MAP);
+
+// - - - inserts or replaces, readers see either the old value or the new one
+FORGE_API bool      concurrentHashMapInsert     (ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE, void* VALUE);
+
+// - - - lock free, never waits for writers
+FORGE_API void*     concurrentHashMapGet        (ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE);
+
+FORGE_API void*     concurrentHashMapRemove     (ConcurrentHashMap* MAP, const byteArray KEY, unsigned long long KEY_SIZE);
+
+// - - - entries right now, only a snapshot while others write
+FORGE_API unsigned long long concurrentHashMapCount (ConcurrentHashMap* MAP);
+
+#ifdef __cplusplus
+}
+#endif
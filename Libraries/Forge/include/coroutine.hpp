@@ -0,0 +1,398 @@
+#pragma once
+#include "threadPool.h"
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// - - - C++20 coroutines on top of the thread pool, header only.
+// - - - a suspended coroutine is just its frame, no thread is blocked on it. The frame also carries the
+// - - - intrusive Task and what used to be the argument struct, so a hop to the pool allocates nothing.
+
+namespace forge
+{
+  template <typename T = void> class Task;
+
+  namespace detail
+  {
+    // - - - stands in for void inside tuples and vectors
+    struct Void {};
+
+    template <typename T> using Value = std::conditional_t<std::is_void_v<T>, Void, T>;
+
+    struct PromiseBase
+    {
+      std::coroutine_handle<>   continuation = std::noop_coroutine();   // - - - whoever awaits this task
+      std::exception_ptr        exception;
+
+      // - - - finishing hands the thread straight to the awaiting coroutine, no stack growth
+      struct FinalAwaiter
+      {
+        bool await_ready() noexcept { return false; }
+
+        template <typename PROMISE>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<PROMISE> HANDLE) noexcept { return HANDLE.promise().continuation; }
+
+        void await_resume() noexcept {}
+      };
+
+      std::suspend_always initial_suspend()     noexcept { return {}; }
+      FinalAwaiter        final_suspend()       noexcept { return {}; }
+      void                unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct Promise : PromiseBase
+    {
+      std::optional<T> value;
+
+      Task<T> get_return_object() noexcept;
+
+      template <typename U>
+      void return_value(U&& VALUE) { value.emplace(std::forward<U>(VALUE)); }
+
+      T result()
+      {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+      }
+    };
+
+    template <>
+    struct Promise<void> : PromiseBase
+    {
+      Task<void> get_return_object() noexcept;
+
+      void return_void() noexcept {}
+
+      void result()
+      {
+        if (exception) std::rethrow_exception(exception);
+      }
+    };
+  }
+
+  // - - - lazy : nothing runs until the task is awaited, then it runs on the awaiting thread until it hops with schedule()
+  template <typename T>
+  class Task
+  {
+  public:
+    using promise_type = detail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> HANDLE) noexcept : handle(HANDLE) {}
+    Task(Task&& OTHER) noexcept : handle(std::exchange(OTHER.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task& operator=(Task&& OTHER) noexcept
+    {
+      if (this != &OTHER)
+      {
+        if (handle) handle.destroy();
+        handle = std::exchange(OTHER.handle, nullptr);
+      }
+      return *this;
+    }
+
+    ~Task()
+    {
+      if (handle) handle.destroy();
+    }
+
+    bool isDone() const noexcept { return !handle || handle.done(); }
+
+    auto operator co_await() && noexcept
+    {
+      struct Awaiter
+      {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> AWAITING) noexcept
+        {
+          handle.promise().continuation = AWAITING;
+          return handle;
+        }
+
+        T await_resume() { return handle.promise().result(); }
+      };
+      return Awaiter{ handle };
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  namespace detail
+  {
+    template <typename T>
+    Task<T> Promise<T>::get_return_object() noexcept { return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+    inline Task<void> Promise<void>::get_return_object() noexcept { return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+  }
+
+
+  // - - - Schedule - - -
+
+  // - - - `co_await forge::schedule(pool)` continues the coroutine on a thread of POOL.
+  // - - - the Task pushed to the pool lives in this awaiter, which lives in the coroutine frame
+  class ScheduleAwaiter
+  {
+  public:
+    explicit ScheduleAwaiter(ThreadPool* POOL) noexcept : pool(POOL) {}
+
+    bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> HANDLE) noexcept
+    {
+      // - - - the coroutine may resume on a worker before this returns, nothing may touch `this` after the push
+      handle = HANDLE;
+      threadPoolPushIntrusive(pool, &task, resume, this);
+    }
+
+    void await_resume() noexcept {}
+
+  private:
+    static void resume(void* ARG) { static_cast<ScheduleAwaiter*>(ARG)->handle.resume(); }
+
+    ThreadPool*               pool;
+    ::Task                    task;
+    std::coroutine_handle<>   handle;
+  };
+
+  inline ScheduleAwaiter schedule(ThreadPool* POOL = threadPoolGetDefault()) noexcept { return ScheduleAwaiter(POOL); }
+
+
+  // - - - When all - - -
+
+  namespace detail
+  {
+    struct WhenAllLatch
+    {
+      explicit WhenAllLatch(size_t COUNT) noexcept : remaining(COUNT + 1) {}
+
+      std::atomic<size_t>       remaining;      // - - - unfinished tasks, plus one until the awaiting coroutine is suspended
+      std::coroutine_handle<>   awaiting;
+      std::atomic<bool>         failed{ false };
+      std::exception_ptr        exception;      // - - - the first one thrown, written by whoever set failed
+
+      // - - - true for the last one to arrive, which gets to resume the awaiting coroutine
+      bool arrive() noexcept { return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    };
+
+    // - - - drives one task of whenAll and counts it down when it is done
+    class WhenAllDriver
+    {
+    public:
+      struct promise_type
+      {
+        WhenAllLatch* latch;
+
+        template <typename... ARGS>
+        promise_type(WhenAllLatch* LATCH, ARGS&&...) noexcept : latch(LATCH) {}
+
+        struct FinalAwaiter
+        {
+          bool await_ready() noexcept { return false; }
+
+          std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> HANDLE) noexcept
+          {
+            WhenAllLatch* latch = HANDLE.promise().latch;
+            return latch->arrive() ? latch->awaiting : std::noop_coroutine();
+          }
+
+          void await_resume() noexcept {}
+        };
+
+        WhenAllDriver       get_return_object() noexcept { return WhenAllDriver(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend()   noexcept { return {}; }
+        FinalAwaiter        final_suspend()     noexcept { return {}; }
+        void                return_void()       noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+          if (!latch->failed.exchange(true, std::memory_order_acq_rel)) latch->exception = std::current_exception();
+        }
+      };
+
+      explicit WhenAllDriver(std::coroutine_handle<promise_type> HANDLE) noexcept : handle(HANDLE) {}
+      WhenAllDriver(WhenAllDriver&& OTHER) noexcept : handle(std::exchange(OTHER.handle, nullptr)) {}
+      WhenAllDriver(const WhenAllDriver&) = delete;
+
+      ~WhenAllDriver()
+      {
+        if (handle) handle.destroy();
+      }
+
+      void start() noexcept { handle.resume(); }
+
+    private:
+      std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename T>
+    WhenAllDriver whenAllDrive(WhenAllLatch* LATCH, Task<T>* TASK, std::optional<Value<T>>* SLOT)
+    {
+      if constexpr (std::is_void_v<T>)
+      {
+        co_await std::move(*TASK);
+        SLOT->emplace();
+      }
+      else SLOT->emplace(co_await std::move(*TASK));
+    }
+
+    // - - - starts every driver, then sleeps until the last one finishes
+    struct WhenAllAwaiter
+    {
+      WhenAllLatch*   latch;
+      WhenAllDriver*  drivers;
+      size_t          count;
+
+      bool await_ready() noexcept { return count == 0; }
+
+      bool await_suspend(std::coroutine_handle<> AWAITING) noexcept
+      {
+        latch->awaiting = AWAITING;
+        for (size_t i = 0; i < count; ++i) drivers[i].start();
+
+        // - - - all of them might be done already, then there is nobody left to resume us
+        return !latch->arrive();
+      }
+
+      void await_resume() noexcept {}
+    };
+  }
+
+  // - - - awaits every task and returns their results in order, void tasks give detail::Void.
+  // - - - the tasks start one after the other on the awaiting thread, the ones that begin with schedule() run in parallel
+  template <typename... TS>
+  Task<std::tuple<detail::Value<TS>...>> whenAll(Task<TS>... TASKS)
+  {
+    detail::WhenAllLatch                        latch(sizeof...(TS));
+    std::tuple<Task<TS>...>                     tasks(std::move(TASKS)...);
+    std::tuple<std::optional<detail::Value<TS>>...> slots;
+
+    auto drivers = [&]<size_t... I>(std::index_sequence<I...>)
+    {
+      return std::array<detail::WhenAllDriver, sizeof...(TS)>{ detail::whenAllDrive(&latch, &std::get<I>(tasks), &std::get<I>(slots))... };
+    }(std::index_sequence_for<TS...>{});
+
+    co_await detail::WhenAllAwaiter{ &latch, drivers.data(), drivers.size() };
+    if (latch.exception) std::rethrow_exception(latch.exception);
+
+    co_return [&]<size_t... I>(std::index_sequence<I...>)
+    {
+      return std::tuple<detail::Value<TS>...>(std::move(*std::get<I>(slots))...);
+    }(std::index_sequence_for<TS...>{});
+  }
+
+  // - - - same for any number of tasks of one type
+  template <typename T>
+  Task<std::vector<detail::Value<T>>> whenAll(std::vector<Task<T>> TASKS)
+  {
+    detail::WhenAllLatch                          latch(TASKS.size());
+    std::vector<std::optional<detail::Value<T>>>  slots(TASKS.size());
+    std::vector<detail::WhenAllDriver>            drivers;
+
+    drivers.reserve(TASKS.size());
+    for (size_t i = 0; i < TASKS.size(); ++i) drivers.push_back(detail::whenAllDrive(&latch, &TASKS[i], &slots[i]));
+
+    co_await detail::WhenAllAwaiter{ &latch, drivers.data(), drivers.size() };
+    if (latch.exception) std::rethrow_exception(latch.exception);
+
+    std::vector<detail::Value<T>> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) results.push_back(std::move(*slot));
+    co_return results;
+  }
+
+
+  // - - - Sync wait - - -
+
+  namespace detail
+  {
+    // - - - runs a task to completion and posts a semaphore from its final suspend point
+    class SyncWaitDriver
+    {
+    public:
+      struct promise_type
+      {
+        Semaphore* done;
+
+        template <typename... ARGS>
+        promise_type(Semaphore* DONE, ARGS&&...) noexcept : done(DONE) {}
+
+        struct FinalAwaiter
+        {
+          bool await_ready() noexcept { return false; }
+          void await_suspend(std::coroutine_handle<promise_type> HANDLE) noexcept { semaphorePost(HANDLE.promise().done); }
+          void await_resume() noexcept {}
+        };
+
+        SyncWaitDriver      get_return_object()   noexcept { return SyncWaitDriver(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend()     noexcept { return {}; }
+        FinalAwaiter        final_suspend()       noexcept { return {}; }
+        void                return_void()         noexcept {}
+        void                unhandled_exception() noexcept {}   // - - - the task keeps its own exception
+      };
+
+      explicit SyncWaitDriver(std::coroutine_handle<promise_type> HANDLE) noexcept : handle(HANDLE) {}
+      SyncWaitDriver(const SyncWaitDriver&) = delete;
+
+      ~SyncWaitDriver()
+      {
+        if (handle) handle.destroy();
+      }
+
+      void start() noexcept { handle.resume(); }
+
+    private:
+      std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename T>
+    SyncWaitDriver syncWaitDrive(Semaphore* DONE, Task<T>* TASK, std::optional<Value<T>>* SLOT, std::exception_ptr* EXCEPTION)
+    {
+      try
+      {
+        if constexpr (std::is_void_v<T>)
+        {
+          co_await std::move(*TASK);
+          SLOT->emplace();
+        }
+        else SLOT->emplace(co_await std::move(*TASK));
+      }
+      catch (...)
+      {
+        *EXCEPTION = std::current_exception();
+      }
+    }
+  }
+
+  // - - - blocks the calling thread until TASK is done and returns its result. The bridge from plain code into coroutines,
+  // - - - do not call it from a pool thread that TASK needs
+  template <typename T>
+  T syncWait(Task<T> TASK)
+  {
+    Semaphore                         done;
+    std::optional<detail::Value<T>>   slot;
+    std::exception_ptr                exception;
+    createSemaphore(&done, 0);
+
+    {
+      detail::SyncWaitDriver driver = detail::syncWaitDrive(&done, &TASK, &slot, &exception);
+      driver.start();
+      semaphoreWait(&done);
+    }
+    destroySemaphore(&done);
+
+    if (exception) std::rethrow_exception(exception);
+    if constexpr (!std::is_void_v<T>) return std::move(*slot);
+  }
+}
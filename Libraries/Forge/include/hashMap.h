@@ -1,5 +1,6 @@
 #pragma once 
 #include "defines.h"
+#include "allocator.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -10,35 +11,97 @@ typedef         void*                   (memoryAllocate)    (unsigned long SIZE)
 typedef         void                    (memoryDeallocate)  (void* MEM_ADDR);
 typedef         int                     (memoryCompare)     (const void* PTR_1,   const void* PTR_2,        unsigned long SIZE);
 
+// - - - slots are probed 16 control bytes at a time
+#define HASH_MAP_GROUP_WIDTH  16
+
+// - - - keys up to this many bytes are stored in the entry itself, longer ones get their own allocation
+#define HASH_MAP_INLINE_KEY   16
+
 typedef struct MapEntry
 {
-  char*                 key;
+  unsigned long long    hash;           // - - - the full hash, checked before the key and reused when the table grows
   unsigned long long    keySize;
+  union
+  {
+    char*               key;
+    char                inlineKey[HASH_MAP_INLINE_KEY];
+  };
   void*                 value;
-  struct MapEntry*      next;
 } MapEntry;
 
+// - - - open addressing, Swiss table style. Every slot has a control byte that is empty, deleted, or the top 7 bits
+// - - - of its key's hash, so a probe compares a whole group of them at once and only touches keys that likely match.
+// - - - Growing allocates the next table and moves the entries over a group at a time with every insert and remove,
+// - - - lookups check both tables until the old one is empty
 typedef struct HashMap
 {
-  unsigned long long    size;
+  unsigned long long    size;           // - - - number of slots, a power of two and a multiple of the group width
+  unsigned long long    count;          // - - - entries stored, in both tables while growing
+  unsigned long long    tombstones;     // - - - removed slots probes still walk past, until the next rehash
+  float                 maxLoad;        // - - - fraction of used and deleted slots that makes the table grow
+  unsigned long long    seed;           // - - - random per map, keeps the default hash from being attacked with chosen keys
   hashFunction*         hash;
-  memoryAllocate*       allocator;
+  memoryAllocate*       allocator;      // - - - what createHashMap was given, NULL with createHashMapWithAllocator
   memoryDeallocate*     deallocator;
   memoryCompare*        compare;
-  MapEntry**            elements;
+  ForgeAllocator        memory;         // - - - every table and key goes through this
+  unsigned char*        control;        // - - - one byte per slot
+  MapEntry*             elements;       // - - - the slots, in the same allocation as control
+  unsigned long long    oldSize;        // - - - the table being drained while growing, NULL control otherwise
+  unsigned long long    oldCount;
+  unsigned long long    migrated;       // - - - old slots before this one have been moved
+  unsigned char*        oldControl;
+  MapEntry*             oldElements;
 } HashMap;
 
+// - - - position of a walk over the occupied slots, the current table first and then the one being drained
+typedef struct HashMapIterator
+{
+  unsigned long long    slot;
+  bool                  old;
+} HashMapIterator;
+
 
+// - - - SIZE is the number of entries expected, the map grows past it on its own
 FORGE_API bool      createHashMap           (HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, memoryAllocate* MALLOC, memoryDeallocate* FREE, memoryCompare* MEMCMP);
 
+// - - - tables and long keys come from ALLOCATOR. With an arena, destroying the map can be skipped and the arena reset
+FORGE_API bool      createHashMapWithAllocator (HashMap* MAP, unsigned long long SIZE, hashFunction* HASH_FUNCTION, const ForgeAllocator* ALLOCATOR, memoryCompare* MEMCMP);
+
 FORGE_API bool      destroyHashMap          (HashMap* MAP);
 
+// - - - between 0 and 1, 0.875 by default. Lower trades memory for shorter probes
+FORGE_API void      hashMapSetMaxLoad       (HashMap* MAP, float MAX_LOAD);
+
+// - - - grows once, right now, to hold COUNT entries, so the inserts that follow never resize
+FORGE_API bool      hashMapReserve          (HashMap* MAP, unsigned long long COUNT);
+
+// - - - removes every entry but keeps the table, so filling it again up to the same size allocates nothing but long keys
+FORGE_API void      hashMapClear            (HashMap* MAP);
+
+// - - - replaces the random seed of the default hash, for reproducible layouts. Only on an empty map
+FORGE_API void      hashMapSetSeed          (HashMap* MAP, unsigned long long SEED);
+
+// - - - the default hash : wyhash, 16 to 48 bytes per step, exactly KEY_SIZE bytes read
+FORGE_API unsigned long long hashMapHashBytes (const void* KEY, unsigned long long KEY_SIZE, unsigned long long SEED);
+
 FORGE_API bool      hashMapInsert           (HashMap* MAP, const byteArray KEY,     unsigned long long KEY_SIZE, void* VALUE);
 
 FORGE_API void*     hashMapGet              (HashMap* MAP, const byteArray KEY,     unsigned long long KEY_SIZE);
 
 FORGE_API void*     hashMapRemove           (HashMap* MAP, const byteArray KEY,     unsigned long long KEY_SIZE);
 
+// - - - COUNT lookups at once. Every key is hashed and its bucket prefetched before any is compared, so the cache
+// - - - misses overlap instead of queueing. VALUES[i] is NULL for missing keys, returns how many were found
+FORGE_API unsigned long long hashMapGetBatch    (HashMap* MAP, const byteArray* KEYS, const unsigned long long* KEY_SIZES, unsigned long long COUNT, void** VALUES);
+
+// - - - COUNT inserts, prefetched the same way. Returns how many were stored
+FORGE_API unsigned long long hashMapInsertBatch (HashMap* MAP, const byteArray* KEYS, const unsigned long long* KEY_SIZES, void* const* VALUES, unsigned long long COUNT);
+
+// - - - walks the entries in slot order, 16 control bytes at a time. The map must not change during the walk, values may
+FORGE_API void      createHashMapIter       (HashMap* MAP, HashMapIterator* ITERATOR);
+FORGE_API bool      hashMapIterNext         (HashMap* MAP, HashMapIterator* ITERATOR, const char** KEY, unsigned long long* KEY_SIZE, void** VALUE);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,445 @@
+#pragma once
+#include "hashMap.h"
+#include "allocator.h"
+#include "logger.h"
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <sys/random.h>
+#include <time.h>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// - - - the Swiss table of hashMap.c as a template, header only. The hash and equality are types instead of function
+// - - - pointers, so the compiler inlines them into the probe, and entries hold the key and value themselves instead
+// - - - of key bytes and a void* to a value allocated somewhere else
+
+namespace forge
+{
+  // - - - Hashes - - -
+
+  // - - - anything std::hash knows. The map mixes every hash again, so weak ones like identity on integers are fine
+  template <typename T>
+  struct Hash : std::hash<T> {};
+
+  template <typename T>
+    requires (std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>)
+  struct Hash<T>
+  {
+    u64 operator()(T KEY) const noexcept
+    {
+      if constexpr (std::is_pointer_v<T>) return (u64)(uintptr_t)KEY;
+      else return (u64)KEY;
+    }
+  };
+
+  // - - - wyhash from hashMap.c. Transparent, a map with std::string keys is searched with string_view or char* as is.
+  // - - - The map hands its seed to hashes that take one, so colliding keys cannot be worked out ahead of time
+  struct StringHash
+  {
+    using is_transparent = void;
+
+    u64 operator()(std::string_view KEY)           const noexcept { return hashMapHashBytes(KEY.data(), KEY.size(), 0); }
+    u64 operator()(std::string_view KEY, u64 SEED) const noexcept { return hashMapHashBytes(KEY.data(), KEY.size(), SEED); }
+  };
+
+  template <> struct Hash<std::string>      : StringHash {};
+  template <> struct Hash<std::string_view> : StringHash {};
+
+  namespace detail
+  {
+    inline constexpr u8  CONTROL_EMPTY   = 0x80;
+    inline constexpr u8  CONTROL_DELETED = 0xFE;
+    inline constexpr u64 NOT_FOUND       = ~0ULL;
+
+    template <typename F>
+    concept Transparent = requires { typename F::is_transparent; };
+
+    // - - - one 64x64 -> 128 bit multiply, high and low halves folded, so the group index and the tag both see every bit
+    inline u64 mixHash(u64 HASH, u64 SEED) noexcept
+    {
+#if defined(__SIZEOF_INT128__)
+      __uint128_t product = (__uint128_t)(HASH ^ SEED) * 0x9E3779B97F4A7C15ULL;
+      return (u64)product ^ (u64)(product >> 64);
+#else
+      u64 hash = (HASH ^ SEED) * 0x9E3779B97F4A7C15ULL;
+      return hash ^ (hash >> 32);
+#endif
+    }
+
+    // - - - bit i is set when control byte i of the group equals TAG
+    inline u32 groupMatch(const u8* GROUP, u8 TAG) noexcept
+    {
+#if defined(__SSE2__)
+      __m128i control = _mm_loadu_si128((const __m128i*)GROUP);
+      return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)TAG)));
+#else
+      u32 mask = 0;
+      for (u32 i = 0; i < HASH_MAP_GROUP_WIDTH; ++i) mask |= (u32)(GROUP[i] == TAG) << i;
+      return mask;
+#endif
+    }
+
+    // - - - bit i is set when slot i of the group is empty or deleted
+    inline u32 groupMatchFree(const u8* GROUP) noexcept
+    {
+#if defined(__SSE2__)
+      return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)GROUP));
+#else
+      u32 mask = 0;
+      for (u32 i = 0; i < HASH_MAP_GROUP_WIDTH; ++i) mask |= (u32)(GROUP[i] >> 7) << i;
+      return mask;
+#endif
+    }
+
+    // - - - a power of two, at least one group, that holds COUNT entries under 7/8 load
+    inline u64 slotsFor(u64 COUNT) noexcept
+    {
+      u64 slots = HASH_MAP_GROUP_WIDTH;
+      while (COUNT * 8 > slots * 7) slots <<= 1;
+      return slots;
+    }
+  }
+
+
+  // - - - Hash Map - - -
+
+  // - - - same control bytes, groups and probing as the C HashMap. A full table is rehashed at once instead of drained
+  // - - - over the next operations, a C++ caller already pays for moving its values and gets the simpler table.
+  // - - - Memory comes from a ForgeAllocator, the heap when none is given. Pointers to values stay valid until an
+  // - - - insert rehashes, which moves every entry. That is growing, or rebuilding at the same size once tombstones
+  // - - - fill the table. Removing other keys never moves them
+  template <typename K, typename V, typename HASH = Hash<K>, typename EQ = std::equal_to<>>
+  class HashMap
+  {
+    struct Slot
+    {
+      template <typename KEY, typename... ARGS>
+      explicit Slot(KEY&& KEY_VALUE, ARGS&&... ARGUMENTS) : key(std::forward<KEY>(KEY_VALUE)), value(std::forward<ARGS>(ARGUMENTS)...) {}
+
+      K key;
+      V value;
+    };
+
+    // - - - the slots start right after the control bytes, which are a multiple of 16
+    static_assert(alignof(Slot) <= HASH_MAP_GROUP_WIDTH, "forge::HashMap entries can be aligned to 16 bytes at most");
+
+    // - - - K itself, or anything the hash and equality both take when they are transparent
+    template <typename LOOKUP>
+    static constexpr bool passThrough = std::is_same_v<std::remove_cvref_t<LOOKUP>, K>
+                                     || (detail::Transparent<HASH> && detail::Transparent<EQ>
+                                         && std::is_invocable_v<const HASH&, const LOOKUP&>
+                                         && std::is_invocable_r_v<bool, const EQ&, const K&, const LOOKUP&>);
+
+    // - - - other keys are converted to K first, like an int literal looked up in a map of u64
+    template <typename LOOKUP>
+    static constexpr bool lookupWith = passThrough<LOOKUP> || std::is_constructible_v<K, const LOOKUP&>;
+
+    template <typename LOOKUP>
+    static decltype(auto) asKey(const LOOKUP& KEY)
+    {
+      if constexpr (passThrough<LOOKUP>) return (KEY);
+      else return K(KEY);
+    }
+
+  public:
+    template <bool CONST>
+    class Iterator
+    {
+      using Map   = std::conditional_t<CONST, const HashMap, HashMap>;
+      using Value = std::conditional_t<CONST, const V, V>;
+
+    public:
+      Iterator(Map* MAP, u64 SLOT) noexcept : map(MAP), slot(SLOT) {}
+
+      // - - - a pair of references, `for (auto [key, value] : map)` binds straight to the entry
+      std::pair<const K&, Value&> operator*() const noexcept { return { map->slots[slot].key, map->slots[slot].value }; }
+
+      Iterator& operator++() noexcept
+      {
+        slot = map->nextFull(slot + 1);
+        return *this;
+      }
+
+      bool operator==(const Iterator& OTHER) const noexcept { return slot == OTHER.slot; }
+
+    private:
+      Map*  map;
+      u64   slot;
+    };
+
+    // - - - SIZE is the number of entries expected, nothing is allocated until the first insert when it is 0
+    explicit HashMap(u64 SIZE = 0, const ForgeAllocator* ALLOCATOR = nullptr, HASH HASHER = HASH(), EQ EQUAL = EQ())
+      : hasher(std::move(HASHER)), equal(std::move(EQUAL))
+    {
+      if (ALLOCATOR) memory = *ALLOCATOR;
+      else createHeapAllocator(&memory);
+
+      // - - - random per map, like the C map's seed it keeps chosen keys from piling into one group
+      if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed))
+      {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        seed = detail::mixHash((u64)ts.tv_nsec, (u64)(uintptr_t)this);
+      }
+
+      if (SIZE) rehash(detail::slotsFor(SIZE));
+    }
+
+    HashMap(HashMap&& OTHER) noexcept
+      : hasher(std::move(OTHER.hasher)), equal(std::move(OTHER.equal)), memory(OTHER.memory), seed(OTHER.seed),
+        size(std::exchange(OTHER.size, 0)), entries(std::exchange(OTHER.entries, 0)), tombstones(std::exchange(OTHER.tombstones, 0)),
+        control(std::exchange(OTHER.control, nullptr)), slots(std::exchange(OTHER.slots, nullptr)) {}
+
+    HashMap& operator=(HashMap&& OTHER) noexcept
+    {
+      if (this != &OTHER)
+      {
+        release();
+        hasher      = std::move(OTHER.hasher);
+        equal       = std::move(OTHER.equal);
+        memory      = OTHER.memory;
+        seed        = OTHER.seed;
+        size        = std::exchange(OTHER.size, 0);
+        entries     = std::exchange(OTHER.entries, 0);
+        tombstones  = std::exchange(OTHER.tombstones, 0);
+        control     = std::exchange(OTHER.control, nullptr);
+        slots       = std::exchange(OTHER.slots, nullptr);
+      }
+      return *this;
+    }
+
+    HashMap(const HashMap&) = delete;
+    HashMap& operator=(const HashMap&) = delete;
+
+    ~HashMap() { release(); }
+
+    u64  count()    const noexcept { return entries; }
+    u64  capacity() const noexcept { return size; }
+    bool isEmpty()  const noexcept { return entries == 0; }
+
+    // - - - NULL when the key is missing
+    template <typename LOOKUP> requires lookupWith<LOOKUP>
+    V* find(const LOOKUP& KEY)
+    {
+      const auto& key  = asKey(KEY);
+      u64         slot = findSlot(key, hashOf(key));
+      return slot == detail::NOT_FOUND ? nullptr : &slots[slot].value;
+    }
+
+    template <typename LOOKUP> requires lookupWith<LOOKUP>
+    const V* find(const LOOKUP& KEY) const { return const_cast<HashMap*>(this)->find(KEY); }
+
+    template <typename LOOKUP> requires lookupWith<LOOKUP>
+    bool contains(const LOOKUP& KEY) const { return find(KEY) != nullptr; }
+
+    // - - - builds the value in place from ARGUMENTS when the key is new, and the key from KEY, so a string_view only
+    // - - - becomes a std::string when it is stored. Returns the value and whether it was inserted
+    template <typename LOOKUP, typename... ARGS> requires lookupWith<LOOKUP>
+    std::pair<V*, bool> emplace(LOOKUP&& KEY, ARGS&&... ARGUMENTS)
+    {
+      const auto& key  = asKey(KEY);
+      u64         hash = hashOf(key);
+      u64         slot = findSlot(key, hash);
+      if (slot != detail::NOT_FOUND) return { &slots[slot].value, false };
+
+      if ((entries + tombstones + 1) * 8 > size * 7)
+      {
+        // - - - mostly tombstones, cleaning them up makes enough room without growing
+        if (entries * 16 < size * 7) rehash(size);
+        else                         rehash(size ? size * 2 : HASH_MAP_GROUP_WIDTH);
+      }
+
+      slot = findFreeSlot(hash);
+      std::construct_at(&slots[slot], std::forward<LOOKUP>(KEY), std::forward<ARGS>(ARGUMENTS)...);
+      if (control[slot] == detail::CONTROL_DELETED) tombstones--;
+      control[slot] = (u8)(hash >> 57);
+      entries++;
+      return { &slots[slot].value, true };
+    }
+
+    // - - - inserts or replaces, true when the key is new
+    template <typename LOOKUP, typename U> requires lookupWith<LOOKUP>
+    bool insert(LOOKUP&& KEY, U&& VALUE)
+    {
+      auto [value, inserted] = emplace(std::forward<LOOKUP>(KEY), std::forward<U>(VALUE));
+      // - - - VALUE was only moved from if the entry is new
+      if (!inserted) *value = std::forward<U>(VALUE);
+      return inserted;
+    }
+
+    // - - - the value, default constructed first when the key is missing
+    template <typename LOOKUP> requires lookupWith<LOOKUP>
+    V& operator[](LOOKUP&& KEY) { return *emplace(std::forward<LOOKUP>(KEY)).first; }
+
+    // - - - true when the key was there
+    template <typename LOOKUP> requires lookupWith<LOOKUP>
+    bool remove(const LOOKUP& KEY)
+    {
+      const auto& key  = asKey(KEY);
+      u64         slot = findSlot(key, hashOf(key));
+      if (slot == detail::NOT_FOUND) return false;
+
+      std::destroy_at(&slots[slot]);
+      entries--;
+
+      // - - - a group that still has an empty slot never made a probe move on, so the slot can be empty again
+      if (detail::groupMatch(control + slot / HASH_MAP_GROUP_WIDTH * HASH_MAP_GROUP_WIDTH, detail::CONTROL_EMPTY)) control[slot] = detail::CONTROL_EMPTY;
+      else
+      {
+        control[slot] = detail::CONTROL_DELETED;
+        tombstones++;
+      }
+      return true;
+    }
+
+    // - - - grows once, right now, to hold COUNT entries, so the inserts that follow never rehash
+    void reserve(u64 COUNT)
+    {
+      u64 needed = detail::slotsFor(COUNT);
+      if (needed > size) rehash(needed);
+    }
+
+    // - - - destroys every entry but keeps the table
+    void clear() noexcept
+    {
+      if constexpr (!std::is_trivially_destructible_v<Slot>)
+      {
+        for (u64 i = nextFull(0); i < size; i = nextFull(i + 1)) std::destroy_at(&slots[i]);
+      }
+      if (size) memset(control, detail::CONTROL_EMPTY, size);
+      entries    = 0;
+      tombstones = 0;
+    }
+
+    // - - - slot order. Inserting may rehash and ends the walk, values may change
+    Iterator<false> begin()       noexcept { return { this, nextFull(0) }; }
+    Iterator<false> end()         noexcept { return { this, size }; }
+    Iterator<true>  begin() const noexcept { return { this, nextFull(0) }; }
+    Iterator<true>  end()   const noexcept { return { this, size }; }
+
+  private:
+    template <typename LOOKUP>
+    u64 hashOf(const LOOKUP& KEY) const noexcept
+    {
+      if constexpr (std::is_invocable_v<const HASH&, const LOOKUP&, u64>) return detail::mixHash((u64)hasher(KEY, seed), seed);
+      else                                                                return detail::mixHash((u64)hasher(KEY), seed);
+    }
+
+    // - - - groups are visited in triangular steps, which reaches every group of a power of two table exactly once
+    template <typename LOOKUP>
+    u64 findSlot(const LOOKUP& KEY, u64 KEY_HASH) const noexcept
+    {
+      if (entries == 0) return detail::NOT_FOUND;
+
+      u64 groupMask = size / HASH_MAP_GROUP_WIDTH - 1;
+      u64 group     = KEY_HASH & groupMask;
+      u8  tag       = (u8)(KEY_HASH >> 57);
+
+      for (u64 step = 1; ; ++step)
+      {
+        const u8* groupControl = control + group * HASH_MAP_GROUP_WIDTH;
+        for (u32 match = detail::groupMatch(groupControl, tag); match; match &= match - 1)
+        {
+          u64 slot = group * HASH_MAP_GROUP_WIDTH + __builtin_ctz(match);
+          if (equal(slots[slot].key, KEY)) return slot;
+        }
+
+        // - - - an empty slot ends the probe, the key would have been put there
+        if (detail::groupMatch(groupControl, detail::CONTROL_EMPTY)) return detail::NOT_FOUND;
+        if (step > groupMask) return detail::NOT_FOUND;
+        group = (group + step) & groupMask;
+      }
+    }
+
+    u64 findFreeSlot(u64 KEY_HASH) const noexcept
+    {
+      u64 groupMask = size / HASH_MAP_GROUP_WIDTH - 1;
+      u64 group     = KEY_HASH & groupMask;
+
+      for (u64 step = 1; ; ++step)
+      {
+        u32 free = detail::groupMatchFree(control + group * HASH_MAP_GROUP_WIDTH);
+        if (free) return group * HASH_MAP_GROUP_WIDTH + __builtin_ctz(free);
+        group = (group + step) & groupMask;
+      }
+    }
+
+    // - - - the first used slot from SLOT on, size when there is none
+    u64 nextFull(u64 SLOT) const noexcept
+    {
+      while (SLOT < size)
+      {
+        u64 group = SLOT & ~(u64)(HASH_MAP_GROUP_WIDTH - 1);
+        u32 full  = ~detail::groupMatchFree(control + group) & 0xFFFFu & (0xFFFFu << (SLOT - group));
+        if (full) return group + __builtin_ctz(full);
+        SLOT = group + HASH_MAP_GROUP_WIDTH;
+      }
+      return size;
+    }
+
+    // - - - moves every entry into a new table of SIZE slots, which also drops the tombstones
+    void rehash(u64 SIZE)
+    {
+      u8* table = (u8*)memory.allocate(memory.context, SIZE + SIZE * sizeof(Slot));
+      if (table == nullptr)
+      {
+        FORGE_LOG_ERROR("Memory Allocator failed for HashMap entries");
+        throw std::bad_alloc();
+      }
+      memset(table, detail::CONTROL_EMPTY, SIZE);
+
+      u8*   oldControl = control;
+      Slot* oldSlots   = slots;
+      u64   oldSize    = size;
+
+      control    = table;
+      slots      = (Slot*)(table + SIZE);
+      size       = SIZE;
+      tombstones = 0;
+
+      for (u64 i = 0; i < oldSize; ++i)
+      {
+        if (oldControl[i] & detail::CONTROL_EMPTY) continue;
+        u64 hash = hashOf(oldSlots[i].key);
+        u64 slot = findFreeSlot(hash);
+        std::construct_at(&slots[slot], std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+        std::destroy_at(&oldSlots[i]);
+        control[slot] = (u8)(hash >> 57);
+      }
+
+      if (oldControl) memory.deallocate(memory.context, oldControl, oldSize + oldSize * sizeof(Slot));
+    }
+
+    void release() noexcept
+    {
+      if (control == nullptr) return;
+      if constexpr (!std::is_trivially_destructible_v<Slot>)
+      {
+        for (u64 i = nextFull(0); i < size; i = nextFull(i + 1)) std::destroy_at(&slots[i]);
+      }
+      memory.deallocate(memory.context, control, size + size * sizeof(Slot));
+      control = nullptr;
+      slots   = nullptr;
+      size    = 0;
+    }
+
+    [[no_unique_address]] HASH  hasher;
+    [[no_unique_address]] EQ    equal;
+    ForgeAllocator              memory;
+    u64                         seed        = 0;
+    u64                         size        = 0;          // - - - number of slots, a power of two and a multiple of the group width
+    u64                         entries     = 0;
+    u64                         tombstones  = 0;          // - - - removed slots probes still walk past, until the next rehash
+    u8*                         control     = nullptr;    // - - - one byte per slot
+    Slot*                       slots       = nullptr;    // - - - in the same allocation as control
+  };
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "defines.h"
+#include "allocator.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// - - - marks a free slot. A real key 0 is kept outside the slots, so every u64 is a valid key
+#define INT_MAP_EMPTY_KEY 0
+
+typedef struct IntMapSlot
+{
+  u64                   key;
+  void*                 value;
+} IntMapSlot;
+
+// - - - HashMap for 8 byte keys such as ids. Keys sit in the slots next to their values, probing is linear from the
+// - - - key's mixed hash, and keys are compared with ==, so a lookup makes no indirect calls, allocations or memcmp.
+// - - - Removing shifts the entries after it back, there are no tombstones
+typedef struct IntMap
+{
+  u64                   size;           // - - - number of slots, a power of two
+  u64                   count;          // - - - entries, the one with key 0 included
+  u64                   seed;
+  IntMapSlot*           slots;
+  bool                  hasZeroKey;
+  void*                 zeroKeyValue;
+  ForgeAllocator        memory;
+} IntMap;
+
+
+// - - - SIZE is the number of entries expected. ALLOCATOR may be NULL for the heap
+FORGE_API bool      createIntMap    (IntMap* MAP, u64 SIZE, const ForgeAllocator* ALLOCATOR);
+
+FORGE_API bool      destroyIntMap   (IntMap* MAP);
+
+// - - - inserts or replaces. NULL values are refused, NULL is what intMapGet returns for missing keys
+FORGE_API bool      intMapInsert    (IntMap* MAP, u64 KEY, void* VALUE);
+
+FORGE_API void*     intMapGet       (IntMap* MAP, u64 KEY);
+
+FORGE_API void*     intMapRemove    (IntMap* MAP, u64 KEY);
+
+// - - - grows once to hold COUNT entries
+FORGE_API bool      intMapReserve   (IntMap* MAP, u64 COUNT);
+
+// - - - removes every entry and keeps the slots
+FORGE_API void      intMapClear     (IntMap* MAP);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,6 @@
 #pragma once 
 #include "defines.h"
+#include "allocator.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,8 +42,9 @@ typedef struct OrderedSet
   u64                 keySize;
   u64                 size;
   memoryCompare*      compare;
-  memoryAllocate*     allocator;
+  memoryAllocate*     allocator;    // - - - what createOrderedSet was given, NULL with createOrderedSetWithAllocator
   memoryDeallocate*   deallocator;
+  ForgeAllocator      memory;       // - - - every node goes through this
 } OrderedSet;
 
 
@@ -50,6 +52,7 @@ typedef struct OrderedSet
 
 // - - - Create and Destroy
 FORGE_API void      createOrderedSet      (OrderedSet* SET, u64 KEY_SIZE, memoryCompare* COMPARE, memoryAllocate* MALLOC, memoryDeallocate* FREE);
+FORGE_API void      createOrderedSetWithAllocator (OrderedSet* SET, u64 KEY_SIZE, memoryCompare* COMPARE, const ForgeAllocator* ALLOCATOR);
 FORGE_API void      destroyOrderedSet     (OrderedSet* SET);
 FORGE_API void      clearOrderedSet       (OrderedSet* SET);
 FORGE_API u64       getOrderedSetSize     (OrderedSet* SET);
@@ -0,0 +1,57 @@
+#pragma once
+#include "defines.h"
+#include "threadPool.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// - - - bounded multi producer multi consumer queue of fixed size elements. Every cell carries a sequence number
+// - - - that says whose turn it is, so pushes and pops only fight over one counter each and never take a lock
+typedef struct RingQueue
+{
+  u8*               cells;              // - - - capacity cells, each a u64 sequence followed by the element
+  u64               capacity;           // - - - power of two
+  u64               mask;
+  u64               elementSize;
+  u64               stride;             // - - - bytes per cell, sequence included
+  u8                padding0[24];       // - - - producers, consumers and the fields above each get their own cache line
+  volatile u64      head;               // - - - next position to push to
+  u8                padding1[56];
+  volatile u64      tail;               // - - - next position to pop from
+  u8                padding2[56];
+  volatile u32      pushWaiters;        // - - - threads asleep in ringQueuePush because it was full
+  volatile u32      popWaiters;         // - - - threads asleep in ringQueuePop because it was empty
+  Semaphore         notFull;
+  Semaphore         notEmpty;
+} RingQueue;
+
+// - - - CAPACITY is rounded up to a power of two
+FORGE_API void  createRingQueue       (RingQueue* QUEUE, u64 CAPACITY, u64 ELEMENT_SIZE);
+
+// - - - nobody may be pushing or popping anymore
+FORGE_API void  destroyRingQueue      (RingQueue* QUEUE);
+
+// - - - copies ELEMENT in, false when the queue is full
+FORGE_API bool  ringQueueTryPush      (RingQueue* QUEUE, const void* ELEMENT);
+
+// - - - copies the oldest element out to ELEMENT, false when the queue is empty
+FORGE_API bool  ringQueueTryPop       (RingQueue* QUEUE, void* ELEMENT);
+
+// - - - pushes as many of COUNT contiguous elements as fit with a single claim, returns how many
+FORGE_API u64   ringQueueTryPushBatch (RingQueue* QUEUE, const void* ELEMENTS, u64 COUNT);
+
+// - - - pops up to COUNT elements into ELEMENTS with a single claim, returns how many
+FORGE_API u64   ringQueueTryPopBatch  (RingQueue* QUEUE, void* ELEMENTS, u64 COUNT);
+
+// - - - blocking push, spins for a while then sleeps until a pop makes room
+FORGE_API void  ringQueuePush         (RingQueue* QUEUE, const void* ELEMENT);
+
+// - - - blocking pop, spins for a while then sleeps until a push brings something
+FORGE_API void  ringQueuePop          (RingQueue* QUEUE, void* ELEMENT);
+
+// - - - number of elements in the queue, only a snapshot while others push and pop
+FORGE_API u64   ringQueueSize         (RingQueue* QUEUE);
+
+#ifdef __cplusplus
+}
+#endif
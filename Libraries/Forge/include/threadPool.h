@@ -9,60 +9,388 @@ extern "C" {
 typedef pthread_mutex_t Lock;
 typedef pthread_cond_t  Conditional;
 
-typedef struct Thread 
-{
-  i32                 id;       // - - - id of the thread
-  pthread_t           pthread;  // - - - the actual thread
-} Thread;
-
+// - - - counting semaphore, spins for a while then parks on a futex. Posting and waiting stay in user space unless someone sleeps
 typedef struct Semaphore
 {
-  Lock        lock;
-  Conditional conditional;
-  u8          value;
+  volatile i32  count;    // - - - available posts, minus the number of waiting threads when negative
+  volatile u32  wakeups;  // - - - posts handed to waiting threads, the futex word they park on
 } Semaphore;
 
 typedef struct Task 
 {
   void(*function)       (void*);        // - - - thread function 
   void*                 argument;       // - - - argument
-  struct Task*          previous;       // - - - previous job
+  struct Task*          previous;       // - - - previous job, or next free task while recycled
+  bool                  pooled;         // - - - owned and recycled by the pool, false for intrusive tasks
+  u64                   enqueuedAt;     // - - - monotonic nanoseconds at push, only with telemetry or elastic pools
 } Task;
 
+typedef enum TaskPriority
+{
+  TASK_PRIORITY_HIGH        = 0,        // - - - latency sensitive, jumps ahead of everything queued
+  TASK_PRIORITY_NORMAL      = 1,        // - - - what threadPoolPush uses
+  TASK_PRIORITY_BACKGROUND  = 2,        // - - - runs when nothing else is queued, or on its starvation turn
+  TASK_PRIORITY_COUNT
+} TaskPriority;
+
+typedef struct TaskLane
+{
+  Task*                 front;          // - - - pointer to front of the lane
+  Task*                 end;            // - - - pointer to rear of the lane
+  u64                   size;           // - - - number of jobs in the lane
+} TaskLane;
+
 typedef struct TaskQueue
 {
   Lock                  readWriteLock;  // - - - used for queue r/w access
-  Task*                 front;          // - - - pointer to front of the queue
-  Task*                 end;            // - - - pointer to rear of the queue
+  TaskLane              lanes[TASK_PRIORITY_COUNT]; // - - - one FIFO per priority
   Semaphore       availability;   // - - - flag 
-  u64                   size;           // - - - number of jobs in queue
+  u64                   size;           // - - - number of jobs in all lanes
+  u64                   pulls;          // - - - every few pulls go to a lower lane first so it cannot starve
+  u64                   sizeHighWater;  // - - - deepest all lanes got since the last stats reset
+  Task*                 freeTasks;      // - - - recycled tasks for pushes from outside the pool, guarded by readWriteLock
 } TaskQueue;
 
+// - - - Chase-Lev deque : the owner pushes and pops at the bottom, idle threads steal from the top
+typedef struct TaskDeque
+{
+  volatile i64              top;          // - - - next task to be stolen
+  u8                        padding[56];  // - - - keep thieves and the owner on separate cache lines
+  volatile i64              bottom;       // - - - next free slot for the owner
+  struct TaskDequeBuffer*   buffer;       // - - - circular array of tasks, grows when full
+} TaskDeque;
+
+typedef enum ThreadPoolPinning
+{
+  THREAD_POOL_PIN_NONE      = 0,      // - - - the scheduler moves threads around freely
+  THREAD_POOL_PIN_COMPACT   = 1,      // - - - fill one NUMA node before the next, threads share caches
+  THREAD_POOL_PIN_SCATTER   = 2,      // - - - take turns between NUMA nodes, more memory bandwidth
+  THREAD_POOL_PIN_LIST      = 3,      // - - - thread i runs on cpus[i % cpuCount]
+} ThreadPoolPinning;
+
+#define THREAD_POOL_HISTOGRAM_BUCKETS 256
+
+// - - - log linear histogram of nanoseconds : exact below 4, then 4 buckets per power of two (within 25%)
+typedef struct ThreadPoolHistogram
+{
+  u64   counts[THREAD_POOL_HISTOGRAM_BUCKETS];
+  u64   total;                          // - - - number of samples
+  u64   sum;                            // - - - for the mean
+  u64   max;                            // - - - since the last reset
+} ThreadPoolHistogram;
+
+typedef struct ThreadPoolWorkerStats
+{
+  u64                 tasksExecuted;
+  u64                 steals;               // - - - tasks taken from other threads' deques
+  u64                 idleNanoseconds;      // - - - time spent asleep waiting for work, only with telemetry on
+  u64                 queueDepthHighWater;  // - - - deepest this thread's deque got, the deepest of them in pool totals
+  ThreadPoolHistogram queueWait;            // - - - push to start, only with telemetry on
+  ThreadPoolHistogram runTime;              // - - - start to finish, only with telemetry on
+} ThreadPoolWorkerStats;
+
+typedef struct ThreadPoolStats
+{
+  u32                   threadCount;          // - - - alive right now, an elastic pool changes it
+  u64                   queueDepthHighWater;  // - - - deepest the shared queue got
+  ThreadPoolWorkerStats workers;              // - - - every thread of the pool added up, maxima are the largest
+} ThreadPoolStats;
+
+typedef enum ThreadState
+{
+  THREAD_STATE_EMPTY        = 0,      // - - - no thread in this slot, an elastic pool can start one here
+  THREAD_STATE_STARTING     = 1,      // - - - created, not running tasks yet
+  THREAD_STATE_RUNNING      = 2,
+  THREAD_STATE_RETIRED      = 3,      // - - - exited after idling too long, waiting to be joined
+} ThreadState;
+
+typedef struct Thread 
+{
+  i32                 id;           // - - - id of the thread
+  struct ThreadPool*  pool;         // - - - the pool this thread works for
+  pthread_t           pthread;      // - - - the actual thread
+  TaskDeque           deque;        // - - - tasks pushed from this thread
+  u64                 randomState;  // - - - used to pick a victim to steal from
+  u32                 turns;        // - - - task searches so far, every few go to the shared queue before the deque
+  Task*               freeTasks;    // - - - recycled tasks, only touched by this thread
+  u32                 freeTaskCount;
+  i32                 cpu;          // - - - pinned cpu, -1 when the scheduler picks
+  u32                 node;         // - - - NUMA node of that cpu, thieves look here first
+  ThreadPoolWorkerStats stats;      // - - - only written by this thread, no atomics on the hot path
+  ThreadPoolWorkerStats statsBaseline; // - - - stats at the last reset, subtracted from snapshots
+  volatile ThreadState state;       // - - - slots of an elastic pool come and go
+} Thread;
+
+typedef struct ThreadPoolConfig
+{
+  u32           threadCount;            // - - - 0 to match CPU hardware specification. The minimum of an elastic pool
+  u64           stackSize;              // - - - bytes per thread, 0 for the system default
+  const char*   name;                   // - - - threads are named "<name>-<id>", NULL for "forge"
+  ThreadPoolPinning pinning;            // - - - where the threads run, THREAD_POOL_PIN_NONE by default
+  const u32*    cpus;                   // - - - only for THREAD_POOL_PIN_LIST
+  u32           cpuCount;
+  bool          telemetry;              // - - - time every task for the histograms, a clock read per push and two per run
+  u32           maxThreadCount;         // - - - above threadCount makes the pool elastic, 0 keeps it fixed
+  u64           growAfter;              // - - - nanoseconds queued work may wait before an elastic pool adds a thread, 0 for 1 ms
+  u64           retireAfter;            // - - - nanoseconds an extra thread may idle before it exits, 0 for 2 s
+} ThreadPoolConfig;
+
 typedef struct ThreadPool 
 {
   Lock          threadCountLock;        // - - - used for thread count update
-  Thread**      threads;                // - - - the threads 
-  volatile u8   numThreadsAlive;        // - - - how many threads are alive 
-  volatile u8   numThreadsWorking;      // - - - threads currently working 
+  Thread**      threads;                // - - - the threads, room for maxThreads so they never move
+  volatile u32  threadSlots;            // - - - slots ever used, thieves look at all of them
+  volatile u32  numThreadsAlive;        // - - - how many threads are alive 
+  volatile u32  numThreadsWorking;      // - - - threads currently working 
+  volatile u64  numTasksPending;        // - - - tasks pushed but not finished yet
   Conditional   allIdle;                // - - - signal to wait 
-  TaskQueue     taskQueue;              // - - - the tasks
+  TaskQueue     taskQueue;              // - - - tasks pushed from outside the pool
+  Task*         returnedTasks;          // - - - lock free stack of tasks spilled from the thread caches
+  struct TaskChunk* taskChunks;         // - - - every chunk of tasks ever allocated, freed with the pool
+  u64           stackSize;              // - - - stack size of every thread
+  char          name[16];               // - - - thread name prefix
+  bool          telemetry;              // - - - tasks are timed
+  Lock          statsLock;              // - - - serializes snapshots and resets
+  bool          elastic;                // - - - a supervisor adds threads under load and idle ones retire
+  u32           minThreads;
+  u32           maxThreads;
+  u64           growAfter;
+  u64           retireAfter;
+  pthread_t     supervisor;
+  Semaphore     supervisorWake;         // - - - posted to stop the supervisor early
+  struct TimerWheel* timers;            // - - - delayed and periodic tasks, its thread starts with the first timer
+  volatile bool created;                // - - - threads are up and accepting tasks
+  volatile bool running;                // - - - cleared to make the threads exit
 } ThreadPool;
 
+// - - - tasks that are waited on and cancelled together, apart from the rest of the pool. The memory belongs to the caller
+typedef struct TaskGroup
+{
+  ThreadPool*             pool;           // - - - where its tasks run
+  Lock                    lock;           // - - - guards everything below
+  Conditional             changed;        // - - - a task finished or was pushed while someone waits
+  struct TaskGroupItem*   front;          // - - - pushed and not started yet, oldest first
+  struct TaskGroupItem*   end;
+  u64                     pending;        // - - - pushed and neither finished nor dropped
+  u32                     waiters;
+  volatile bool           cancelled;      // - - - stays set until the group is destroyed
+} TaskGroup;
+
+// - - - a delayed or periodic task. The memory belongs to the caller, starts zeroed and must live until it fired or was cancelled
+typedef struct Timer
+{
+  struct Timer*           next;           // - - - neighbours in its wheel slot, unlinked in O(1)
+  struct Timer*           previous;
+  ThreadPool*             pool;           // - - - where it runs when it fires
+  void                    (*function)(void*);
+  void*                   argument;
+  u64                     deadline;       // - - - tick it fires on
+  u64                     period;         // - - - ticks between firings, 0 for one shot
+  u32                     slot;           // - - - level * slots per level + slot while pending
+  bool                    pending;        // - - - in the wheel, guarded by the wheel lock
+} Timer;
+
+// - - - a task with a result that others can wait on and depend on. The memory belongs to the caller
+typedef struct TaskFuture
+{
+  Task                    task;           // - - - scheduled without allocating once every dependency is done
+  ThreadPool*             pool;           // - - - where it runs
+  void*                   (*function)(void*);
+  void*                   argument;
+  void*                   result;         // - - - what FUNCTION returned, valid once done
+  volatile u32            dependencies;   // - - - unfinished dependencies, plus one until submitted
+  volatile bool           submitted;
+  volatile bool           done;
+  Lock                    lock;           // - - - guards successors and done
+  Conditional             finished;
+  struct TaskFutureLink*  successors;     // - - - futures to release when this one is done
+} TaskFuture;
+
 
 // - - - Functions - - - 
 
+// - - - Semaphore - - -
+
+FORGE_API void        createSemaphore         (Semaphore* SEM, u32 VALUE);
+
+// - - - nobody may be waiting on SEM anymore
+FORGE_API void        destroySemaphore        (Semaphore* SEM);
+
+// - - - blocks until a post is available and takes it
+FORGE_API void        semaphoreWait           (Semaphore* SEM);
+
+// - - - semaphoreWait giving up after NANOSECONDS, false when it timed out without taking a post
+FORGE_API bool        semaphoreWaitFor        (Semaphore* SEM, u64 NANOSECONDS);
+
+FORGE_API void        semaphorePost           (Semaphore* SEM);
+
+// - - - COUNT posts at once, wakes at most COUNT sleepers
+FORGE_API void        semaphorePostMany       (Semaphore* SEM, u32 COUNT);
+
+
+// - - - Pools - - -
+
+// - - - CONFIG may be NULL for the defaults. Every pool has its own threads and queues, tasks never move between pools
+// - - - with maxThreadCount above threadCount, a supervisor thread adds a thread whenever queued work waited longer than
+// - - - growAfter (tasks blocked on I/O), and threads above threadCount exit after idling for retireAfter
+FORGE_API bool        createThreadPool        (ThreadPool* POOL, const ThreadPoolConfig* CONFIG);
+
+// - - - push a task to POOL. Tasks pushed from inside a task of POOL stay on that thread unless stolen
+FORGE_API void        threadPoolPush          (ThreadPool* POOL, void (*FUNCTION)(void*), void* ARGUMENT);
+
+// - - - HIGH tasks are picked before the thread's own work, BACKGROUND ones only when the other lanes are empty
+// - - - or on their turn. Lower lanes still get every few pulls, so they cannot starve
+FORGE_API void        threadPoolPushPriority  (ThreadPool* POOL, void (*FUNCTION)(void*), void* ARGUMENT, TaskPriority PRIORITY);
+
+// - - - push COUNT tasks at once, FUNCTIONS[i] gets ARGUMENTS[i] (ARGUMENTS may be NULL).
+// - - - takes the queue lock once and wakes no more threads than there are idle ones
+FORGE_API void        threadPoolPushBatch     (ThreadPool* POOL, void (**FUNCTIONS)(void*), void** ARGUMENTS, u64 COUNT);
+
+// - - - push a task embedded in the caller's own struct, no allocation at all.
+// - - - TASK must stay alive until FUNCTION starts, FUNCTION may free or reuse it
+FORGE_API void        threadPoolPushIntrusive (ThreadPool* POOL, Task* TASK, void (*FUNCTION)(void*), void* ARGUMENT);
+
+// - - - blocking wait for all tasks of POOL to finish
+FORGE_API void        threadPoolWait          (ThreadPool* POOL);
+
+// - - - wait for all running tasks to finish, drop the queued ones and free all memory
+FORGE_API void        destroyThreadPool       (ThreadPool* POOL);
+
+// - - - SIZE bytes on the NUMA node the calling thread runs on, page granular. For per thread buffers of pinned pools
+FORGE_API void*       threadPoolAllocateLocal (u64 SIZE);
+
+// - - - SIZE must match the allocation
+FORGE_API void        threadPoolFreeLocal     (void* MEMORY, u64 SIZE);
+
+// - - - the pool used by the functions below
+FORGE_API ThreadPool* threadPoolGetDefault    ();
+
+
+// - - - Telemetry - - -
+
+// - - - every thread of POOL added up since the last reset. Tasks run by threads outside the pool are not counted
+FORGE_API ThreadPoolStats       threadPoolStatsSnapshot       (ThreadPool* POOL);
+
+// - - - one thread of POOL since the last reset
+FORGE_API ThreadPoolWorkerStats threadPoolWorkerStatsSnapshot (ThreadPool* POOL, u32 WORKER);
+
+// - - - start counting from zero, the threads keep running
+FORGE_API void                  threadPoolStatsReset          (ThreadPool* POOL);
+
+// - - - upper bound of the bucket holding the PERCENTILE (0 - 100) sample, 0 when empty
+FORGE_API u64                   threadPoolHistogramPercentile (const ThreadPoolHistogram* HISTOGRAM, f64 PERCENTILE);
+
+
+// - - - Futures - - -
+
+// - - - nothing runs until taskFutureSubmit, add the dependencies in between
+FORGE_API void        createTaskFuture        (TaskFuture* FUTURE, ThreadPool* POOL, void* (*FUNCTION)(void*), void* ARGUMENT);
+
+// - - - FUTURE runs only after DEPENDENCY is done. "run B after A and C" is two calls on B
+FORGE_API void        taskFutureAddDependency (TaskFuture* FUTURE, TaskFuture* DEPENDENCY);
+
+// - - - FUTURE is pushed the moment its last dependency finishes, or right now when there are none
+FORGE_API void        taskFutureSubmit        (TaskFuture* FUTURE);
+
+FORGE_API bool        taskFutureIsDone        (TaskFuture* FUTURE);
+
+// - - - blocking wait for FUTURE alone, returns its result. Threads of the same pool run other tasks meanwhile
+FORGE_API void*       taskFutureWait          (TaskFuture* FUTURE);
+
+// - - - FUTURE must be done, or never submitted
+FORGE_API void        destroyTaskFuture       (TaskFuture* FUTURE);
+
+
+// - - - Task groups - - -
+
+FORGE_API void        createTaskGroup         (TaskGroup* GROUP, ThreadPool* POOL);
+
+// - - - push a task to the group's pool that belongs to GROUP
+FORGE_API void        taskGroupPush           (TaskGroup* GROUP, void (*FUNCTION)(void*), void* ARGUMENT);
+
+// - - - blocking wait for the tasks of GROUP alone. The caller runs the ones that have not started yet itself,
+// - - - and only sleeps while the rest are running elsewhere
+FORGE_API void        taskGroupWait           (TaskGroup* GROUP);
+
+// - - - tasks of GROUP that have not started are dropped, now and when pushed later. Running ones finish,
+// - - - they can poll taskGroupIsCancelled to stop early
+FORGE_API void        taskGroupCancel         (TaskGroup* GROUP);
+
+FORGE_API bool        taskGroupIsCancelled    (TaskGroup* GROUP);
+
+// - - - the group of the task running on this thread, NULL outside of group tasks
+FORGE_API TaskGroup*  taskGroupCurrent        ();
+
+// - - - GROUP must have nothing pending, wait on it first
+FORGE_API void        destroyTaskGroup        (TaskGroup* GROUP);
+
+
+// - - - Timers - - -
+
+// - - - pushes FUNCTION(ARGUMENT) to POOL once DELAY nanoseconds passed, never earlier. Timers tick every millisecond,
+// - - - scheduling and cancelling are O(1) however many are pending. threadPoolWait does not wait for timers
+FORGE_API void        threadPoolSchedule      (ThreadPool* POOL, Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY);
+
+// - - - same, then again every PERIOD nanoseconds until cancelled. A tick that was missed is skipped, not made up for
+FORGE_API void        threadPoolSchedulePeriodic(ThreadPool* POOL, Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY, u64 PERIOD);
+
+// - - - true when TIMER was still pending. A task it pushed already may still be running after this returns
+FORGE_API bool        threadPoolCancelTimer   (Timer* TIMER);
+
+
+// - - - Parallel loops - - -
+
+// - - - calls FUNCTION(begin, end, CONTEXT) on pieces of [BEGIN, END) no smaller than GRAIN, 0 picks one. Returns when all are done.
+// - - - the range is cut in halves only while other threads are hungry, and the calling thread runs pieces too
+FORGE_API void        threadPoolParallelFor   (ThreadPool* POOL, u64 BEGIN, u64 END, u64 GRAIN, void (*FUNCTION)(u64 BEGIN, u64 END, void* CONTEXT), void* CONTEXT);
+
+// - - - REDUCE folds a piece into a partial result that starts as a copy of IDENTITY, COMBINE folds FROM into INTO.
+// - - - partials are combined in range order so COMBINE only has to be associative. The total lands in RESULT
+FORGE_API void        threadPoolParallelReduce(ThreadPool* POOL, u64 BEGIN, u64 END, u64 GRAIN, void* RESULT, const void* IDENTITY, u64 RESULT_SIZE,
+                                               void (*REDUCE)(u64 BEGIN, u64 END, void* CONTEXT, void* PARTIAL),
+                                               void (*COMBINE)(void* INTO, const void* FROM, void* CONTEXT), void* CONTEXT);
+
+
+// - - - Default pool - - -
+
 // - - - pass 0 as the number of threads to match CPU hardware specification
-FORGE_API bool  threadPoolInit         (u8 THREAD_COUNT);
+FORGE_API bool  threadPoolInit         (u32 THREAD_COUNT);
 
-// - - - add all tasks to thread pool
+// - - - elastic default pool, between MIN_THREADS and MAX_THREADS threads with the default timings
+FORGE_API bool  threadPoolInitElastic  (u32 MIN_THREADS, u32 MAX_THREADS);
+
+// - - - add all tasks to thread pool. Tasks pushed from inside a task stay on that thread unless stolen
 FORGE_API void  threadPoolTaskPush     (void (*FUNCTION)(void*), void* ARGUMENT);
 
+// - - - threadPoolPushPriority on the default pool
+FORGE_API void  threadPoolTaskPushPriority(void (*FUNCTION)(void*), void* ARGUMENT, TaskPriority PRIORITY);
+
+// - - - threadPoolPushBatch on the default pool
+FORGE_API void  threadPoolTaskPushBatch(void (**FUNCTIONS)(void*), void** ARGUMENTS, u64 COUNT);
+
+// - - - threadPoolPushIntrusive on the default pool
+FORGE_API void  threadPoolTaskPushIntrusive(Task* TASK, void (*FUNCTION)(void*), void* ARGUMENT);
+
+// - - - threadPoolSchedule on the default pool
+FORGE_API void  threadPoolTaskSchedule (Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY);
+
+// - - - threadPoolSchedulePeriodic on the default pool
+FORGE_API void  threadPoolTaskSchedulePeriodic(Timer* TIMER, void (*FUNCTION)(void*), void* ARGUMENT, u64 DELAY, u64 PERIOD);
+
 // - - - wait for all running tasks to finish and clear all queued tasks and free all memory
 FORGE_API void  threadPoolDestroy      ();
 
 // - - - blocking wait for all tasks to finish
 FORGE_API void  threadPoolWaitToFinish ();
 
+// - - - threadPoolParallelFor on the default pool
+FORGE_API void  parallelFor            (u64 BEGIN, u64 END, u64 GRAIN, void (*FUNCTION)(u64 BEGIN, u64 END, void* CONTEXT), void* CONTEXT);
+
+// - - - threadPoolParallelReduce on the default pool
+FORGE_API void  parallelReduce         (u64 BEGIN, u64 END, u64 GRAIN, void* RESULT, const void* IDENTITY, u64 RESULT_SIZE,
+                                        void (*REDUCE)(u64 BEGIN, u64 END, void* CONTEXT, void* PARTIAL),
+                                        void (*COMBINE)(void* INTO, const void* FROM, void* CONTEXT), void* CONTEXT);
+
 #ifdef __cplusplus
 }
 #endif
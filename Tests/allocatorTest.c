@@ -0,0 +1,143 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/allocator.h"
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/orderedSet.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+
+#define ARENA_SIZE  (1 << 22)
+#define REQUESTS    50
+
+static unsigned long long keyOf(u64 INDEX, char* KEY)
+{
+  return (unsigned long long)snprintf(KEY, 64, "a-long-enough-key-to-be-allocated-%llu", INDEX);
+}
+
+u8 testArenaHashMap()
+{
+  LinearAllocator arena;
+  createLinearAllocator(ARENA_SIZE, 0, NULL, &arena);
+  ForgeAllocator  memory;
+  createArenaAllocator(&memory, &arena);
+
+  // - - - a map per request, thrown away by resetting the arena instead of destroying it
+  char key[64];
+  for (u64 request = 0; request < REQUESTS; ++request)
+  {
+    HashMap map;
+    expectToBeTrue(createHashMapWithAllocator(&map, 64, NULL, &memory, NULL));
+    for (u64 i = 0; i < 5000; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + request + 1)));
+    for (u64 i = 0; i < 5000; ++i) expectShouldBe(i + request + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+
+    // - - - everything came from the arena, aligned for the entries
+    expectToBeTrue(((u8*)map.control >= (u8*)arena.memory && (u8*)map.control < (u8*)arena.memory + arena.allocated));
+    expectShouldBe(0, (u64)map.control % 16);
+
+    linearAllocReset(&arena);
+    expectShouldBe(0, arena.allocated);
+  }
+
+  destroyLinearAllocator(&arena);
+  return true;
+}
+
+u8 testPoolOrderedSet()
+{
+  ObjectPool      pool;
+  createObjectPool(1000, sizeof(AVLNode), NULL, &pool);
+  ForgeAllocator  memory;
+  createPoolAllocator(&memory, &pool);
+
+  OrderedSet set;
+  createOrderedSetWithAllocator(&set, sizeof(u64), NULL, &memory);
+
+  // - - - the set stores the caller's key pointers
+  static u64 keys[1000];
+  for (u64 i = 0; i < 1000; ++i)
+  {
+    keys[i] = i * 7919 % 1000;
+    orderedSetInsert(&set, (byteArray)&keys[i]);
+  }
+  expectToBeTrue((takeObject(&pool) == NULL));
+
+  // - - - removed nodes go back to the pool and are handed out again
+  for (u64 i = 0; i < 500; ++i) orderedSetRemove(&set, (byteArray)&keys[i]);
+  for (u64 i = 0; i < 500; ++i) orderedSetInsert(&set, (byteArray)&keys[i]);
+  for (u64 i = 0; i < 1000; ++i) expectToBeTrue(orderedSetContains(&set, (byteArray)&keys[i]));
+
+  // - - - nothing bigger than one object fits
+  expectToBeTrue((memory.allocate(memory.context, sizeof(AVLNode) + 1) == NULL));
+
+  destroyOrderedSet(&set);
+  destroyObjectPool(&pool);
+  return true;
+}
+
+static u64 allocations   = 0;
+static u64 deallocations = 0;
+
+static void* countingMalloc(unsigned long SIZE)
+{
+  allocations++;
+  return malloc(SIZE);
+}
+
+static void countingFree(void* MEMORY)
+{
+  deallocations++;
+  free(MEMORY);
+}
+
+u8 testPlainFunctions()
+{
+  // - - - the old signatures still route through the functions they are given
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 16, NULL, countingMalloc, countingFree, NULL));
+  char key[64];
+  for (u64 i = 0; i < 100; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  destroyHashMap(&map);
+  expectToBeTrue((allocations > 100));
+  expectShouldBe(allocations, deallocations);
+
+  // - - - the allocator does not point back into the struct, a copy keeps working once the original is gone
+  HashMap original;
+  expectToBeTrue(createHashMap(&original, 16, NULL, countingMalloc, countingFree, NULL));
+  HashMap moved = original;
+  memset(&original, 0xAB, sizeof(original));
+  for (u64 i = 0; i < 1000; ++i) expectToBeTrue(hashMapInsert(&moved, key, keyOf(i, key), (void*)(i + 1)));
+  expectShouldBe(500, (u64)hashMapGet(&moved, key, keyOf(499, key)));
+  destroyHashMap(&moved);
+  expectShouldBe(allocations, deallocations);
+
+  OrderedSet set;
+  createOrderedSet(&set, sizeof(u64), NULL, countingMalloc, countingFree);
+  OrderedSet movedSet = set;
+  memset(&set, 0xAB, sizeof(set));
+  static u64 setKeys[100];
+  for (u64 i = 0; i < 100; ++i)
+  {
+    setKeys[i] = i;
+    orderedSetInsert(&movedSet, (byteArray)&setKeys[i]);
+  }
+  expectToBeTrue(orderedSetContains(&movedSet, (byteArray)&setKeys[42]));
+  destroyOrderedSet(&movedSet);
+  expectShouldBe(allocations, deallocations);
+
+  // - - - the heap allocator reallocates in place or moves the contents
+  ForgeAllocator heap;
+  createHeapAllocator(&heap);
+  char* bytes = heap.allocate(heap.context, 8);
+  memcpy(bytes, "forge!!", 8);
+  bytes = heap.reallocate(heap.context, bytes, 8, 4096);
+  expectToBeTrue((memcmp(bytes, "forge!!", 8) == 0));
+  heap.deallocate(heap.context, bytes, 4096);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testArenaHashMap,    "HashMap built in an arena is thrown away by resetting the arena");
+  registerTest(testPoolOrderedSet,  "OrderedSet takes its nodes from an ObjectPool and gives them back");
+  registerTest(testPlainFunctions,  "Plain malloc and free functions and the heap allocator still work");
+  runTests();
+}
@@ -0,0 +1,127 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/concurrentHashMap.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+
+#define KEY_COUNT   20000
+#define READERS     4
+#define WRITERS     4
+
+static unsigned long long keyOf(u64 INDEX, char* KEY)
+{
+  return (unsigned long long)snprintf(KEY, 32, "key-%llu", INDEX);
+}
+
+u8 testInsertGetRemove()
+{
+  ConcurrentHashMap map;
+  expectToBeTrue(createConcurrentHashMap(&map, 4, NULL, NULL, NULL, NULL));
+
+  int a = 1, b = 2;
+  expectToBeTrue(concurrentHashMapInsert(&map, "alpha", 5, &a));
+  expectToBeTrue(concurrentHashMapInsert(&map, "beta",  4, &b));
+  expectToBeTrue((concurrentHashMapGet(&map, "alpha", 5) == &a));
+  expectToBeTrue((concurrentHashMapGet(&map, "beta",  4) == &b));
+  expectToBeTrue((concurrentHashMapGet(&map, "alp",   3) == NULL));
+
+  expectToBeTrue(concurrentHashMapInsert(&map, "alpha", 5, &b));
+  expectToBeTrue((concurrentHashMapGet(&map, "alpha", 5) == &b));
+  expectToBeFalse(concurrentHashMapInsert(&map, "alpha", 5, NULL));
+  expectShouldBe(2, concurrentHashMapCount(&map));
+
+  expectToBeTrue((concurrentHashMapRemove(&map, "alpha", 5) == &b));
+  expectToBeTrue((concurrentHashMapGet(&map, "alpha", 5) == NULL));
+  expectToBeTrue((concurrentHashMapRemove(&map, "alpha", 5) == NULL));
+  expectShouldBe(1, concurrentHashMapCount(&map));
+
+  // - - - far past the size it was created with
+  char key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(concurrentHashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectShouldBe(i + 1, (u64)concurrentHashMapGet(&map, key, keyOf(i, key)));
+  expectShouldBe(KEY_COUNT + 1, concurrentHashMapCount(&map));
+
+  destroyConcurrentHashMap(&map);
+  return true;
+}
+
+typedef struct Shared
+{
+  ConcurrentHashMap   map;
+  volatile bool       done;
+  volatile u64        wrong;
+  u64                 index;
+} Shared;
+
+// - - - the stable keys are never removed, only replaced with i + 1 or i + 1 + KEY_COUNT
+static void* reader(void* SHARED)
+{
+  Shared* shared = (Shared*)SHARED;
+  char    key[32];
+  u64     seed = (u64)pthread_self();
+  while (!__atomic_load_n(&shared->done, __ATOMIC_ACQUIRE))
+  {
+    seed  = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    u64 i = (seed >> 33) % KEY_COUNT;
+    u64 v = (u64)concurrentHashMapGet(&shared->map, key, keyOf(i, key));
+    if (v != i + 1 && v != i + 1 + KEY_COUNT) __atomic_add_fetch(&shared->wrong, 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+// - - - each writer churns its own range of extra keys, forcing growth, and rewrites the stable ones
+static void* writer(void* SHARED)
+{
+  Shared* shared = (Shared*)SHARED;
+  u64     base   = (__atomic_fetch_add(&shared->index, 1, __ATOMIC_RELAXED) + 1) * KEY_COUNT * 2;
+  char    key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    concurrentHashMapInsert(&shared->map, key, keyOf(base + i, key), (void*)(base + i + 1));
+    if (i % 2) concurrentHashMapRemove(&shared->map, key, keyOf(base + i - 1, key));
+    u64 stable = (base + i) % KEY_COUNT;
+    concurrentHashMapInsert(&shared->map, key, keyOf(stable, key), (void*)(stable + 1 + (i % 2) * KEY_COUNT));
+  }
+  return NULL;
+}
+
+u8 testConcurrentReadersAndWriters()
+{
+  static Shared shared;
+  shared.done  = false;
+  shared.wrong = 0;
+  shared.index = 0;
+  expectToBeTrue(createConcurrentHashMap(&shared.map, 16, NULL, NULL, NULL, NULL));
+
+  char key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i) concurrentHashMapInsert(&shared.map, key, keyOf(i, key), (void*)(i + 1));
+
+  pthread_t readers[READERS], writers[WRITERS];
+  for (int i = 0; i < READERS; ++i) pthread_create(&readers[i], NULL, reader, &shared);
+  for (int i = 0; i < WRITERS; ++i) pthread_create(&writers[i], NULL, writer, &shared);
+  for (int i = 0; i < WRITERS; ++i) pthread_join(writers[i], NULL);
+  __atomic_store_n(&shared.done, true, __ATOMIC_RELEASE);
+  for (int i = 0; i < READERS; ++i) pthread_join(readers[i], NULL);
+
+  expectShouldBe(0, shared.wrong);
+  expectShouldBe(KEY_COUNT + WRITERS * KEY_COUNT / 2, concurrentHashMapCount(&shared.map));
+
+  // - - - every writer kept the odd keys of its range
+  for (u64 w = 1; w <= WRITERS; ++w)
+  {
+    u64 base = w * KEY_COUNT * 2;
+    for (u64 i = 0; i < KEY_COUNT; ++i)
+    {
+      expectShouldBe(i % 2 ? base + i + 1 : 0, (u64)concurrentHashMapGet(&shared.map, key, keyOf(base + i, key)));
+    }
+  }
+
+  destroyConcurrentHashMap(&shared.map);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testInsertGetRemove,             "ConcurrentHashMap inserts, replaces, finds, removes and grows");
+  registerTest(testConcurrentReadersAndWriters, "ConcurrentHashMap readers see every stable key while writers churn and grow it");
+  runTests();
+}
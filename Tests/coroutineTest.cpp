@@ -0,0 +1,140 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/coroutine.hpp"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <stdexcept>
+
+#define FAN_OUT 256
+
+static forge::Task<pthread_t> hop(ThreadPool* POOL)
+{
+  co_await forge::schedule(POOL);
+  co_return pthread_self();
+}
+
+static forge::Task<u64> square(u64 VALUE)
+{
+  co_await forge::schedule();
+  co_return VALUE * VALUE;
+}
+
+static forge::Task<u64> sumOfSquares(u64 COUNT)
+{
+  u64 sum = 0;
+  for (u64 i = 1; i <= COUNT; ++i) sum += co_await square(i);
+  co_return sum;
+}
+
+static forge::Task<> touch(volatile u64* COUNTER)
+{
+  co_await forge::schedule();
+  __atomic_add_fetch(COUNTER, 1, __ATOMIC_RELAXED);
+}
+
+static forge::Task<u64> fail(u64 VALUE)
+{
+  co_await forge::schedule();
+  if (VALUE == 7) throw std::runtime_error("seven");
+  co_return VALUE;
+}
+
+static forge::Task<u64> fanOutIn()
+{
+  std::vector<forge::Task<u64>> tasks;
+  for (u64 i = 0; i < FAN_OUT; ++i) tasks.push_back(square(i));
+
+  u64 sum = 0;
+  for (u64 value : co_await forge::whenAll(std::move(tasks))) sum += value;
+  co_return sum;
+}
+
+u8 testSchedule()
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { 2, 0, "coro" };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  // - - - the coroutine continues on a thread of the pool, not on the caller
+  pthread_t worker = forge::syncWait(hop(&pool));
+  bool onPool = false;
+  for (u32 i = 0; i < pool.numThreadsAlive; ++i) onPool = onPool || pthread_equal(worker, pool.threads[i]->pthread);
+  expectToBeTrue(onPool);
+  expectToBeFalse((pthread_equal(worker, pthread_self()) != 0));
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+u8 testChainedTasks()
+{
+  expectToBeTrue(threadPoolInit(0));
+  expectShouldBe(338350, forge::syncWait(sumOfSquares(100)));
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testWhenAll()
+{
+  expectToBeTrue(threadPoolInit(0));
+
+  // - - - mixed types, void gives an empty slot
+  volatile u64 counter = 0;
+  auto [a, b, c] = forge::syncWait(forge::whenAll(square(3), touch(&counter), sumOfSquares(3)));
+  expectShouldBe(9,  a);
+  expectShouldBe(14, c);
+  expectShouldBe(1,  counter);
+  (void)b;
+
+  u64 expected = 0;
+  for (u64 i = 0; i < FAN_OUT; ++i) expected += i * i;
+  expectShouldBe(expected, forge::syncWait(fanOutIn()));
+
+  // - - - nothing to wait for
+  expectShouldBe(0, forge::syncWait(forge::whenAll(std::vector<forge::Task<u64>>())).size());
+
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testExceptions()
+{
+  expectToBeTrue(threadPoolInit(0));
+
+  bool caught = false;
+  try
+  {
+    forge::syncWait(fail(7));
+  }
+  catch (const std::runtime_error&)
+  {
+    caught = true;
+  }
+  expectToBeTrue(caught);
+
+  // - - - one failure fails the whole whenAll, after every task finished
+  std::vector<forge::Task<u64>> tasks;
+  for (u64 i = 0; i < 16; ++i) tasks.push_back(fail(i));
+
+  caught = false;
+  try
+  {
+    forge::syncWait(forge::whenAll(std::move(tasks)));
+  }
+  catch (const std::runtime_error&)
+  {
+    caught = true;
+  }
+  expectToBeTrue(caught);
+
+  threadPoolDestroy();
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testSchedule,     "schedule() resumes the coroutine on a pool thread");
+  registerTest(testChainedTasks, "Tasks await each other and return their results");
+  registerTest(testWhenAll,      "whenAll waits for every task and keeps their order");
+  registerTest(testExceptions,   "Exceptions reach the awaiting coroutine and syncWait");
+  runTests();
+}
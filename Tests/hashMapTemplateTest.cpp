@@ -0,0 +1,182 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/hashMap.hpp"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+#define KEY_COUNT 100000
+
+// - - - counts live instances, so leaked or doubly destroyed values show up
+struct Counted
+{
+  static inline i64 live = 0;
+
+  explicit Counted(u64 VALUE) : value(VALUE) { live++; }
+  Counted(Counted&& OTHER) noexcept : value(OTHER.value) { live++; }
+  Counted& operator=(Counted&& OTHER) noexcept { value = OTHER.value; return *this; }
+  ~Counted() { live--; }
+
+  u64 value;
+};
+
+u8 testInsertFindRemove()
+{
+  forge::HashMap<u64, u64> map;
+  expectShouldBe(0, map.capacity());
+  expectToBeTrue((map.find(1) == nullptr));
+
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(map.insert(i, i * 3));
+  expectShouldBe(KEY_COUNT, map.count());
+  expectToBeTrue((map.count() * 8 <= map.capacity() * 7));
+
+  // - - - replacing keeps the count
+  expectToBeFalse(map.insert(8, 80));
+  expectShouldBe(80, *map.find(8));
+  expectShouldBe(KEY_COUNT, map.count());
+
+  // - - - every other key removed, the rest must still be found past the tombstones
+  for (u64 i = 0; i < KEY_COUNT; i += 2) expectToBeTrue(map.remove(i));
+  expectToBeFalse(map.remove(0));
+  for (u64 i = 1; i < KEY_COUNT; i += 2) expectShouldBe(i * 3, *map.find(i));
+  for (u64 i = 0; i < KEY_COUNT; i += 2) expectToBeFalse(map.contains(i));
+  expectShouldBe(KEY_COUNT / 2, map.count());
+
+  // - - - refilling reuses the tombstones instead of growing forever
+  u64 capacity = map.capacity();
+  for (u64 round = 0; round < 4; ++round)
+  {
+    for (u64 i = 0; i < KEY_COUNT; i += 2) expectToBeTrue(map.insert(i, i));
+    for (u64 i = 0; i < KEY_COUNT; i += 2) expectToBeTrue(map.remove(i));
+  }
+  expectShouldBe(capacity, map.capacity());
+
+  map[5] += 1;
+  expectShouldBe(16, *map.find(5));
+  map[KEY_COUNT] += 1;
+  expectShouldBe(1, *map.find(KEY_COUNT));
+  return true;
+}
+
+u8 testHeterogeneousLookup()
+{
+  forge::HashMap<std::string, u64> map(4);
+
+  // - - - a key longer than any small string buffer, so a std::string built for the lookup would allocate
+  std::string long_key(64, 'k');
+  expectToBeTrue(map.insert(std::string("alpha"), 1));
+  expectToBeTrue(map.insert(long_key, 2));
+  expectToBeTrue(map.emplace(std::string_view("beta"), 3).second);
+  expectToBeFalse(map.emplace("beta", 4).second);
+
+  expectShouldBe(1, *map.find(std::string_view("alpha")));
+  expectShouldBe(1, *map.find("alpha"));
+  expectShouldBe(2, *map.find(std::string_view(long_key)));
+  expectShouldBe(3, *map.find(std::string("beta")));
+  expectToBeTrue((map.find(std::string_view("gamma")) == nullptr));
+
+  // - - - a prefix of a stored key is another key
+  expectToBeFalse(map.contains(std::string_view(long_key).substr(0, 63)));
+
+  map[std::string_view("gamma")] = 5;
+  expectShouldBe(5, *map.find("gamma"));
+  expectToBeTrue(map.remove(std::string_view("alpha")));
+  expectToBeFalse(map.contains("alpha"));
+  expectShouldBe(3, map.count());
+
+  // - - - iteration sees every entry once
+  u64 sum = 0, seen = 0;
+  for (auto [key, value] : map)
+  {
+    expectShouldBe(value, *map.find(key));
+    sum += value;
+    seen++;
+  }
+  expectShouldBe(3, seen);
+  expectShouldBe(10, sum);
+
+  // - - - every map seeds its string hash on its own, the same keys end up in another order
+  forge::HashMap<std::string, u64> first, second;
+  for (u64 i = 0; i < 64; ++i)
+  {
+    first.insert(std::to_string(i),  i);
+    second.insert(std::to_string(i), i);
+  }
+  bool sameOrder = true;
+  auto other     = second.begin();
+  for (auto [key, value] : first)
+  {
+    if (key != (*other).first) sameOrder = false;
+    ++other;
+  }
+  expectToBeFalse(sameOrder);
+  return true;
+}
+
+u8 testValuesInPlace()
+{
+  {
+    forge::HashMap<u64, Counted> map;
+    for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(map.emplace(i, i).second);
+    expectShouldBe(KEY_COUNT, Counted::live);
+
+    for (u64 i = 0; i < KEY_COUNT; i += 2) map.remove(i);
+    expectShouldBe(KEY_COUNT / 2, Counted::live);
+
+    // - - - the whole table moves with the map, nothing is copied
+    forge::HashMap<u64, Counted> moved(std::move(map));
+    expectShouldBe(KEY_COUNT / 2, Counted::live);
+    expectShouldBe(0, map.count());
+    expectShouldBe(3, moved.find(3)->value);
+
+    // - - - a moved from map is empty but usable
+    expectToBeTrue(map.emplace(1, 1).second);
+    expectShouldBe(KEY_COUNT / 2 + 1, Counted::live);
+
+    moved.clear();
+    expectShouldBe(1, Counted::live);
+    expectToBeTrue(moved.isEmpty());
+    expectToBeTrue((moved.find(3) == nullptr));
+  }
+  expectShouldBe(0, Counted::live);
+
+  // - - - move only values
+  forge::HashMap<u32, std::unique_ptr<u64>> owners;
+  owners.insert(1u, std::make_unique<u64>(10));
+  owners.insert(1u, std::make_unique<u64>(11));
+  expectShouldBe(11, **owners.find(1u));
+  return true;
+}
+
+u8 testArenaAllocator()
+{
+  LinearAllocator arena;
+  createLinearAllocator(1 << 20, 0, NULL, &arena);
+
+  ForgeAllocator allocator;
+  createArenaAllocator(&allocator, &arena);
+
+  {
+    forge::HashMap<u64, u64> map(0, &allocator);
+    map.reserve(1000);
+    u64 capacity = map.capacity();
+    u64 used     = arena.allocated;
+    for (u64 i = 0; i < 1000; ++i) map.insert(i, i + 1);
+    expectShouldBe(capacity, map.capacity());
+    expectShouldBe(used, arena.allocated);
+    expectShouldBe(500, *map.find(499));
+  }
+
+  destroyLinearAllocator(&arena);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testInsertFindRemove,    "forge::HashMap inserts, finds, replaces and removes integer keys");
+  registerTest(testHeterogeneousLookup, "std::string keys are found with string_view and char*");
+  registerTest(testValuesInPlace,       "Values live in the table and are destroyed exactly once");
+  registerTest(testArenaAllocator,      "forge::HashMap takes its table from a ForgeAllocator");
+  runTests();
+}
@@ -0,0 +1,401 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/hashMap.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+
+#define KEY_COUNT 100000
+
+static unsigned long long fnv(const byteArray KEY, unsigned long long SIZE)
+{
+  unsigned long long hash = 1469598103934665603ULL;
+  for (unsigned long long i = 0; i < SIZE; ++i) hash = (hash ^ (unsigned char)KEY[i]) * 1099511628211ULL;
+  return hash;
+}
+
+// - - - every key lands on the same group with the same tag, the probe has to walk and compare everything
+static unsigned long long collide(const byteArray KEY, unsigned long long SIZE)
+{
+  return 42;
+}
+
+static unsigned long long keyOf(u64 INDEX, char* KEY)
+{
+  return (unsigned long long)snprintf(KEY, 32, "key-%llu", INDEX);
+}
+
+u8 testInsertGetRemove()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 4, NULL, NULL, NULL, NULL));
+
+  int a = 1, b = 2;
+  expectToBeTrue(hashMapInsert(&map, "alpha", 5, &a));
+  expectToBeTrue(hashMapInsert(&map, "beta",  4, &b));
+  expectToBeTrue((hashMapGet(&map, "alpha", 5) == &a));
+  expectToBeTrue((hashMapGet(&map, "beta",  4) == &b));
+  expectToBeTrue((hashMapGet(&map, "gamma", 5) == NULL));
+
+  // - - - same key replaces the value, NULL values are refused
+  expectToBeTrue(hashMapInsert(&map, "alpha", 5, &b));
+  expectToBeTrue((hashMapGet(&map, "alpha", 5) == &b));
+  expectToBeFalse(hashMapInsert(&map, "alpha", 5, NULL));
+  expectShouldBe(2, map.count);
+
+  expectToBeTrue((hashMapRemove(&map, "alpha", 5) == &b));
+  expectToBeTrue((hashMapGet(&map, "alpha", 5) == NULL));
+  expectToBeTrue((hashMapRemove(&map, "alpha", 5) == NULL));
+  expectShouldBe(1, map.count);
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testGrowth()
+{
+  // - - - sized for far fewer entries than it gets
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 16, fnv, NULL, NULL, NULL));
+
+  char key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  expectShouldBe(KEY_COUNT, map.count);
+  expectToBeTrue((map.count * 8 <= map.size * 7));
+
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+  for (u64 i = KEY_COUNT; i < KEY_COUNT + 1000; ++i) expectToBeTrue((hashMapGet(&map, key, keyOf(i, key)) == NULL));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testIncrementalGrowth()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 1000, fnv, NULL, NULL, NULL));
+  unsigned long long size = map.size;
+
+  // - - - fill up to the load limit, the next insert starts moving entries to a table twice the size
+  char key[32];
+  u64  inserted = 0;
+  while (map.oldControl == NULL)
+  {
+    expectToBeTrue(hashMapInsert(&map, key, keyOf(inserted, key), (void*)(inserted + 1)));
+    inserted++;
+  }
+  expectShouldBe(size * 2, map.size);
+  expectToBeTrue((map.oldCount > inserted / 2));
+
+  // - - - everything is found and updated in whichever table it is in, removals count for both
+  for (u64 i = 0; i < inserted; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+  expectToBeTrue(hashMapInsert(&map, key, keyOf(0, key), (void*)1000000));
+  expectShouldBe(1000000, (u64)hashMapGet(&map, key, keyOf(0, key)));
+  expectShouldBe(1000000, (u64)hashMapRemove(&map, key, keyOf(0, key)));
+  expectShouldBe(inserted - 1, map.count);
+
+  // - - - a few more operations drain the old table
+  u64 operations = 0;
+  while (map.oldControl != NULL)
+  {
+    expectToBeTrue(hashMapInsert(&map, key, keyOf(inserted, key), (void*)(inserted + 1)));
+    inserted++;
+    operations++;
+  }
+  expectToBeTrue((operations <= size / HASH_MAP_GROUP_WIDTH));
+  expectToBeTrue((hashMapGet(&map, key, keyOf(0, key)) == NULL));
+  for (u64 i = 1; i < inserted; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testMaxLoad()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 16, fnv, NULL, NULL, NULL));
+  hashMapSetMaxLoad(&map, 0.5f);
+
+  char key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+    expectToBeTrue((map.count + map.tombstones <= map.size / 2));
+  }
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testRemoveChurn()
+{
+  // - - - a steady stream of inserts and removes must not fill the table with deleted slots
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 1024, fnv, NULL, NULL, NULL));
+
+  char key[32];
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+    if (i >= 512) expectShouldBe(i - 511, (u64)hashMapRemove(&map, key, keyOf(i - 512, key)));
+  }
+  expectShouldBe(512, map.count);
+  expectToBeTrue((map.size <= 2048));
+
+  for (u64 i = KEY_COUNT - 512; i < KEY_COUNT; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+  expectToBeTrue((hashMapGet(&map, key, keyOf(0, key)) == NULL));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testCollisions()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 16, collide, NULL, NULL, NULL));
+
+  char key[32];
+  for (u64 i = 0; i < 500; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  for (u64 i = 0; i < 500; i += 2) expectShouldBe(i + 1, (u64)hashMapRemove(&map, key, keyOf(i, key)));
+  for (u64 i = 0; i < 500; ++i) expectShouldBe(i % 2 ? i + 1 : 0, (u64)hashMapGet(&map, key, keyOf(i, key)));
+
+  // - - - binary keys, one a prefix of the other
+  char binary[4] = { 0, 1, 0, 2 };
+  int  whole = 1, prefix = 2;
+  expectToBeTrue(hashMapInsert(&map, binary, 4, &whole));
+  expectToBeTrue(hashMapInsert(&map, binary, 2, &prefix));
+  expectToBeTrue((hashMapGet(&map, binary, 4) == &whole));
+  expectToBeTrue((hashMapGet(&map, binary, 2) == &prefix));
+  expectToBeTrue((hashMapGet(&map, binary, 3) == NULL));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+static u64 allocations = 0;
+
+static void* countingMalloc(unsigned long SIZE)
+{
+  allocations++;
+  return malloc(SIZE);
+}
+
+u8 testKeyStorage()
+{
+  // - - - short keys live in the entry, so only the table itself is allocated
+  HashMap map;
+  allocations = 0;
+  expectToBeTrue(createHashMap(&map, 1000, NULL, countingMalloc, NULL, NULL));
+  expectShouldBe(1, allocations);
+
+  char key[32];
+  for (u64 i = 0; i < 1000; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  expectShouldBe(1, allocations);
+
+  // - - - every length around the inline limit, prefixes of one buffer so neighbours differ by one byte
+  char bytes[HASH_MAP_INLINE_KEY * 2];
+  for (u64 i = 0; i < sizeof(bytes); ++i) bytes[i] = (char)('A' + i);
+  for (u64 length = 1; length <= sizeof(bytes); ++length) expectToBeTrue(hashMapInsert(&map, bytes, length, (void*)length));
+  expectShouldBe(1 + HASH_MAP_INLINE_KEY, allocations);
+
+  for (u64 length = 1; length <= sizeof(bytes); ++length) expectShouldBe(length, (u64)hashMapGet(&map, bytes, length));
+  for (u64 length = 1; length <= sizeof(bytes); length += 2) expectShouldBe(length, (u64)hashMapRemove(&map, bytes, length));
+  for (u64 length = 1; length <= sizeof(bytes); ++length) expectShouldBe(length % 2 ? 0 : length, (u64)hashMapGet(&map, bytes, length));
+
+  // - - - growing moves entries with their stored hash, short and long keys are still found after it
+  for (u64 i = 1000; i < 20000; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  for (u64 i = 0; i < 20000; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&map, key, keyOf(i, key)));
+  for (u64 length = 2; length <= sizeof(bytes); length += 2) expectShouldBe(length, (u64)hashMapGet(&map, bytes, length));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testBatches()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 16, NULL, NULL, NULL, NULL));
+
+  // - - - long and short keys, batches that are not a multiple of the round width, growth in the middle
+  static char               storage[KEY_COUNT][48];
+  static byteArray          keys[KEY_COUNT];
+  static unsigned long long sizes[KEY_COUNT];
+  static void*              values[KEY_COUNT];
+  for (u64 i = 0; i < KEY_COUNT; ++i)
+  {
+    keys[i]   = storage[i];
+    sizes[i]  = (unsigned long long)snprintf(storage[i], 48, i % 3 ? "key-%llu" : "a-key-too-long-to-be-inline-%llu", i);
+    values[i] = (void*)(i + 1);
+  }
+  for (u64 base = 0; base < KEY_COUNT; base += 1001)
+  {
+    u64 count = KEY_COUNT - base < 1001 ? KEY_COUNT - base : 1001;
+    expectShouldBe(count, hashMapInsertBatch(&map, keys + base, sizes + base, values + base, count));
+  }
+  expectShouldBe(KEY_COUNT, map.count);
+
+  // - - - the batch agrees with single lookups, misses come back NULL
+  static void* found[KEY_COUNT];
+  expectShouldBe(KEY_COUNT, hashMapGetBatch(&map, keys, sizes, KEY_COUNT, found));
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue((found[i] == values[i] && hashMapGet(&map, keys[i], sizes[i]) == values[i]));
+
+  for (u64 i = 0; i < KEY_COUNT; i += 2) hashMapRemove(&map, keys[i], sizes[i]);
+  expectShouldBe(KEY_COUNT / 2, hashMapGetBatch(&map, keys, sizes, KEY_COUNT, found));
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue((found[i] == (i % 2 ? values[i] : NULL)));
+
+  // - - - replacing through a batch, NULL values are skipped
+  values[1] = NULL;
+  expectShouldBe(2, hashMapInsertBatch(&map, keys, sizes, values, 3));
+  expectToBeTrue((hashMapGet(&map, keys[1], sizes[1]) == (void*)2));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testIteration()
+{
+  HashMap map;
+  expectToBeTrue(createHashMap(&map, 1000, fnv, NULL, NULL, NULL));
+  HashMapIterator iterator;
+  createHashMapIter(&map, &iterator);
+  expectToBeFalse(hashMapIterNext(&map, &iterator, NULL, NULL, NULL));
+
+  // - - - stop right after a resize starts, so entries sit in both tables
+  char key[48];
+  u64  inserted = 0;
+  while (map.oldControl == NULL)
+  {
+    expectToBeTrue(hashMapInsert(&map, key, keyOf(inserted, key), (void*)(inserted + 1)));
+    inserted++;
+  }
+  expectToBeTrue((map.oldControl != NULL));
+  expectToBeTrue(hashMapInsert(&map, "a-key-too-long-to-be-inline", 27, (void*)-1));
+
+  // - - - every entry exactly once, with its own key
+  static u8           seen[KEY_COUNT];
+  const char*         entryKey;
+  unsigned long long  entrySize;
+  void*               value;
+  u64                 visited = 0;
+  memset(seen, 0, sizeof(seen));
+  createHashMapIter(&map, &iterator);
+  while (hashMapIterNext(&map, &iterator, &entryKey, &entrySize, &value))
+  {
+    visited++;
+    if (value == (void*)-1)
+    {
+      expectShouldBe(27, entrySize);
+      expectToBeTrue((memcmp(entryKey, "a-key-too-long-to-be-inline", 27) == 0));
+      continue;
+    }
+    u64 index = (u64)value - 1;
+    expectShouldBe(0, seen[index]);
+    seen[index] = 1;
+    expectShouldBe(keyOf(index, key), entrySize);
+    expectToBeTrue((memcmp(entryKey, key, entrySize) == 0));
+  }
+  expectShouldBe(inserted + 1, visited);
+  expectShouldBe(map.count, visited);
+  expectToBeFalse(hashMapIterNext(&map, &iterator, NULL, NULL, NULL));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testReserveAndClear()
+{
+  HashMap map;
+  allocations = 0;
+  expectToBeTrue(createHashMap(&map, 16, NULL, countingMalloc, NULL, NULL));
+
+  // - - - one allocation up front, then no resize while filling
+  expectToBeTrue(hashMapReserve(&map, KEY_COUNT));
+  expectShouldBe(2, allocations);
+  expectToBeTrue((map.oldControl == NULL && KEY_COUNT <= map.maxLoad * map.size));
+  unsigned long long size = map.size;
+
+  char key[48];
+  for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i, key), (void*)(i + 1)));
+  expectShouldBe(2, allocations);
+  expectToBeTrue(hashMapReserve(&map, KEY_COUNT / 2));
+  expectShouldBe(size, map.size);
+
+  // - - - a frame's worth of entries, cleared and refilled without allocating
+  for (u64 frame = 0; frame < 5; ++frame)
+  {
+    hashMapClear(&map);
+    expectShouldBe(0, map.count);
+    expectToBeTrue((hashMapGet(&map, key, keyOf(frame, key)) == NULL));
+    for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(hashMapInsert(&map, key, keyOf(i + frame, key), (void*)(i + 1)));
+    expectShouldBe(KEY_COUNT, map.count);
+  }
+  expectShouldBe(2, allocations);
+  expectShouldBe(size, map.size);
+
+  // - - - long keys are freed by the clear, a map in the middle of a resize drops its old table
+  expectToBeTrue(hashMapInsert(&map, "a-key-too-long-to-be-inline", 27, (void*)1));
+  while (map.oldControl == NULL) expectToBeTrue(hashMapInsert(&map, key, keyOf(map.count * 7 + KEY_COUNT, key), (void*)1));
+  hashMapClear(&map);
+  expectToBeTrue((map.oldControl == NULL && map.count == 0));
+  expectToBeTrue((hashMapGet(&map, "a-key-too-long-to-be-inline", 27) == NULL));
+
+  destroyHashMap(&map);
+  return true;
+}
+
+u8 testDefaultHash()
+{
+  // - - - every byte counts, zeros included, and nothing past KEY_SIZE is read
+  char a[8] = { 0, 0, 0, 1, 0, 0, 0, 0 };
+  char b[8] = { 0, 0, 0, 2, 0, 0, 0, 0 };
+  expectToBeTrue((hashMapHashBytes(a, 8, 0) != hashMapHashBytes(b, 8, 0)));
+  expectToBeTrue((hashMapHashBytes(a, 4, 0) != hashMapHashBytes(a, 5, 0)));
+  expectToBeTrue((hashMapHashBytes(a, 8, 0) == hashMapHashBytes(a, 8, 0)));
+  expectToBeTrue((hashMapHashBytes(a, 8, 0) != hashMapHashBytes(a, 8, 1)));
+
+  // - - - every length from empty to a few blocks of the long key loop, all prefixes of one buffer
+  char bytes[200];
+  for (int i = 0; i < 200; ++i) bytes[i] = (char)(i * 7);
+  unsigned long long seen[201];
+  for (int length = 0; length <= 200; ++length)
+  {
+    seen[length] = hashMapHashBytes(bytes, length, 5);
+    for (int j = 0; j < length; ++j) expectToBeTrue((seen[j] != seen[length]));
+  }
+
+  // - - - the map hashes with its own seed, two maps place the same keys differently
+  HashMap first, second;
+  expectToBeTrue(createHashMap(&first,  16, NULL, NULL, NULL, NULL));
+  expectToBeTrue(createHashMap(&second, 16, NULL, NULL, NULL, NULL));
+  expectToBeTrue((first.seed != second.seed));
+  hashMapSetSeed(&second, first.seed);
+  expectShouldBe(first.seed, second.seed);
+
+  // - - - binary keys that are not NUL terminated
+  u64 keys[1000];
+  for (u64 i = 0; i < 1000; ++i)
+  {
+    keys[i] = i << 32;
+    expectToBeTrue(hashMapInsert(&first, (char*)&keys[i], sizeof(u64), (void*)(i + 1)));
+  }
+  for (u64 i = 0; i < 1000; ++i) expectShouldBe(i + 1, (u64)hashMapGet(&first, (char*)&keys[i], sizeof(u64)));
+
+  destroyHashMap(&first);
+  destroyHashMap(&second);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testInsertGetRemove,    "HashMap inserts, replaces, finds and removes keys");
+  registerTest(testGrowth,             "HashMap grows past the size it was created with");
+  registerTest(testIncrementalGrowth,  "HashMap moves entries to a bigger table a few at a time");
+  registerTest(testMaxLoad,            "HashMap grows at the configured load");
+  registerTest(testRemoveChurn,        "HashMap reuses deleted slots instead of growing");
+  registerTest(testDefaultHash,        "Default hash reads exactly KEY_SIZE bytes and is seeded per map");
+  registerTest(testKeyStorage,         "HashMap keeps short keys in the entry and long ones allocated");
+  registerTest(testBatches,            "HashMap batches agree with single inserts and lookups");
+  registerTest(testIteration,          "HashMap iterates every entry once, in both tables while growing");
+  registerTest(testReserveAndClear,    "HashMap reserves ahead and clears without giving up its table");
+  registerTest(testCollisions,         "HashMap tells apart keys with equal hashes and prefixes");
+  runTests();
+}
@@ -0,0 +1,99 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/intMap.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+
+#define KEY_COUNT 100000
+
+u8 testInsertGetRemove()
+{
+  IntMap map;
+  expectToBeTrue(createIntMap(&map, 4, NULL));
+
+  int a = 1, b = 2;
+  expectToBeTrue(intMapInsert(&map, 42, &a));
+  expectToBeTrue(intMapInsert(&map, 7,  &b));
+  expectToBeTrue((intMapGet(&map, 42) == &a));
+  expectToBeTrue((intMapGet(&map, 7)  == &b));
+  expectToBeTrue((intMapGet(&map, 8)  == NULL));
+
+  expectToBeTrue(intMapInsert(&map, 42, &b));
+  expectToBeTrue((intMapGet(&map, 42) == &b));
+  expectToBeFalse(intMapInsert(&map, 42, NULL));
+  expectShouldBe(2, map.count);
+
+  // - - - the key used to mark empty slots is an ordinary key to the caller
+  expectToBeTrue((intMapGet(&map, INT_MAP_EMPTY_KEY) == NULL));
+  expectToBeTrue(intMapInsert(&map, INT_MAP_EMPTY_KEY, &a));
+  expectToBeTrue((intMapGet(&map, INT_MAP_EMPTY_KEY) == &a));
+  expectShouldBe(3, map.count);
+  expectToBeTrue((intMapRemove(&map, INT_MAP_EMPTY_KEY) == &a));
+  expectToBeTrue((intMapGet(&map, INT_MAP_EMPTY_KEY) == NULL));
+
+  expectToBeTrue((intMapRemove(&map, 42) == &b));
+  expectToBeTrue((intMapRemove(&map, 42) == NULL));
+  expectShouldBe(1, map.count);
+
+  destroyIntMap(&map);
+  return true;
+}
+
+u8 testGrowthAndRemoval()
+{
+  IntMap map;
+  expectToBeTrue(createIntMap(&map, 1, NULL));
+
+  // - - - sequential ids, and ids that only differ in their high bits
+  for (u64 i = 1; i <= KEY_COUNT; ++i)
+  {
+    expectToBeTrue(intMapInsert(&map, i, (void*)i));
+    expectToBeTrue(intMapInsert(&map, i << 40, (void*)(i + KEY_COUNT)));
+  }
+  expectShouldBe(2 * KEY_COUNT, map.count);
+  expectToBeTrue((map.count * 4 <= map.size * 3));
+
+  // - - - every other removal shifts entries back, the rest must still be found and misses still end
+  for (u64 i = 1; i <= KEY_COUNT; i += 2)
+  {
+    expectShouldBe(i, (u64)intMapRemove(&map, i));
+    expectShouldBe(i + KEY_COUNT, (u64)intMapRemove(&map, i << 40));
+  }
+  for (u64 i = 1; i <= KEY_COUNT; ++i)
+  {
+    expectShouldBe(i % 2 ? 0 : i,             (u64)intMapGet(&map, i));
+    expectShouldBe(i % 2 ? 0 : i + KEY_COUNT, (u64)intMapGet(&map, i << 40));
+  }
+  expectShouldBe(KEY_COUNT, map.count);
+
+  destroyIntMap(&map);
+  return true;
+}
+
+u8 testReserveAndClear()
+{
+  IntMap map;
+  expectToBeTrue(createIntMap(&map, 16, NULL));
+  expectToBeTrue(intMapReserve(&map, KEY_COUNT));
+  u64 size = map.size;
+
+  for (u64 round = 0; round < 3; ++round)
+  {
+    for (u64 i = 0; i < KEY_COUNT; ++i) expectToBeTrue(intMapInsert(&map, i * 0x10001 + round, (void*)(i + 1)));
+    expectShouldBe(KEY_COUNT, map.count);
+    expectShouldBe(size, map.size);
+    intMapClear(&map);
+    expectShouldBe(0, map.count);
+    expectToBeTrue((intMapGet(&map, round) == NULL));
+  }
+
+  destroyIntMap(&map);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testInsertGetRemove,   "IntMap inserts, replaces, finds and removes keys, 0 included");
+  registerTest(testGrowthAndRemoval,  "IntMap grows and shifts entries back on removal");
+  registerTest(testReserveAndClear,   "IntMap reserves ahead and clears without giving up its slots");
+  runTests();
+}
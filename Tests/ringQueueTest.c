@@ -0,0 +1,181 @@
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/ringQueue.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <unistd.h>
+
+#define PRODUCERS       4
+#define CONSUMERS       4
+#define ITEMS_EACH      50000
+
+// - - - not a multiple of 8, so the cell stride has to pad it
+typedef struct Item
+{
+  u32 producer;
+  u32 sequence;
+  u8  tag[5];
+} Item;
+
+u8 testSingleThread()
+{
+  RingQueue queue;
+  createRingQueue(&queue, 6, sizeof(Item));
+  expectShouldBe(8, queue.capacity);
+
+  // - - - several laps around the ring, full and empty each time
+  for (u32 lap = 0; lap < 5; ++lap)
+  {
+    Item item = { 0 };
+    for (u32 i = 0; i < 8; ++i)
+    {
+      item.sequence = lap * 8 + i;
+      expectToBeTrue(ringQueueTryPush(&queue, &item));
+    }
+    expectToBeFalse(ringQueueTryPush(&queue, &item));
+    expectShouldBe(8, ringQueueSize(&queue));
+
+    for (u32 i = 0; i < 8; ++i)
+    {
+      expectToBeTrue(ringQueueTryPop(&queue, &item));
+      expectShouldBe(lap * 8 + i, item.sequence);
+    }
+    expectToBeFalse(ringQueueTryPop(&queue, &item));
+    expectShouldBe(0, ringQueueSize(&queue));
+  }
+
+  destroyRingQueue(&queue);
+  return true;
+}
+
+u8 testBatches()
+{
+  RingQueue queue;
+  createRingQueue(&queue, 16, sizeof(u64));
+
+  u64 values[32];
+  for (u64 i = 0; i < 32; ++i) values[i] = i;
+
+  // - - - only what fits goes in
+  expectShouldBe(10, ringQueueTryPushBatch(&queue, values, 10));
+  expectShouldBe(6,  ringQueueTryPushBatch(&queue, values + 10, 22));
+  expectShouldBe(0,  ringQueueTryPushBatch(&queue, values + 16, 16));
+
+  u64 out[32] = { 0 };
+  expectShouldBe(4,  ringQueueTryPopBatch(&queue, out, 4));
+  expectShouldBe(12, ringQueueTryPopBatch(&queue, out + 4, 28));
+  expectShouldBe(0,  ringQueueTryPopBatch(&queue, out + 16, 16));
+  for (u64 i = 0; i < 16; ++i) expectShouldBe(i, out[i]);
+
+  // - - - across the end of the buffer
+  expectShouldBe(16, ringQueueTryPushBatch(&queue, values + 16, 16));
+  expectShouldBe(16, ringQueueTryPopBatch(&queue, out, 32));
+  for (u64 i = 0; i < 16; ++i) expectShouldBe(16 + i, out[i]);
+
+  destroyRingQueue(&queue);
+  return true;
+}
+
+static RingQueue    shared;
+static volatile u64 consumedSum = 0;
+static volatile u64 outOfOrder  = 0;
+
+static void* producer(void* ARG)
+{
+  Item item = { (u32)(u64)ARG, 0, { 0 } };
+  for (u32 i = 0; i < ITEMS_EACH; ++i)
+  {
+    item.sequence = i;
+    // - - - mix single and batched pushes
+    if (i % 3) ringQueuePush(&shared, &item);
+    else while (ringQueueTryPushBatch(&shared, &item, 1) == 0) sched_yield();
+  }
+  return NULL;
+}
+
+static void* consumer(void* ARG)
+{
+  // - - - every producer's items must come out in the order it pushed them
+  i64 last[PRODUCERS];
+  for (int i = 0; i < PRODUCERS; ++i) last[i] = -1;
+
+  u64 sum = 0;
+  for (u32 i = 0; i < PRODUCERS * ITEMS_EACH / CONSUMERS; ++i)
+  {
+    Item item;
+    ringQueuePop(&shared, &item);
+    if ((i64)item.sequence <= last[item.producer]) __atomic_add_fetch(&outOfOrder, 1, __ATOMIC_RELAXED);
+    last[item.producer] = item.sequence;
+    sum += item.sequence;
+  }
+  __atomic_add_fetch(&consumedSum, sum, __ATOMIC_RELAXED);
+  return NULL;
+}
+
+u8 testManyProducersAndConsumers()
+{
+  // - - - small enough that producers block on a full queue and consumers on an empty one
+  createRingQueue(&shared, 64, sizeof(Item));
+
+  pthread_t producers[PRODUCERS];
+  pthread_t consumers[CONSUMERS];
+  for (u64 i = 0; i < CONSUMERS; ++i) pthread_create(&consumers[i], NULL, consumer, NULL);
+  for (u64 i = 0; i < PRODUCERS; ++i) pthread_create(&producers[i], NULL, producer, (void*)i);
+  for (u64 i = 0; i < PRODUCERS; ++i) pthread_join(producers[i], NULL);
+  for (u64 i = 0; i < CONSUMERS; ++i) pthread_join(consumers[i], NULL);
+
+  expectShouldBe((u64)PRODUCERS * ITEMS_EACH * (ITEMS_EACH - 1) / 2, consumedSum);
+  expectShouldBe(0, outOfOrder);
+  expectShouldBe(0, ringQueueSize(&shared));
+
+  destroyRingQueue(&shared);
+  return true;
+}
+
+static void* popOne(void* ARG)
+{
+  u64 value;
+  ringQueuePop(&shared, &value);
+  __atomic_store_n((volatile u64*)ARG, value, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+u8 testBlockingWakes()
+{
+  createRingQueue(&shared, 2, sizeof(u64));
+
+  // - - - a pop on an empty queue sleeps until something arrives
+  volatile u64 received = 0;
+  pthread_t    thread;
+  pthread_create(&thread, NULL, popOne, (void*)&received);
+  usleep(20000);
+  expectShouldBe(0, __atomic_load_n(&received, __ATOMIC_ACQUIRE));
+
+  u64 value = 42;
+  ringQueuePush(&shared, &value);
+  pthread_join(thread, NULL);
+  expectShouldBe(42, received);
+
+  // - - - a push on a full queue sleeps until something leaves
+  ringQueuePush(&shared, &value);
+  ringQueuePush(&shared, &value);
+  expectToBeFalse(ringQueueTryPush(&shared, &value));
+  received = 0;
+  pthread_create(&thread, NULL, popOne, (void*)&received);
+  value = 7;
+  ringQueuePush(&shared, &value);
+  pthread_join(thread, NULL);
+  expectShouldBe(42, received);
+  expectShouldBe(2, ringQueueSize(&shared));
+
+  destroyRingQueue(&shared);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testSingleThread,              "Ring queue keeps order and knows when it is full or empty");
+  registerTest(testBatches,                   "Ring queue pushes and pops batches as far as they fit");
+  registerTest(testManyProducersAndConsumers, "Ring queue hands every element over exactly once under contention");
+  registerTest(testBlockingWakes,             "Blocking push and pop sleep until the other side makes progress");
+  runTests();
+}
@@ -0,0 +1,846 @@
+#define _GNU_SOURCE
+#include "../Libraries/Forge/include/testManager.h"
+#include "../Libraries/Forge/include/threadPool.h"
+#include "../Libraries/Forge/include/expect.h"
+#include "../Libraries/Forge/include/logger.h"
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <dirent.h>
+
+#define TASK_COUNT 10000
+#define FAN_OUT    64
+
+static volatile u64 counter = 0;
+
+static void increment(void* ARG)
+{
+  __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+}
+
+static void fanOutIn(void* ARG)
+{
+  for (int i = 0; i < FAN_OUT; ++i) threadPoolPush((ThreadPool*)ARG, increment, NULL);
+}
+
+static void fanOut(void* ARG)
+{
+  // - - - pushed from inside a task, lands on this thread's deque and gets stolen by the others
+  for (int i = 0; i < FAN_OUT; ++i) threadPoolTaskPush(increment, NULL);
+  increment(ARG);
+}
+
+typedef struct Job
+{
+  Task  task;   // - - - embedded, the pool never allocates for it
+  u64   value;
+} Job;
+
+static void runJob(void* ARG)
+{
+  Job* job = (Job*)ARG;
+  __atomic_add_fetch(&counter, job->value, __ATOMIC_RELAXED);
+}
+
+static Semaphore ready;
+static Semaphore done;
+
+static void* semaphoreEcho(void* ARG)
+{
+  for (int i = 0; i < TASK_COUNT; ++i)
+  {
+    semaphoreWait(&ready);
+    semaphorePost(&done);
+  }
+  return NULL;
+}
+
+u8 testSemaphore()
+{
+  // - - - counts well past 255 without wrapping
+  createSemaphore(&ready, 0);
+  semaphorePostMany(&ready, 1000);
+  for (int i = 0; i < 1000; ++i) semaphoreWait(&ready);
+  expectShouldBe(0, ready.count);
+
+  // - - - posts and waits across threads, the waiter parks most of the time
+  createSemaphore(&done, 0);
+  pthread_t thread;
+  pthread_create(&thread, NULL, semaphoreEcho, NULL);
+  for (int i = 0; i < TASK_COUNT; ++i)
+  {
+    semaphorePost(&ready);
+    semaphoreWait(&done);
+  }
+  pthread_join(thread, NULL);
+  expectShouldBe(0, ready.count);
+  expectShouldBe(0, done.count);
+
+  // - - - a timed out wait leaves the count as it found it
+  expectToBeFalse(semaphoreWaitFor(&ready, 1000000));
+  expectShouldBe(0, ready.count);
+  semaphorePost(&ready);
+  expectToBeTrue(semaphoreWaitFor(&ready, 1000000));
+  expectShouldBe(0, ready.count);
+
+  destroySemaphore(&ready);
+  destroySemaphore(&done);
+  return true;
+}
+
+u8 testAllTasksRun()
+{
+  expectToBeTrue(threadPoolInit(4));
+
+  counter = 0;
+  for (int i = 0; i < TASK_COUNT; ++i) threadPoolTaskPush(increment, NULL);
+  threadPoolWaitToFinish();
+  expectShouldBe(TASK_COUNT, counter);
+
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testNestedPush()
+{
+  expectToBeTrue(threadPoolInit(4));
+
+  counter = 0;
+  for (int i = 0; i < TASK_COUNT / FAN_OUT; ++i) threadPoolTaskPush(fanOut, NULL);
+  threadPoolWaitToFinish();
+  expectShouldBe((TASK_COUNT / FAN_OUT) * (FAN_OUT + 1), counter);
+
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testIntrusivePush()
+{
+  expectToBeTrue(threadPoolInit(4));
+
+  static Job jobs[TASK_COUNT];
+  counter = 0;
+  for (int round = 0; round < 3; ++round)
+  {
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+      jobs[i].value = 1;
+      threadPoolTaskPushIntrusive(&jobs[i].task, runJob, &jobs[i]);
+    }
+    threadPoolWaitToFinish();
+  }
+  expectShouldBe(3 * TASK_COUNT, counter);
+
+  threadPoolDestroy();
+  return true;
+}
+
+static volatile bool released = false;
+static volatile u64  computed = 0;
+
+static void blockUntilReleased(void* ARG)
+{
+  while (!__atomic_load_n(&released, __ATOMIC_ACQUIRE)) usleep(100);
+}
+
+static void compute(void* ARG)
+{
+  __atomic_add_fetch(&computed, 1, __ATOMIC_RELAXED);
+}
+
+static void pushToOtherPool(void* ARG)
+{
+  // - - - a task of one pool feeding another pool goes through that pool's shared queue
+  threadPoolPush((ThreadPool*)ARG, compute, NULL);
+}
+
+static void pushBatchInside(void* ARG)
+{
+  // - - - a batch from a pool thread goes to its own deque
+  void (*functions[FAN_OUT])(void*);
+  for (int i = 0; i < FAN_OUT; ++i) functions[i] = increment;
+  threadPoolTaskPushBatch(functions, NULL, FAN_OUT);
+}
+
+u8 testBatchPush()
+{
+  expectToBeTrue(threadPoolInit(4));
+
+  static void (*functions[TASK_COUNT])(void*);
+  static void*  arguments[TASK_COUNT];
+  for (int i = 0; i < TASK_COUNT; ++i)
+  {
+    functions[i] = (i % 2) ? increment : runJob;
+    arguments[i] = NULL;
+  }
+
+  // - - - mixed functions with their own arguments
+  Job job   = { .value = 3 };
+  counter   = 0;
+  for (int i = 0; i < TASK_COUNT; i += 2) arguments[i] = &job;
+  threadPoolTaskPushBatch(functions, arguments, TASK_COUNT);
+  threadPoolWaitToFinish();
+  expectShouldBe((TASK_COUNT / 2) * 4, counter);
+
+  counter = 0;
+  for (int i = 0; i < TASK_COUNT / FAN_OUT; ++i) functions[i] = pushBatchInside;
+  threadPoolTaskPushBatch(functions, NULL, TASK_COUNT / FAN_OUT);
+  threadPoolTaskPushBatch(functions, NULL, 0);
+  threadPoolWaitToFinish();
+  expectShouldBe((TASK_COUNT / FAN_OUT) * FAN_OUT, counter);
+
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testIsolatedPools()
+{
+  ThreadPool       io;
+  ThreadPool       cpu;
+  ThreadPoolConfig ioConfig   = { 2, 256 * 1024, "io" };
+  ThreadPoolConfig cpuConfig  = { 2, 0,          "cpu" };
+  expectToBeTrue(createThreadPool(&io,  &ioConfig));
+  expectToBeTrue(createThreadPool(&cpu, &cpuConfig));
+
+  // - - - every io thread is stuck, the cpu pool must not care
+  released = false;
+  computed = 0;
+  for (int i = 0; i < 8; ++i) threadPoolPush(&io, blockUntilReleased, NULL);
+  for (int i = 0; i < 1000; ++i) threadPoolPush(&cpu, compute, NULL);
+  threadPoolWait(&cpu);
+  expectShouldBe(1000, computed);
+
+  __atomic_store_n(&released, true, __ATOMIC_RELEASE);
+  for (int i = 0; i < 100; ++i) threadPoolPush(&io, pushToOtherPool, &cpu);
+  threadPoolWait(&io);
+  threadPoolWait(&cpu);
+  expectShouldBe(1100, computed);
+
+  destroyThreadPool(&io);
+  destroyThreadPool(&cpu);
+  return true;
+}
+
+static volatile u64 wrongCpu = 0;
+
+static void checkCpu(void* ARG)
+{
+  if (sched_getcpu() != (int)(u64)ARG) __atomic_add_fetch(&wrongCpu, 1, __ATOMIC_RELAXED);
+
+  // - - - node local scratch memory from inside a pinned thread
+  u8* scratch = (u8*)threadPoolAllocateLocal(64 * 1024);
+  memset(scratch, 1, 64 * 1024);
+  threadPoolFreeLocal(scratch, 64 * 1024);
+}
+
+// - - - polls for up to 5 s, the supervisor and the retiring threads take their time
+static bool waitForThreads(ThreadPool* POOL, u32 COUNT)
+{
+  for (int i = 0; i < 5000 && __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_ACQUIRE) != COUNT; ++i) usleep(1000);
+  return __atomic_load_n(&POOL->numThreadsAlive, __ATOMIC_ACQUIRE) == COUNT;
+}
+
+u8 testElasticPool()
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { 1, 0, "elastic", THREAD_POOL_PIN_NONE, NULL, 0, false, 4, 200000, 50000000 };
+  expectToBeTrue(createThreadPool(&pool, &config));
+  expectShouldBe(1, pool.numThreadsAlive);
+
+  // - - - every thread blocks, the queued ones make the pool grow up to its maximum and no further
+  released = false;
+  for (int i = 0; i < 8; ++i) threadPoolPush(&pool, blockUntilReleased, NULL);
+  expectToBeTrue(waitForThreads(&pool, 4));
+  usleep(5000);
+  expectShouldBe(4, pool.numThreadsAlive);
+
+  __atomic_store_n(&released, true, __ATOMIC_RELEASE);
+  threadPoolWait(&pool);
+
+  // - - - idle extras retire, the minimum stays
+  expectToBeTrue(waitForThreads(&pool, 1));
+  usleep(100000);
+  expectShouldBe(1, pool.numThreadsAlive);
+
+  counter = 0;
+  for (int i = 0; i < TASK_COUNT; ++i) threadPoolPush(&pool, increment, NULL);
+  threadPoolWait(&pool);
+  expectShouldBe(TASK_COUNT, counter);
+
+  // - - - grows into the retired slots again, and destroy copes with threads coming and going
+  released = false;
+  for (int i = 0; i < 8; ++i) threadPoolPush(&pool, blockUntilReleased, NULL);
+  expectToBeTrue(waitForThreads(&pool, 4));
+  expectToBeTrue((pool.threadSlots <= 4));
+  __atomic_store_n(&released, true, __ATOMIC_RELEASE);
+  destroyThreadPool(&pool);
+
+  // - - - the default pool the same way
+  expectToBeTrue(threadPoolInitElastic(1, 3));
+  counter = 0;
+  for (int i = 0; i < TASK_COUNT; ++i) threadPoolTaskPush(increment, NULL);
+  threadPoolWaitToFinish();
+  expectShouldBe(TASK_COUNT, counter);
+  threadPoolDestroy();
+  return true;
+}
+
+#define TIMER_COUNT 100000
+
+typedef struct Alarm
+{
+  Timer         timer;
+  u64           scheduledAt;
+  u64           delay;
+  volatile u64  firedAt;
+} Alarm;
+
+static volatile u64 early = 0;
+
+static u64 monotonicNanoseconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static void ring(void* ARG)
+{
+  Alarm* alarm = (Alarm*)ARG;
+  u64    now   = monotonicNanoseconds();
+  if (now - alarm->scheduledAt < alarm->delay) __atomic_add_fetch(&early, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&alarm->firedAt, now, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+}
+
+static void alarmSchedule(Alarm* ALARM, u64 DELAY)
+{
+  ALARM->delay        = DELAY;
+  ALARM->firedAt      = 0;
+  ALARM->scheduledAt  = monotonicNanoseconds();
+  threadPoolTaskSchedule(&ALARM->timer, ring, ALARM, DELAY);
+}
+
+// - - - how often the timer thread went to sleep, from /proc. Every wakeup of the wheel is followed by one
+static u64 timerThreadSleeps()
+{
+  u64  sleeps = 0;
+  DIR* tasks  = opendir("/proc/self/task");
+  if (!tasks) return 0;
+
+  struct dirent* entry;
+  while ((entry = readdir(tasks)) != NULL)
+  {
+    if (entry->d_name[0] == '.') continue;
+
+    char path[300];
+    char line[256] = { 0 };
+    snprintf(path, sizeof(path), "/proc/self/task/%s/comm", entry->d_name);
+    FILE* file = fopen(path, "r");
+    if (!file) continue;
+    bool timer = fgets(line, sizeof(line), file) && strstr(line, "-timer");
+    fclose(file);
+    if (!timer) continue;
+
+    snprintf(path, sizeof(path), "/proc/self/task/%s/status", entry->d_name);
+    file = fopen(path, "r");
+    if (!file) continue;
+    while (fgets(line, sizeof(line), file)) sscanf(line, "voluntary_ctxt_switches: %llu", &sleeps);
+    fclose(file);
+  }
+  closedir(tasks);
+  return sleeps;
+}
+
+// - - - polls for up to 5 s
+static bool waitForCounter(u64 COUNT)
+{
+  for (int i = 0; i < 5000 && __atomic_load_n(&counter, __ATOMIC_ACQUIRE) < COUNT; ++i) usleep(1000);
+  return __atomic_load_n(&counter, __ATOMIC_ACQUIRE) >= COUNT;
+}
+
+u8 testTimers()
+{
+  expectToBeTrue(threadPoolInit(2));
+
+  // - - - never early, and in order
+  static Alarm alarms[TIMER_COUNT];
+  memset(alarms, 0, sizeof(alarms));
+  counter = 0;
+  early   = 0;
+  alarmSchedule(&alarms[0], 20000000);
+  alarmSchedule(&alarms[1], 5000000);
+  alarmSchedule(&alarms[2], 0);
+  expectToBeTrue(waitForCounter(3));
+  threadPoolWaitToFinish();
+  expectShouldBe(0, early);
+  u64 first  = __atomic_load_n(&alarms[2].firedAt, __ATOMIC_ACQUIRE);
+  u64 second = __atomic_load_n(&alarms[1].firedAt, __ATOMIC_ACQUIRE);
+  u64 third  = __atomic_load_n(&alarms[0].firedAt, __ATOMIC_ACQUIRE);
+  expectToBeTrue((first <= second && second <= third));
+
+  // - - - a cancelled timer never fires and cancelling twice says so
+  counter = 0;
+  alarmSchedule(&alarms[0], 30000000);
+  expectToBeTrue(threadPoolCancelTimer(&alarms[0].timer));
+  expectToBeFalse(threadPoolCancelTimer(&alarms[0].timer));
+  usleep(60000);
+  threadPoolWaitToFinish();
+  expectShouldBe(0, counter);
+
+  // - - - periodic until cancelled, then silent
+  counter = 0;
+  alarms[0].scheduledAt = monotonicNanoseconds();
+  alarms[0].delay       = 0;
+  threadPoolTaskSchedulePeriodic(&alarms[0].timer, ring, &alarms[0], 0, 2000000);
+  expectToBeTrue(waitForCounter(5));
+  expectToBeTrue(threadPoolCancelTimer(&alarms[0].timer));
+  threadPoolWaitToFinish();
+  u64 fired = counter;
+  usleep(20000);
+  expectShouldBe(fired, counter);
+
+  // - - - a lot of them spread over the lower levels, pouring down across the 64 ms boundaries
+  counter = 0;
+  u64 seed = 12345;
+  for (int i = 0; i < TIMER_COUNT; ++i)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    alarmSchedule(&alarms[i], (seed >> 33) % 300000000);
+  }
+  expectToBeTrue(waitForCounter(TIMER_COUNT));
+  threadPoolWaitToFinish();
+  expectShouldBe(TIMER_COUNT, counter);
+  expectShouldBe(0, early);
+
+  // - - - a timer waiting on level 1 pours down at the next 64 ms boundary, even when level 0 already holds a later
+  // - - - deadline the wheel could sleep until. Starts right after a boundary so the pour lands between them, the
+  // - - - short timer wakes the wheel so the later one is placed on level 0 from an up to date tick
+  counter = 0;
+  while ((monotonicNanoseconds() / 1000000) % 64 != 0) usleep(200);
+  alarmSchedule(&alarms[0], 66000000);
+  usleep(50000);
+  alarmSchedule(&alarms[2], 5000000);
+  usleep(2000);
+  alarmSchedule(&alarms[1], 50000000);
+  expectToBeTrue(waitForCounter(3));
+  threadPoolWaitToFinish();
+  expectShouldBe(0, early);
+  expectToBeTrue((alarms[0].firedAt < alarms[1].firedAt));
+  expectToBeTrue((alarms[0].firedAt - alarms[0].scheduledAt - alarms[0].delay < 20000000));
+
+  // - - - a distant timer waits on a high level, the wheel sleeps until its pour instead of waking every 64 ms
+  alarmSchedule(&alarms[0], 10000000000ULL);
+  usleep(10000);
+  u64 sleeps = timerThreadSleeps();
+  usleep(500000);
+  expectToBeTrue((timerThreadSleeps() - sleeps <= 2));
+
+  // - - - pending timers are dropped with the pool
+  threadPoolDestroy();
+  expectToBeFalse(alarms[0].timer.pending);
+  return true;
+}
+
+u8 testPinnedPool()
+{
+  u32 cpus[] = { 0 };
+  ThreadPoolConfig listConfig = { 2, 0, "pinned", THREAD_POOL_PIN_LIST, cpus, 1 };
+  ThreadPool       pool;
+  expectToBeTrue(createThreadPool(&pool, &listConfig));
+  expectShouldBe(0, pool.threads[0]->cpu);
+  expectShouldBe(0, pool.threads[1]->cpu);
+
+  wrongCpu = 0;
+  for (int i = 0; i < 100; ++i) threadPoolPush(&pool, checkCpu, (void*)0);
+  threadPoolWait(&pool);
+  expectShouldBe(0, wrongCpu);
+  destroyThreadPool(&pool);
+
+  // - - - compact and scatter hand out every usable cpu before reusing one
+  ThreadPoolPinning policies[] = { THREAD_POOL_PIN_COMPACT, THREAD_POOL_PIN_SCATTER };
+  for (int p = 0; p < 2; ++p)
+  {
+    ThreadPoolConfig config = { 0, 0, "pinned", policies[p], NULL, 0 };
+    expectToBeTrue(createThreadPool(&pool, &config));
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    for (int i = 0; i < pool.numThreadsAlive && i < CPU_COUNT(&allowed); ++i)
+    {
+      expectToBeTrue((pool.threads[i]->cpu >= 0));
+      for (int j = 0; j < i; ++j) expectShouldNotBe(pool.threads[j]->cpu, pool.threads[i]->cpu);
+    }
+    for (int i = 0; i < 100; ++i) threadPoolPush(&pool, increment, NULL);
+    threadPoolWait(&pool);
+    destroyThreadPool(&pool);
+  }
+  return true;
+}
+
+#define LANE_TASKS 100
+
+static volatile u64 runOrder = 0;
+static u64          ranAt[3][LANE_TASKS];
+
+static void recordLane(void* ARG)
+{
+  u64 lane  = (u64)ARG / LANE_TASKS;
+  u64 index = (u64)ARG % LANE_TASKS;
+  ranAt[lane][index] = __atomic_fetch_add(&runOrder, 1, __ATOMIC_RELAXED);
+}
+
+static u64 lastRun(u64 LANE)
+{
+  u64 last = 0;
+  for (int i = 0; i < LANE_TASKS; ++i) if (ranAt[LANE][i] > last) last = ranAt[LANE][i];
+  return last;
+}
+
+u8 testPriorityLanes()
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { 1, 0, "lanes" };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  // - - - the only thread is stuck, everything below queues up
+  released = false;
+  threadPoolPush(&pool, blockUntilReleased, NULL);
+  while (__atomic_load_n(&pool.numThreadsWorking, __ATOMIC_ACQUIRE) == 0) sched_yield();
+
+  runOrder = 0;
+  for (u64 i = 0; i < LANE_TASKS; ++i) threadPoolPushPriority(&pool, recordLane, (void*)(TASK_PRIORITY_BACKGROUND * LANE_TASKS + i), TASK_PRIORITY_BACKGROUND);
+  for (u64 i = 0; i < LANE_TASKS; ++i) threadPoolPushPriority(&pool, recordLane, (void*)(TASK_PRIORITY_NORMAL     * LANE_TASKS + i), TASK_PRIORITY_NORMAL);
+  for (u64 i = 0; i < LANE_TASKS; ++i) threadPoolPushPriority(&pool, recordLane, (void*)(TASK_PRIORITY_HIGH       * LANE_TASKS + i), TASK_PRIORITY_HIGH);
+
+  __atomic_store_n(&released, true, __ATOMIC_RELEASE);
+  threadPoolWait(&pool);
+  expectShouldBe(3 * LANE_TASKS, runOrder);
+
+  // - - - high first and FIFO inside a lane, background last
+  expectShouldBe(0, ranAt[TASK_PRIORITY_HIGH][0]);
+  for (int i = 1; i < LANE_TASKS; ++i) expectToBeTrue((ranAt[TASK_PRIORITY_HIGH][i] > ranAt[TASK_PRIORITY_HIGH][i - 1]));
+  expectToBeTrue((lastRun(TASK_PRIORITY_HIGH) < lastRun(TASK_PRIORITY_NORMAL)));
+  expectToBeTrue((lastRun(TASK_PRIORITY_NORMAL) < lastRun(TASK_PRIORITY_BACKGROUND)));
+
+  // - - - but the lower lanes got a turn while high work was still queued
+  expectToBeTrue((ranAt[TASK_PRIORITY_NORMAL][0]     < lastRun(TASK_PRIORITY_HIGH)));
+  expectToBeTrue((ranAt[TASK_PRIORITY_BACKGROUND][0] < lastRun(TASK_PRIORITY_HIGH)));
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+#define SPAWN_LIMIT 100000
+
+static volatile bool backgroundRan = false;
+static volatile u64  generations   = 0;
+
+// - - - every generation pushes the next from inside the pool, the thread's deque is never empty
+static void spawnUntilBackground(void* ARG)
+{
+  if (__atomic_load_n(&backgroundRan, __ATOMIC_ACQUIRE)) return;
+  if (__atomic_add_fetch(&generations, 1, __ATOMIC_RELAXED) < SPAWN_LIMIT) threadPoolPush((ThreadPool*)ARG, spawnUntilBackground, ARG);
+}
+
+static void markBackground(void* ARG)
+{
+  __atomic_store_n(&backgroundRan, true, __ATOMIC_RELEASE);
+}
+
+u8 testLocalWorkYields()
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { 1, 0, "spawner" };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  // - - - the only thread is busy with local normal work before the background task is queued
+  backgroundRan = false;
+  generations   = 0;
+  threadPoolPush(&pool, spawnUntilBackground, &pool);
+  while (__atomic_load_n(&generations, __ATOMIC_ACQUIRE) < 10) sched_yield();
+  threadPoolPushPriority(&pool, markBackground, NULL, TASK_PRIORITY_BACKGROUND);
+  threadPoolWait(&pool);
+
+  // - - - the background task stopped the chain, not the limit
+  expectToBeTrue(backgroundRan);
+  expectToBeTrue((generations < SPAWN_LIMIT));
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+static void sleepBriefly(void* ARG)
+{
+  usleep(100);
+}
+
+u8 testTelemetry()
+{
+  ThreadPool       pool;
+  ThreadPoolConfig config = { 2, 0, "stats", THREAD_POOL_PIN_NONE, NULL, 0, true };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  for (int i = 0; i < 200; ++i) threadPoolPush(&pool, sleepBriefly, NULL);
+  for (int i = 0; i < 10;  ++i) threadPoolPush(&pool, fanOutIn, &pool);
+  threadPoolWait(&pool);
+
+  ThreadPoolStats stats = threadPoolStatsSnapshot(&pool);
+  expectShouldBe(2,                       stats.threadCount);
+  expectShouldBe(210 + 10 * FAN_OUT,      stats.workers.tasksExecuted);
+  expectShouldBe(210 + 10 * FAN_OUT,      stats.workers.runTime.total);
+  expectShouldBe(210 + 10 * FAN_OUT,      stats.workers.queueWait.total);
+  expectToBeTrue((stats.queueDepthHighWater         > 0));
+  expectToBeTrue((stats.workers.queueDepthHighWater > 0));
+
+  // - - - the slowest tasks sleep for 100us, the histogram is within 25% of that
+  u64 p99 = threadPoolHistogramPercentile(&stats.workers.runTime, 99.0);
+  expectToBeTrue((p99 >= 75000));
+  expectToBeTrue((stats.workers.runTime.max >= 100000));
+
+  ThreadPoolWorkerStats first  = threadPoolWorkerStatsSnapshot(&pool, 0);
+  ThreadPoolWorkerStats second = threadPoolWorkerStatsSnapshot(&pool, 1);
+  expectShouldBe(stats.workers.tasksExecuted, first.tasksExecuted + second.tasksExecuted);
+
+  threadPoolStatsReset(&pool);
+  stats = threadPoolStatsSnapshot(&pool);
+  expectShouldBe(0, stats.workers.tasksExecuted);
+  expectShouldBe(0, stats.workers.runTime.total);
+  expectShouldBe(0, threadPoolHistogramPercentile(&stats.workers.runTime, 50.0));
+
+  for (int i = 0; i < 10; ++i) threadPoolPush(&pool, increment, NULL);
+  threadPoolWait(&pool);
+  stats = threadPoolStatsSnapshot(&pool);
+  expectShouldBe(10, stats.workers.tasksExecuted);
+  expectShouldBe(10, stats.workers.queueWait.total);
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+static void* square(void* ARG)
+{
+  u64 value = (u64)ARG;
+  return (void*)(value * value);
+}
+
+static TaskFuture  diamond[4];
+static void*       sumOfParents(void* ARG)
+{
+  // - - - runs after both parents, their results are ready
+  return (void*)((u64)diamond[1].result + (u64)diamond[2].result);
+}
+
+static void* waitInside(void* ARG)
+{
+  // - - - waiting from a pool thread runs other tasks instead of blocking the thread
+  TaskFuture inner;
+  createTaskFuture(&inner, (ThreadPool*)ARG, square, (void*)7);
+  taskFutureSubmit(&inner);
+  void* result = taskFutureWait(&inner);
+  destroyTaskFuture(&inner);
+  return result;
+}
+
+u8 testFutures()
+{
+  ThreadPool pool;
+  ThreadPoolConfig config = { 1, 0, "future" };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  // - - - A -> B, A -> C, (B, C) -> D
+  createTaskFuture(&diamond[0], &pool, square,       (void*)2);
+  createTaskFuture(&diamond[1], &pool, square,       (void*)3);
+  createTaskFuture(&diamond[2], &pool, square,       (void*)4);
+  createTaskFuture(&diamond[3], &pool, sumOfParents, NULL);
+  taskFutureAddDependency(&diamond[1], &diamond[0]);
+  taskFutureAddDependency(&diamond[2], &diamond[0]);
+  taskFutureAddDependency(&diamond[3], &diamond[1]);
+  taskFutureAddDependency(&diamond[3], &diamond[2]);
+
+  // - - - submit backwards, nothing may start before its dependencies
+  for (int i = 3; i >= 0; --i) taskFutureSubmit(&diamond[i]);
+  expectShouldBe(25, (u64)taskFutureWait(&diamond[3]));
+  expectToBeTrue(taskFutureIsDone(&diamond[0]));
+  for (int i = 0; i < 4; ++i) destroyTaskFuture(&diamond[i]);
+
+  // - - - a single thread waiting on a future it has to run itself
+  TaskFuture outer;
+  createTaskFuture(&outer, &pool, waitInside, &pool);
+  taskFutureSubmit(&outer);
+  expectShouldBe(49, (u64)taskFutureWait(&outer));
+  destroyTaskFuture(&outer);
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+static volatile bool spinning = false;
+static volatile bool stoppedEarly = false;
+
+static void spinUntilCancelled(void* ARG)
+{
+  // - - - cooperative, the task notices on its own that its group was cancelled
+  __atomic_store_n(&spinning, true, __ATOMIC_RELEASE);
+  TaskGroup* group = taskGroupCurrent();
+  while (!taskGroupIsCancelled(group)) usleep(100);
+  __atomic_store_n(&stoppedEarly, true, __ATOMIC_RELEASE);
+}
+
+u8 testTaskGroups()
+{
+  ThreadPool pool;
+  ThreadPoolConfig config = { 1, 0, "group" };
+  expectToBeTrue(createThreadPool(&pool, &config));
+
+  // - - - the only thread is held by one group, waiting on another runs its tasks on the waiter
+  TaskGroup blocked, other;
+  createTaskGroup(&blocked, &pool);
+  createTaskGroup(&other,   &pool);
+  released = false;
+  computed = 0;
+  taskGroupPush(&blocked, blockUntilReleased, NULL);
+  for (int i = 0; i < TASK_COUNT; ++i) taskGroupPush(&other, compute, NULL);
+  taskGroupWait(&other);
+  expectShouldBe(TASK_COUNT, computed);
+  expectToBeTrue((taskGroupCurrent() == NULL));
+
+  __atomic_store_n(&released, true, __ATOMIC_RELEASE);
+  taskGroupWait(&blocked);
+  destroyTaskGroup(&blocked);
+  destroyTaskGroup(&other);
+
+  // - - - cancel drops what has not started and stops the running task
+  TaskGroup cancelled;
+  createTaskGroup(&cancelled, &pool);
+  counter = 0;
+  taskGroupPush(&cancelled, spinUntilCancelled, NULL);
+  while (!__atomic_load_n(&spinning, __ATOMIC_ACQUIRE)) usleep(100);
+  for (int i = 0; i < TASK_COUNT; ++i) taskGroupPush(&cancelled, increment, NULL);
+  taskGroupCancel(&cancelled);
+  taskGroupPush(&cancelled, increment, NULL);
+  taskGroupWait(&cancelled);
+  expectToBeTrue(__atomic_load_n(&stoppedEarly, __ATOMIC_ACQUIRE));
+  expectToBeTrue(taskGroupIsCancelled(&cancelled));
+  expectShouldBe(0, counter);
+  destroyTaskGroup(&cancelled);
+
+  // - - - the pool still holds tokens of the dropped tasks, they must find nothing to run
+  threadPoolWait(&pool);
+  expectShouldBe(0, counter);
+
+  destroyThreadPool(&pool);
+  return true;
+}
+
+#define RANGE_SIZE 100000
+
+static u8 visits[RANGE_SIZE];
+
+static void visit(u64 BEGIN, u64 END, void* CONTEXT)
+{
+  for (u64 i = BEGIN; i < END; ++i) __atomic_add_fetch(&visits[i], 1, __ATOMIC_RELAXED);
+}
+
+static void visitNested(u64 BEGIN, u64 END, void* CONTEXT)
+{
+  // - - - a parallel loop inside a parallel loop, on the workers
+  for (u64 i = BEGIN; i < END; ++i) parallelFor(i * 100, i * 100 + 100, 8, visit, NULL);
+}
+
+typedef struct Span
+{
+  u64 first;
+  u64 last;
+  u64 sum;
+  u64 ordered;
+} Span;
+
+static void spanReduce(u64 BEGIN, u64 END, void* CONTEXT, void* PARTIAL)
+{
+  Span* span = (Span*)PARTIAL;
+  for (u64 i = BEGIN; i < END; ++i)
+  {
+    if (span->last != (u64)-1 && span->last + 1 != i) span->ordered = false;
+    if (span->first == (u64)-1) span->first = i;
+    span->last  = i;
+    span->sum  += i;
+  }
+}
+
+static void spanCombine(void* INTO, const void* FROM, void* CONTEXT)
+{
+  // - - - not commutative, only correct when the left span comes first
+  Span*       into = (Span*)INTO;
+  const Span* from = (const Span*)FROM;
+  if (from->first == (u64)-1) return;
+  if (into->first == (u64)-1) { *into = *from; return; }
+
+  into->ordered = into->ordered && from->ordered && into->last + 1 == from->first;
+  into->last    = from->last;
+  into->sum    += from->sum;
+}
+
+u8 testParallelLoops()
+{
+  expectToBeTrue(threadPoolInit(4));
+
+  memset(visits, 0, sizeof(visits));
+  parallelFor(0, RANGE_SIZE, 0, visit, NULL);
+  for (u64 i = 0; i < RANGE_SIZE; ++i) expectShouldBe(1, visits[i]);
+
+  memset(visits, 0, sizeof(visits));
+  parallelFor(0, RANGE_SIZE / 100, 1, visitNested, NULL);
+  for (u64 i = 0; i < RANGE_SIZE; ++i) expectShouldBe(1, visits[i]);
+
+  Span identity = { (u64)-1, (u64)-1, 0, true };
+  Span total;
+  parallelReduce(0, RANGE_SIZE, 16, &total, &identity, sizeof(Span), spanReduce, spanCombine, NULL);
+  expectShouldBe(0,                                       total.first);
+  expectShouldBe(RANGE_SIZE - 1,                          total.last);
+  expectShouldBe((u64)RANGE_SIZE * (RANGE_SIZE - 1) / 2,  total.sum);
+  expectToBeTrue(total.ordered);
+
+  // - - - empty range leaves the identity
+  parallelReduce(5, 5, 0, &total, &identity, sizeof(Span), spanReduce, spanCombine, NULL);
+  expectShouldBe(0, total.sum);
+
+  threadPoolDestroy();
+  return true;
+}
+
+u8 testReinit()
+{
+  for (int round = 0; round < 8; ++round)
+  {
+    expectToBeTrue(threadPoolInit(0));
+
+    counter = 0;
+    for (int i = 0; i < 1000; ++i) threadPoolTaskPush(increment, NULL);
+    threadPoolWaitToFinish();
+    expectShouldBe(1000, counter);
+
+    threadPoolDestroy();
+  }
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  registerTest(testSemaphore,     "Semaphore counts past 255 and wakes waiting threads");
+  registerTest(testAllTasksRun,   "Thread pool runs every pushed task");
+  registerTest(testNestedPush,    "Thread pool runs tasks pushed from inside tasks");
+  registerTest(testIntrusivePush, "Thread pool runs tasks embedded in the caller's structs");
+  registerTest(testBatchPush,     "Thread pool runs every task of a batch");
+  registerTest(testIsolatedPools, "Thread pools do not block each other");
+  registerTest(testElasticPool,   "Elastic pools grow under blocked tasks and shrink when idle");
+  registerTest(testTimers,        "Timers fire after their delay, repeat, and cancel");
+  registerTest(testPinnedPool,    "Pinned pools run their threads on the chosen cpus");
+  registerTest(testPriorityLanes, "Higher lanes run first without starving the lower ones");
+  registerTest(testLocalWorkYields, "Tasks spawning more local work do not starve the shared queue");
+  registerTest(testTelemetry,     "Telemetry counts tasks and times them per thread");
+  registerTest(testFutures,       "Futures run after their dependencies and return results");
+  registerTest(testTaskGroups,    "Task groups wait and cancel apart from the rest of the pool");
+  registerTest(testParallelLoops, "Parallel loops visit every index once and reduce in order");
+  registerTest(testReinit,        "Thread pool can be destroyed and created again");
+  runTests();
+}